@@ -17,13 +17,24 @@
 #define SCALATRIX_HPP
 
 #include "scalatrix/affine_transform.hpp"
+#include "scalatrix/rational.hpp"
 #include "scalatrix/lattice.hpp"
 #include "scalatrix/node.hpp"
 #include "scalatrix/scale.hpp"
 #include "scalatrix/params.hpp"
 #include "scalatrix/mos.hpp"
 #include "scalatrix/pitchset.hpp"
+#include "scalatrix/pitchset_index.hpp"
+#include "scalatrix/parallel.hpp"
+#include "scalatrix/et_table.hpp"
+#include "scalatrix/scale_arrays.hpp"
+#include "scalatrix/tuning_table.hpp"
+#include "scalatrix/primes.hpp"
+#include "scalatrix/ji.hpp"
 #include "scalatrix/label_calculator.hpp"
+#include "scalatrix/comma_search.hpp"
+#include "scalatrix/lattice3.hpp"
+#include "scalatrix/scale3.hpp"
 
 
 #endif // SCALATRIX_HPP
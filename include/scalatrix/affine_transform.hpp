@@ -1,13 +1,15 @@
 #ifndef SCALATRIX_AFFINE_TRANSFORM_HPP
 #define SCALATRIX_AFFINE_TRANSFORM_HPP
 
+#include <cassert>
+#include <cstddef>
 #include <utility>
 
 namespace scalatrix {
 
 struct Vector2i {
     int x, y;
-    Vector2i(int x_ = 0, int y_ = 0) noexcept : x(x_), y(y_) {}
+    constexpr Vector2i(int x_ = 0, int y_ = 0) noexcept : x(x_), y(y_) {}
     Vector2i operator-(){ return {-x, -y}; }
     void operator+=(const Vector2i& v) { x += v.x; y += v.y; }
     void operator-=(const Vector2i& v) { x -= v.x; y -= v.y; }
@@ -29,17 +31,36 @@ public:
     int a, b, c, d;  // 2x2 matrix
     int tx, ty;      // Offset vector
 
-    IntegerAffineTransform(int a_ = 1, int b_ = 0, int c_ = 0, int d_ = 1,
-                          int tx_ = 0, int ty_ = 0);
+    constexpr IntegerAffineTransform(int a_ = 1, int b_ = 0, int c_ = 0, int d_ = 1,
+                                     int tx_ = 0, int ty_ = 0)
+        : a(a_), b(b_), c(c_), d(d_), tx(tx_), ty(ty_) {}
     IntegerAffineTransform operator*(int s) const;
     Vector2i operator*(const Vector2i& v) const;
     IntegerAffineTransform inverse() const;  // May need special handling if not invertible
     Vector2i apply(const Vector2i& v) const;
     IntegerAffineTransform applyAffine(const IntegerAffineTransform& M) const;
 
-    static IntegerAffineTransform& linearFromTwoDots(
+    /**
+     * Linear transform mapping a1 to b1 and a2 to b2, with integer entries when the images
+     * are integer combinations of a1 and a2. Returns by value and has no state, so it can be
+     * called from any thread and evaluated at compile time.
+     */
+    static constexpr IntegerAffineTransform linearFromTwoDots(
         const Vector2i& a1, const Vector2i& a2,
-        const Vector2i& b1, const Vector2i& b2);
+        const Vector2i& b1, const Vector2i& b2) {
+        int det = a1.x * a2.y - a1.y * a2.x;
+        // a1 and a2 must not be collinear
+        assert(det != 0);
+        // b1 and b2 must not be collinear
+        assert(b1.x * b2.y - b1.y * b2.x != 0);
+        return {(b1.x * a2.y - b2.x * a1.y) / det, (a1.x * b2.x - b1.x * a2.x) / det,
+                (b1.y * a2.y - a1.y * b2.y) / det, (a1.x * b2.y - a2.x * b1.y) / det, 0, 0};
+    }
+
+    // Batch version for one source pair and n target pairs, out[i] maps a1 to b1[i] and a2 to b2[i]
+    static void linearFromTwoDots(const Vector2i& a1, const Vector2i& a2,
+                                  const Vector2i* b1, const Vector2i* b2, size_t n,
+                                  IntegerAffineTransform* out);
 
 };
 
@@ -72,6 +93,9 @@ public:
     AffineTransform inverse() const;
     Vector2d apply(const Vector2d& v) const;
     //Vector2d applyInt(const Vector2i& v) const;
+    // Batch versions, out[i] = apply(v[i]); out may alias v for doubles
+    void apply(const Vector2d* v, size_t n, Vector2d* out) const;
+    void apply(const Vector2i* v, size_t n, Vector2d* out) const;
     AffineTransform applyAffine(const AffineTransform& M) const;
 };
 
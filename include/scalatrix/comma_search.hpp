@@ -0,0 +1,62 @@
+#ifndef SCALATRIX_COMMA_SEARCH_HPP
+#define SCALATRIX_COMMA_SEARCH_HPP
+
+#include "scalatrix/affine_transform.hpp"
+#include "scalatrix/lattice.hpp"
+#include "scalatrix/mos.hpp"
+#include <vector>
+
+namespace scalatrix {
+
+/**
+ * A lattice vector whose tuning lies close to unison or to a multiple of the equave.
+ */
+struct CommaVector {
+    Vector2i v;       // interval in natural coordinates
+    int equaves;      // nearest multiple of the equave (0 for near-unisons)
+    double cents;     // tuning of v minus equaves * equave, in cents
+    double norm;      // length of v under the search metric
+};
+
+/**
+ * Finds all lattice vectors v with metric norm <= max_norm whose tuning under the
+ * linear part of A lies within tolerance_cents of k * equave for some integer k.
+ *
+ * The search enumerates coefficients over a Lagrange-Gauss reduced basis, row by row,
+ * and only visits the coefficients whose pitch can fall into a tolerance window, so the
+ * cost grows with the number of rows and matches rather than with the enclosed area.
+ *
+ * Only one vector of each pair +-v is returned: the one with equaves > 0, or for
+ * near-unisons the one tuned upwards. Results are sorted by norm, then by |cents|.
+ *
+ * @param include_equave_multiples If false, only near-unisons (k = 0) are returned
+ */
+std::vector<CommaVector> findCommas(const AffineTransform& A, double equave,
+                                    double tolerance_cents, double max_norm,
+                                    const LatticeMetric& metric = LatticeMetric(),
+                                    bool include_equave_multiples = true);
+
+// Same as above, using mos.impliedAffine and mos.equave
+std::vector<CommaVector> findCommas(const MOS& mos, double tolerance_cents, double max_norm,
+                                    const LatticeMetric& metric = LatticeMetric(),
+                                    bool include_equave_multiples = true);
+
+/**
+ * Multi-threaded variant of findCommas for large norm bounds. The rows of the
+ * enumeration are distributed over n_threads (0 = all cores); the result is identical
+ * to findCommas.
+ */
+std::vector<CommaVector> findCommasParallel(const AffineTransform& A, double equave,
+                                            double tolerance_cents, double max_norm,
+                                            const LatticeMetric& metric = LatticeMetric(),
+                                            bool include_equave_multiples = true,
+                                            unsigned n_threads = 0);
+
+std::vector<CommaVector> findCommasParallel(const MOS& mos, double tolerance_cents, double max_norm,
+                                            const LatticeMetric& metric = LatticeMetric(),
+                                            bool include_equave_multiples = true,
+                                            unsigned n_threads = 0);
+
+} // namespace scalatrix
+
+#endif // SCALATRIX_COMMA_SEARCH_HPP
@@ -0,0 +1,54 @@
+#ifndef SCALATRIX_ET_TABLE_HPP
+#define SCALATRIX_ET_TABLE_HPP
+
+#include "scalatrix/pitchset.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace scalatrix {
+
+/**
+ * How a range of equal temperaments approximates a set of target pitches.
+ *
+ * Row r describes the ET with min_et + r steps per equave. Matrices are dense and
+ * row-major: entry (r, t) of a per-target matrix is at r * n_targets + t, entry (r, p)
+ * of patent_vals at r * n_primes + p.
+ */
+struct ETComparisonTable {
+    unsigned int min_et = 0, max_et = 0;
+    size_t n_targets = 0, n_primes = 0;
+    double equave_log2fr = 1.0;
+
+    std::vector<int> best_steps;       // nearest step to each target
+    std::vector<double> errors;        // best step minus target, in log2fr
+    std::vector<int> patent_vals;      // nearest step to each prime
+    std::vector<int> mapped_steps;     // target mapped through the patent val, best step if it has no monzo
+    std::vector<double> max_errors;    // per ET, largest |error| over the targets
+    std::vector<double> rms_errors;    // per ET, root mean square error over the targets
+
+    size_t rows() const { return max_et >= min_et ? max_et - min_et + 1 : 0; }
+    int bestStep(unsigned int et, size_t target) const { return best_steps[(et - min_et) * n_targets + target]; }
+    double error(unsigned int et, size_t target) const { return errors[(et - min_et) * n_targets + target]; }
+    int mappedStep(unsigned int et, size_t target) const { return mapped_steps[(et - min_et) * n_targets + target]; }
+    // The patent val maps the target to its nearest step
+    bool consistent(unsigned int et, size_t target) const { return mappedStep(et, target) == bestStep(et, target); }
+};
+
+/**
+ * Compares every ET from min_et to max_et steps per equave against the targets, without
+ * generating the ET pitch sets: the nearest step to a target is round(target * n / equave).
+ *
+ * Targets with a ratio value (see PitchSetPitch) that factors over primes are also mapped
+ * through the patent val of each ET, the sum of the nearest steps of their prime factors.
+ * Rows are filled in parallel.
+ *
+ * @param primes Prime list for the patent vals, may be empty
+ * @param n_threads Number of threads, 0 selects defaultConcurrency()
+ */
+ETComparisonTable compareETs(const PitchSet& targets, unsigned int min_et, unsigned int max_et,
+                             double equave_log2fr = 1.0, const PrimeList& primes = PrimeList(),
+                             unsigned n_threads = 0);
+
+} // namespace scalatrix
+
+#endif // SCALATRIX_ET_TABLE_HPP
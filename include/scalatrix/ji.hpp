@@ -0,0 +1,126 @@
+#ifndef SCALATRIX_JI_HPP
+#define SCALATRIX_JI_HPP
+
+#include "pitchset.hpp"
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+namespace scalatrix {
+
+/**
+ * Reduced ratio num:den with its tempered log2 frequency ratio. Generators work on
+ * JIRatio and only format "num:den" labels when converting to a PitchSet.
+ */
+struct JIRatio {
+    unsigned int num, den;
+    double log2fr;
+};
+
+/**
+ * Streaming generator for the ratios of generateJIPitchSet in increasing log2fr order.
+ *
+ * num and den are list-smooth and below max_numorden. Every denominator contributes a
+ * stream of numerators pre-sorted by tempered log2fr, and the streams are merged with a
+ * heap, so each ratio costs O(log k) for k smooth numbers, and memory is O(k) however
+ * many ratios are visited. Coprimality is a bitmask test on the prime supports, not a gcd.
+ * Equal log2fr values are ordered by den, then num.
+ */
+class JIRatioStream {
+public:
+    JIRatioStream(const PrimeList& primes, int max_numorden = 20,
+                  double min_log2fr = 0.0, double max_log2fr = 1.0);
+
+    // Writes the next ratio to out, returns false when the range is exhausted
+    bool next(JIRatio& out);
+
+private:
+    struct Cursor {
+        double log2fr;
+        unsigned int num, den;
+        uint32_t den_idx;   // index into numbers_
+        uint32_t pos;       // position in order_
+    };
+    struct CursorGreater {
+        bool operator()(const Cursor& a, const Cursor& b) const {
+            if (a.log2fr != b.log2fr) return a.log2fr > b.log2fr;
+            if (a.den != b.den) return a.den > b.den;
+            return a.num > b.num;
+        }
+    };
+
+    bool coprime(uint32_t i, uint32_t j) const;
+    bool advance(Cursor& c) const;
+
+    std::vector<unsigned int> numbers_;   // smooth numbers, ascending
+    std::vector<double> log2frs_;         // tempered log2fr of numbers_
+    std::vector<uint64_t> masks_;         // prime support bitmasks, empty if gcd is needed
+    std::vector<uint32_t> order_;         // indices into numbers_ sorted by tempered log2fr
+    std::vector<double> sorted_log2frs_;  // log2frs_ in order_
+    double min_log2fr_, max_log2fr_;
+    std::priority_queue<Cursor, std::vector<Cursor>, CursorGreater> heap_;
+};
+
+// All ratios of a JIRatioStream, in order
+std::vector<JIRatio> generateJIRatios(const PrimeList& primes, int max_numorden = 20,
+                                      double min_log2fr = 0.0, double max_log2fr = 1.0);
+
+// Formats "num:den" labels for the given ratios, preserving order
+PitchSet jiRatiosToPitchSet(const std::vector<JIRatio>& ratios);
+
+/**
+ * Harmonic complexity of a reduced ratio n/d, each with an exact integer key:
+ * TenneyHeight ranks by n * d, WeilHeight by max(n, d) and OddLimit by the larger
+ * odd part of n and d (octave equivalent, so every octave transposition in range
+ * shares the rank). Ties are ordered by n * d, then n.
+ */
+enum HarmonicComplexity {
+    TenneyHeight,
+    WeilHeight,
+    OddLimit
+};
+
+/**
+ * The k simplest list-smooth ratios with log2fr in [min_log2fr, max_log2fr], in
+ * increasing complexity.
+ *
+ * Smooth numbers are generated lazily in increasing order (SmoothSequence) and pairs
+ * are visited along a frontier: a priority queue over (i, j) index pairs for Tenney
+ * height, whole max(n, d) layers for Weil height and odd limit. The work grows with k,
+ * not with the largest numerator or denominator reached. Fewer than k ratios are returned
+ * only when numerators or denominators would exceed the unsigned int range.
+ */
+std::vector<JIRatio> generateSimplestRatios(const PrimeList& primes, size_t k,
+                                            HarmonicComplexity complexity = TenneyHeight,
+                                            double min_log2fr = 0.0, double max_log2fr = 1.0);
+
+PitchSet generateSimplestPitchSet(const PrimeList& primes, size_t k,
+                                  HarmonicComplexity complexity = TenneyHeight,
+                                  double min_log2fr = 0.0, double max_log2fr = 1.0);
+
+/**
+ * Tonality diamond over the given identities: every ratio i/j, reduced by gcd and into
+ * the octave [1, 2), sorted by log2fr and deduplicated by exact value. log2fr is tempered
+ * with the list (cofactors outside the list are tuned justly); the octave is the list's
+ * 2 if present, else exactly 1.
+ *
+ * @param include_equave Append 2:1 after the reduced ratios
+ */
+std::vector<JIRatio> generateDiamondRatios(const std::vector<unsigned int>& identities,
+                                           const PrimeList& primes, bool include_equave = true);
+PitchSet generateDiamondPitchSet(const std::vector<unsigned int>& identities,
+                                 const PrimeList& primes, bool include_equave = true);
+
+// Diamond over the odd list-smooth identities <= odd_limit, i.e. all octave-reduced ratios of that odd limit
+PitchSet generateOddLimitDiamondPitchSet(const PrimeList& primes, unsigned int odd_limit,
+                                         bool include_equave = true);
+
+// Octave-reduced harmonics i/1 (otonal) or subharmonics 1/i (utonal) of the identities
+PitchSet generateOtonalPitchSet(const std::vector<unsigned int>& identities,
+                                const PrimeList& primes, bool include_equave = true);
+PitchSet generateUtonalPitchSet(const std::vector<unsigned int>& identities,
+                                const PrimeList& primes, bool include_equave = true);
+
+} // namespace scalatrix
+
+#endif // SCALATRIX_JI_HPP
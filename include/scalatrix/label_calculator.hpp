@@ -1,7 +1,11 @@
 #ifndef SCALATRIX_LABEL_CALCULATOR_HPP
 #define SCALATRIX_LABEL_CALCULATOR_HPP
 
+#include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
 #include <cmath>
 #include <cstdio>
 #include "scalatrix/mos.hpp"
@@ -9,6 +13,80 @@
 
 namespace scalatrix {
 
+/**
+ * Caller-owned arena for batches of labels: the characters of all labels in one buffer,
+ * label i is chars[offsets[i], offsets[i + 1]). Batch calls append to it; clear() keeps
+ * the capacity, so a buffer reused every frame stops allocating once it has grown.
+ */
+struct LabelBuffer {
+    std::vector<char> chars;
+    std::vector<uint32_t> offsets{0};
+
+    void clear() {
+        chars.clear();
+        offsets.assign(1, 0);
+    }
+    size_t size() const { return offsets.size() - 1; }
+    std::string_view operator[](size_t i) const {
+        return std::string_view(chars.data() + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+};
+
+// Label formats of the batch calls, one per single-node function
+enum LabelStyle {
+    DigitLabel,                 // nodeLabelDigit
+    LetterLabel,                // nodeLabelLetter
+    LetterWithOctaveNumberLabel // nodeLabelLetterWithOctaveNumber
+};
+
+/**
+ * Precomputed node labels of one MOS structure.
+ *
+ * Without the octave number, a node label only depends on the node's step within the
+ * equave, (v.x + v.y) mod n, and on its accidental count. The table stores every
+ * "accidentals + digit" and "accidentals + letter" prefix for one equave and accidental
+ * counts within +-max_accidentals in one character buffer, so a label is an O(1) table read
+ * plus, for LetterWithOctaveNumberLabel, an appended octave number. Nodes with more
+ * accidentals are formatted directly. Results are identical to LabelCalculator.
+ *
+ * Tables are immutable and can be shared between threads.
+ */
+class LabelTable {
+public:
+    // Structure a table was built for: the large step direction decides sharps versus flats
+    struct Key {
+        int a, b, mode;
+        bool large_step_x;
+        bool operator<(const Key& other) const;
+        bool operator==(const Key& other) const;
+    };
+
+    explicit LabelTable(const MOS& mos, int max_accidentals = 4);
+
+    /**
+     * Table for the structure of mos from a process-wide cache. Retuning a MOS keeps its
+     * table; it is only rebuilt when (a, b, mode) or the large step direction change.
+     */
+    static std::shared_ptr<const LabelTable> shared(const MOS& mos);
+
+    static Key keyOf(const MOS& mos);
+    const Key& key() const { return key_; }
+
+    std::string label(Vector2i v, LabelStyle style, int middle_C_octave = 4) const;
+    void labels(const Vector2i* coords, size_t n, LabelStyle style, LabelBuffer& out,
+                int middle_C_octave = 4) const;
+
+private:
+    template <typename Out>
+    void appendLabel(Out& out, Vector2i v, LabelStyle style, int middle_C_octave) const;
+
+    Key key_;
+    int n_, n0_, a0_, b0_, max_accidentals_;
+    bool large_step_x_;
+    std::vector<char> chars_;
+    std::vector<uint32_t> offsets_; // [letters][step][accidentals + max_accidentals], then the end
+};
+
 class LabelCalculator {
 public:
     static std::string nodeLabelDigit(const MOS& mos, Vector2i v);
@@ -26,20 +104,40 @@ public:
     static std::string deviationLabel(const Node& node, double thresholdCents = 0.1, 
                                       bool compareWithTempered = false);
 
-    std::string noteLabelNormalized(MOS& mos, Vector2i v, bool override_letter_labels = false) {
-        if (mos.generator > 4.0/7 && mos.generator < 3.0/5 && mos.equave > 0.9 && mos.equave < 1.2 && !override_letter_labels)
-        {
-            Vector2i diatonic_coord = diatonic_mos.mapFromMOS (mos, v);
-            return nodeLabelLetter(diatonic_mos, diatonic_coord);
-        }
-        return nodeLabelDigit(mos, v);
-    }
+    /**
+     * Batch versions of the functions above: append one label per coordinate or node to out,
+     * byte-identical to the single-node results. Accidentals and octaves use integer
+     * arithmetic only, and accidentals are copied from a precomputed glyph run. Node labels
+     * are read from the shared LabelTable of the MOS structure.
+     */
+    static void nodeLabels(const MOS& mos, const Vector2i* coords, size_t n, LabelStyle style,
+                           LabelBuffer& out, int middle_C_octave = 4);
+    // Labels for the natural coordinates of all nodes of the scale
+    static void nodeLabels(const MOS& mos, const Scale& scale, LabelStyle style,
+                           LabelBuffer& out, int middle_C_octave = 4);
+    static void deviationLabels(const std::vector<Node>& nodes, LabelBuffer& out,
+                                double thresholdCents = 0.1, bool compareWithTempered = false);
 
-    LabelCalculator() : diatonic_mos(MOS::fromParams (5, 2, 1, 1.0, .585)) {}
+    /**
+     * Letter label relative to the diatonic reference for MOS that tune close to the
+     * diatonic scale (generator between 4/7 and 3/5, equave near an octave), digit label
+     * otherwise. Only reads shared immutable state, so it is safe to call concurrently.
+     */
+    static std::string noteLabelNormalized(const MOS& mos, Vector2i v, bool override_letter_labels = false);
+
+    // Batch version of noteLabelNormalized, appending to out
+    static void noteLabelsNormalized(const MOS& mos, const Vector2i* coords, size_t n, LabelBuffer& out,
+                                     bool override_letter_labels = false);
+
+    /**
+     * The 5L 2s diatonic MOS that noteLabelNormalized maps letter labels through, built
+     * once per process on first use and never modified.
+     */
+    static const MOS& diatonicReference();
 
 private:
-    MOS diatonic_mos;
-    
+    static bool usesDiatonicLetters(const MOS& mos, bool override_letter_labels);
+
     // Helper method to calculate accidental string
     static std::string accidentalString(const MOS& mos, Vector2i v);
 };
@@ -2,12 +2,70 @@
 #define SCALATRIX_LATTICE_HPP
 
 #include "affine_transform.hpp"
+#include "rational.hpp"
 #include <utility>
+#include <vector>
 
 namespace scalatrix {
     
 std::pair<Vector2i, Vector2i> findClosestWithinStrip(const AffineTransform& M);
 
+/**
+ * One period of the strip 0 <= y < 1 under an exact rational transform.
+ * Strip node number i (relative to the origin) is nodes[(root + i) mod n] + q * period,
+ * with q = floor((root + i) / n) and n = nodes.size().
+ */
+struct StripPeriod {
+    Vector2i period;              // primitive lattice vector with (M period).y = 0 and (M period).x > 0
+    std::vector<Vector2i> nodes;  // strip nodes with 0 <= x < (M period).x, sorted by x
+    int root;                     // index of the origin in nodes
+};
+
+/**
+ * Exact counterpart of findClosestWithinStrip for rational transforms.
+ *
+ * With rational coefficients y(v) only takes values in a discrete set and the strip is
+ * periodic, so one period is enumerated in integer arithmetic (one node per admissible
+ * y value) instead of walking with tolerance-based step selection. The origin must lie
+ * in the strip, i.e. 0 <= M.ty < 1.
+ */
+StripPeriod findStripPeriod(const RationalAffineTransform& M);
+
+/**
+ * Positive definite quadratic form q(v) = g11*x^2 + 2*g12*x*y + g22*y^2 used to
+ * measure lattice vectors. The default is the Euclidean norm in natural coordinates.
+ */
+struct LatticeMetric {
+    double g11, g12, g22;
+    LatticeMetric(double g11_ = 1.0, double g12_ = 0.0, double g22_ = 1.0) noexcept
+        : g11(g11_), g12(g12_), g22(g22_) {}
+
+    double dot(const Vector2i& u, const Vector2i& v) const {
+        return g11 * u.x * v.x + g12 * (u.x * v.y + u.y * v.x) + g22 * u.y * v.y;
+    }
+    double norm2(const Vector2i& v) const { return dot(v, v); }
+
+    // Euclidean length of the image under the linear part of A (tuning space geometry)
+    static LatticeMetric fromAffine(const AffineTransform& A) {
+        return {A.a * A.a + A.c * A.c, A.a * A.b + A.c * A.d, A.b * A.b + A.d * A.d};
+    }
+};
+
+/**
+ * Lagrange-Gauss reduction of the lattice basis (b1, b2) under the given metric.
+ * Returns a basis of the same lattice with q(r1) <= q(r2) and |<r1,r2>| <= q(r1)/2,
+ * i.e. r1 is a shortest nonzero vector and r2 is shortest independent of r1.
+ */
+std::pair<Vector2i, Vector2i> reduceBasis(Vector2i b1, Vector2i b2, const LatticeMetric& metric = LatticeMetric());
+
+/**
+ * Hermite normal form of the sublattice spanned by u1 and u2 (which must be independent).
+ * Returns the unique basis h1 = (A, 0), h2 = (B, C) with A > 0, C > 0 and 0 <= B < A.
+ * The A * C = |det(u1, u2)| points (x, y) with 0 <= x < A, 0 <= y < C form a complete
+ * set of residues of Z^2 modulo the sublattice.
+ */
+std::pair<Vector2i, Vector2i> hermiteBasis(const Vector2i& u1, const Vector2i& u2);
+
 } // namespace scalatrix
 
-#endif // SCALATRIX_LATTICE_HPP
\ No newline at end of file
+#endif // SCALATRIX_LATTICE_HPP
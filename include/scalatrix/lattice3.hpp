@@ -0,0 +1,84 @@
+#ifndef SCALATRIX_LATTICE3_HPP
+#define SCALATRIX_LATTICE3_HPP
+
+#include <vector>
+
+namespace scalatrix {
+
+/**
+ * Rank-3 lattice support for 5-limit and 7-limit (rank-3 temperament) work.
+ *
+ * A scale is a path on the 3D lattice: after a 3D affine transform, the lattice
+ * nodes inside the prism 0 <= y < 1, 0 <= z < 1 are ordered by x (pitch). This is
+ * the intersection of two planar slabs; a single slab would contain infinitely many
+ * nodes per pitch interval.
+ */
+
+struct Vector3i {
+    int x, y, z;
+    Vector3i(int x_ = 0, int y_ = 0, int z_ = 0) noexcept : x(x_), y(y_), z(z_) {}
+    Vector3i operator-() const { return {-x, -y, -z}; }
+    void operator+=(const Vector3i& v) { x += v.x; y += v.y; z += v.z; }
+    void operator-=(const Vector3i& v) { x -= v.x; y -= v.y; z -= v.z; }
+    Vector3i operator+(const Vector3i& v) const { return {x + v.x, y + v.y, z + v.z}; }
+    Vector3i operator-(const Vector3i& v) const { return {x - v.x, y - v.y, z - v.z}; }
+    Vector3i operator*(const int s) const { return {x * s, y * s, z * s}; }
+    bool operator<(const Vector3i& v) const {
+        return (x < v.x) || (x == v.x && (y < v.y || (y == v.y && z < v.z)));
+    }
+    bool operator==(const Vector3i& v) const { return x == v.x && y == v.y && z == v.z; }
+};
+
+inline Vector3i operator*(int s, const Vector3i& v) { return {s * v.x, s * v.y, s * v.z}; }
+
+struct Vector3d {
+    double x, y, z;
+    Vector3d(double x_ = 0.0, double y_ = 0.0, double z_ = 0.0) noexcept : x(x_), y(y_), z(z_) {}
+    Vector3d(Vector3i v) noexcept : x(v.x), y(v.y), z(v.z) {}
+    Vector3d operator-() const { return {-x, -y, -z}; }
+    Vector3d operator+(const Vector3d& v) const { return {x + v.x, y + v.y, z + v.z}; }
+    Vector3d operator-(const Vector3d& v) const { return {x - v.x, y - v.y, z - v.z}; }
+    Vector3d operator*(double s) const { return {x * s, y * s, z * s}; }
+};
+
+inline Vector3d operator*(double s, const Vector3d& v) { return {s * v.x, s * v.y, s * v.z}; }
+
+class AffineTransform3 {
+public:
+    double m[3][3];        // 3x3 matrix, row major
+    double tx, ty, tz;     // Offset vector
+
+    AffineTransform3();    // identity
+    AffineTransform3(double m00, double m01, double m02,
+                     double m10, double m11, double m12,
+                     double m20, double m21, double m22,
+                     double tx_ = 0.0, double ty_ = 0.0, double tz_ = 0.0);
+    Vector3d operator*(const Vector3d& v) const;
+    Vector3d operator*(const Vector3i& v) const;
+    AffineTransform3 operator*(const AffineTransform3& M) const;
+    AffineTransform3 inverse() const;
+    Vector3d apply(const Vector3d& v) const;
+    double det() const;
+};
+
+/**
+ * Affine transform mapping a1..a4 to b1..b4 (a1..a4 must not be coplanar).
+ * 3D counterpart of affineFromThreeDots.
+ */
+AffineTransform3 affineFromFourDots(
+    const Vector3d& a1, const Vector3d& a2, const Vector3d& a3, const Vector3d& a4,
+    const Vector3d& b1, const Vector3d& b2, const Vector3d& b3, const Vector3d& b4);
+
+/**
+ * Lattice vectors v with 0 < (M v).x <= max_step and |(M v).y| < 1, |(M v).z| < 1,
+ * using the linear part of M only, sorted by increasing (M v).x.
+ *
+ * Consecutive prism nodes (in x order) always differ by such a vector once max_step
+ * exceeds the largest gap, so this is the 3D analogue of the two or three step
+ * vectors of the three-gap theorem.
+ */
+std::vector<Vector3i> findStepsWithinPrism(const AffineTransform3& M, double max_step);
+
+} // namespace scalatrix
+
+#endif // SCALATRIX_LATTICE3_HPP
@@ -2,6 +2,7 @@
 #define SCALATRIX_MOS_HPP
 
 #include "scalatrix/affine_transform.hpp"
+#include "scalatrix/rational.hpp"
 #include "scalatrix/scale.hpp"
 #include "scalatrix/pitchset.hpp"
 
@@ -11,6 +12,7 @@ class MOS {
 public:
 
     MOS(int a, int b, int m, double e, double g);
+    MOS(int a, int b, int m, Rational e, Rational g);
 
     int a, b, n, a0, b0, n0, mode, nL, nS;
     int repetitions, depth;
@@ -21,6 +23,15 @@ public:
     Vector2i L_vec, s_vec, chroma_vec;
     double L_fr, s_fr, chroma_fr;
 
+    // Exact mode (fromRational): equave and generator are rationals and the strip is
+    // computed in integer arithmetic. Any floating point retune leaves exact mode, but
+    // keeps the rational parameters (has_exact_params), so retuneZeroPoint restores it
+    // when the retunes left impliedAffine at the exact tuning.
+    bool exact = false;
+    bool has_exact_params = false;
+    Rational exact_equave, exact_generator;
+    RationalAffineTransform exactAffine;
+
     std::vector<bool> path;
     AffineTransform impliedAffine;
     IntegerAffineTransform mosTransform;
@@ -30,17 +41,30 @@ public:
 
     static MOS fromParams(int a, int b, int m, double e, double g);
     //static MOS fromImpliedAffine(const AffineTransform& A, int repetitions);
+    /**
+     * MOS with exactly rational equave and generator, e.g. fromRational(5, 2, 1, 1, {7, 12})
+     * for the diatonic scale in 12-EDO. Produces the same nodes as fromParams, but without
+     * tolerance-dependent strip computation, so results are bit-identical across platforms.
+     *
+     * @param e Equave in log2(frequency ratio)
+     * @param g Generator as a fraction of the period, 0 <= g <= 1
+     */
+    static MOS fromRational(int a, int b, int m, Rational e, Rational g);
     static MOS fromG(int depth, int m, double g, double e, int repetitions = 1);
     void adjustG(int depth, int m, double g, double e, int repetitions = 1);
     void adjustParams(int a, int b, int m, double e, double g);
+    void adjustParamsRational(int a, int b, int m, Rational e, Rational g);
     //void adjustParamsFromImpliedAffine(const AffineTransform& A);
 
     double coordToFreq(double x, double y, double base_freq);
+    // Batch version of coordToFreq over count coordinates
+    void coordsToFreqs(const Vector2d* coords, size_t count, double base_freq, double* out) const;
 
     double angle() const;
     double angleStd() const;
 
     AffineTransform calcImpliedAffine() const;
+    RationalAffineTransform calcImpliedRationalAffine() const;
     void updateVectors();
 
     double gFromAngle(double angle);
@@ -51,6 +75,7 @@ public:
     std::string nodeLabelLetter(Vector2i v) const;
     std::string nodeLabelLetterWithOctaveNumber(Vector2i v, int middle_C_octave=4) const;
 
+    void _setStructure(int a, int b, int m);
     void _recalcOnRetuneUsingAffine(AffineTransform& A);
 
     void retuneZeroPoint();
@@ -61,10 +86,12 @@ public:
     Scale generateScaleFromMOS(double base_freq, int n, int root);
     void retuneScaleWithMOS(Scale& scale, double base_freq);
 
-    Vector2i mapFromMOS(MOS& other, Vector2i v);
+    Vector2i mapFromMOS(const MOS& other, Vector2i v) const;
 
     int nodeEquaveNr(Vector2i v) const {return (v.x + v.y + 256*n) / n - 256;}
     bool nodeInScale(Vector2i v) const;
+    // Batch version of nodeInScale, out[i] = nodeInScale(v[i])
+    void nodesInScale(const Vector2i* v, size_t count, bool* out) const;
 
 };
 
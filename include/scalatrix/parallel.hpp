@@ -0,0 +1,70 @@
+#ifndef SCALATRIX_PARALLEL_HPP
+#define SCALATRIX_PARALLEL_HPP
+
+#include <cstddef>
+#include <exception>
+#include <type_traits>
+
+namespace scalatrix {
+
+// Number of threads used by batch calls when no explicit count is given: the hardware
+// concurrency, capped by concurrencyLimit(). Single-threaded builds always return 1.
+unsigned defaultConcurrency();
+
+/**
+ * Caps the number of threads, including the caller, that any parallelFor uses.
+ * 0 removes the cap, 1 runs every batch call on the calling thread. Builds with
+ * SCALATRIX_SINGLE_THREADED (and WASM builds without pthreads) never start threads.
+ */
+void setConcurrencyLimit(unsigned limit);
+unsigned concurrencyLimit();
+
+namespace detail {
+
+// Type-erased range of a parallelFor: runs fn(i) for i in [lo, hi) and returns the first
+// index that threw, or hi, storing its exception in error
+using RangeFn = size_t (*)(void* fn, size_t lo, size_t hi, std::exception_ptr& error);
+
+// Runs [begin, end) on up to n_threads threads of the shared pool, rethrowing the
+// exception of the lowest failing index
+void runParallel(size_t begin, size_t end, unsigned n_threads, RangeFn range, void* fn);
+
+} // namespace detail
+
+/**
+ * Calls fn(i) for every i in [begin, end) on the shared work-stealing pool. Each
+ * participating thread starts on its own contiguous block, takes small chunks from its
+ * front and, when it runs dry, steals the back half of the largest remaining block, so
+ * uneven workloads stay balanced. The calling thread takes part, so the call makes
+ * progress even while the pool is busy with other callers.
+ *
+ * fn must only write to state owned by index i; results are then independent of the
+ * number of threads and of the scheduling. If fn throws, the exception thrown for the
+ * lowest index is rethrown once all threads are done; indices after a failing one may be
+ * skipped. Calls from inside fn run
+ * serially on the calling thread. Any thread may call parallelFor, also concurrently,
+ * e.g. Python threads with the GIL released or C API hosts.
+ *
+ * @param n_threads Number of threads to use, at most the hardware concurrency; 0 selects
+ *                  defaultConcurrency()
+ */
+template <typename F>
+void parallelFor(size_t begin, size_t end, F&& fn, unsigned n_threads = 0) {
+    if (end <= begin) return;
+    using Fn = std::remove_reference_t<F>;
+    detail::RangeFn range = [](void* f, size_t lo, size_t hi, std::exception_ptr& error) -> size_t {
+        Fn& body = *static_cast<Fn*>(f);
+        size_t i = lo;
+        try {
+            for (; i < hi; ++i) body(i);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        return i;
+    };
+    detail::runParallel(begin, end, n_threads, range, const_cast<void*>(static_cast<const void*>(&fn)));
+}
+
+} // namespace scalatrix
+
+#endif // SCALATRIX_PARALLEL_HPP
@@ -16,10 +16,42 @@ PseudoPrimeInt pseudoPrimeFromIndexNumber(unsigned int index);
 PrimeList generateDefaultPrimeList(int n_primes=8);
 
 
-typedef struct { 
+// What the num and den fields of a PitchSetPitch hold
+enum PitchValueKind {
+    UnknownPitch,  // free text label, only log2fr is meaningful
+    RatioPitch,    // reduced ratio num:den
+    EDOPitch       // num steps of an equal division into den parts, label "num\den"
+};
+
+/**
+ * A labelled pitch. Generators also store the exact value behind the label, so that
+ * arithmetic and deduplication work on integers instead of re-parsing label strings.
+ * Pitches built from a label and log2fr alone have kind UnknownPitch; operators parse
+ * their label once on use.
+ */
+struct PitchSetPitch {
     std::string label;
     double log2fr; // log2 frequency ratio
-} PitchSetPitch;
+    PitchValueKind kind = UnknownPitch;
+    long long num = 0;
+    long long den = 1;
+
+    // Reduces the ratio and formats its "num:den" label
+    static PitchSetPitch fromRatio(long long num, long long den, double log2fr);
+    // Formats the "num:den" label of a ratio already in lowest terms with a positive den
+    static PitchSetPitch fromReducedRatio(long long num, long long den, double log2fr);
+    // Formats the "steps\divisions" label
+    static PitchSetPitch fromEDOSteps(long long steps, long long divisions, double log2fr);
+    // Recovers the exact value from a "num:den" or "steps\divisions" label if it has one
+    static PitchSetPitch fromLabel(const std::string& label, double log2fr);
+
+    /**
+     * Same exact value: ratios compare num and den, equal division steps compare
+     * steps / divisions (both assumed to divide the same equave), anything else compares
+     * log2fr within 1e-9.
+     */
+    bool sameValue(const PitchSetPitch& other) const;
+};
 
 // Addition operator for PitchSetPitch
 PitchSetPitch operator+(const PitchSetPitch& a, const PitchSetPitch& b);
@@ -32,6 +64,29 @@ PitchSet generateETPitchSet(unsigned int n_et, double equave_log2fr = 1.0, doubl
 PitchSet generateJIPitchSet(PrimeList primes, int max_numtimesden = 20, double min_log2fr = 0.0, double max_log2fr = 1.0);
 PitchSet generateHarmonicSeriesPitchSet(PrimeList primes, int base, double min_log2fr = 0.0, double max_log2fr = 1.001);
 
+/**
+ * Set algebra on pitch sets sorted by log2fr; results are sorted too. Union and
+ * intersection are linear merges. Duplicates are pitches within 1e-9 of each other that
+ * hold the same value by sameValue, so a tempered comma and the unison stay distinct.
+ */
+
+// Pitches of a and b without duplicates, the copy from a kept on ties
+PitchSet pitchSetUnion(const PitchSet& a, const PitchSet& b);
+
+// Pitches of a with a pitch of b within tolerance_cents; 0 requires the same exact value
+PitchSet pitchSetIntersection(const PitchSet& a, const PitchSet& b, double tolerance_cents = 0.0);
+
+// Every pitch of the set plus interval
+PitchSet transposePitchSet(const PitchSet& pitchset, const PitchSetPitch& interval);
+
+/**
+ * Minkowski sum {x + y : x in a, y in b} with log2fr in [min_log2fr, max_log2fr],
+ * deduplicated. Each pitch of a opens a row over b, and the rows are merged with a heap,
+ * so the cost is O(|a| |b| log |a|) time but only O(|a|) extra memory.
+ */
+PitchSet stackPitchSets(const PitchSet& a, const PitchSet& b,
+                        double min_log2fr = -1e9, double max_log2fr = 1e9);
+
 
 }; // namespace scalatrix
 
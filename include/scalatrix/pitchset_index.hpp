@@ -0,0 +1,119 @@
+#ifndef SCALATRIX_PITCHSET_INDEX_HPP
+#define SCALATRIX_PITCHSET_INDEX_HPP
+
+#include "pitchset.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace scalatrix {
+
+/**
+ * Immutable search index over a PitchSet.
+ *
+ * The pitches are stored in increasing log2fr order (stable, so duplicates keep their
+ * input order) as columns: a contiguous log2fr array, keys reduced into [0, equave),
+ * the exact value columns of PitchSetPitch and a string table for the labels. All
+ * queries are O(log P) binary searches and return positions in the sorted order;
+ * pitch(i) or label(i) resolve them. Nothing is mutated after construction, so one index
+ * can be shared read-only between threads, and copies share the same storage.
+ *
+ * The columns are laid out exactly as in the binary file written by save(), so load()
+ * memory-maps a file and serves queries from it without copying or allocating per pitch.
+ *
+ * Equal distances resolve to the lower pitch.
+ */
+class PitchSetIndex {
+public:
+    explicit PitchSetIndex(const PitchSet& pitchset, double equave_log2fr = 1.0);
+
+    /**
+     * Memory-maps a file written by save(); the mapping lives as long as the index or any
+     * copy of it. Platforms without mmap read the file into memory instead.
+     * Throws std::runtime_error if the file cannot be read or is not a valid index.
+     */
+    static PitchSetIndex load(const std::string& path);
+
+    // Writes the binary image, throws std::runtime_error on failure
+    void save(const std::string& path) const;
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    double equave() const { return equave_; }
+    const double* log2frs() const { return log2frs_; }
+    double log2fr(size_t i) const { return log2frs_[i]; }
+    std::string_view label(size_t i) const {
+        return std::string_view(labels_ + label_offsets_[i], label_offsets_[i + 1] - label_offsets_[i]);
+    }
+    PitchValueKind kind(size_t i) const { return (PitchValueKind)kinds_[i]; }
+    long long num(size_t i) const { return nums_[i]; }
+    long long den(size_t i) const { return dens_[i]; }
+
+    // Pitch at position i, with its label copied into a string
+    PitchSetPitch pitch(size_t i) const;
+
+    // All pitches in sorted order
+    PitchSet toPitchSet() const;
+
+    // First position with log2fr >= value
+    size_t lowerBound(double log2fr) const;
+
+    // Position of the pitch closest to log2fr, the index must not be empty
+    size_t nearest(double log2fr) const;
+
+    // Positions of the k closest pitches, closest first
+    std::vector<size_t> kNearest(double log2fr, size_t k) const;
+
+    // Positions [first, second) of the pitches with min_log2fr <= log2fr <= max_log2fr
+    std::pair<size_t, size_t> range(double min_log2fr, double max_log2fr) const;
+
+    /**
+     * Nearest pitch under equave equivalence: the pitch whose transposition by whole
+     * equaves lands closest to log2fr.
+     *
+     * @param matched_log2fr Receives that transposition
+     * @return Position of the pitch in the sorted order
+     */
+    size_t nearestReduced(double log2fr, double& matched_log2fr) const;
+
+    /**
+     * Batch queries over n values, written to out. Blocks of queries step through the
+     * search together: every search over the same array takes the same number of
+     * branchless steps, so the inner loop over the block has no data-dependent branches
+     * and independent loads that the memory system can overlap. SIMD128 builds compare two
+     * queries per f64x2.
+     */
+    void lowerBound(const double* log2frs, size_t n, uint32_t* out) const;
+    void nearest(const double* log2frs, size_t n, uint32_t* out) const;
+
+private:
+    struct Storage;
+
+    PitchSetIndex() = default;
+    void bindColumns();
+    size_t nearestAround(size_t lb, double log2fr) const;
+
+    std::shared_ptr<const Storage> storage_;
+    size_t size_ = 0;
+    double equave_ = 1.0;
+    const double* log2frs_ = nullptr;         // sorted
+    const double* reduced_ = nullptr;         // log2frs_ reduced into [0, equave), sorted
+    const int64_t* nums_ = nullptr;
+    const int64_t* dens_ = nullptr;
+    const uint32_t* reduced_order_ = nullptr; // positions of reduced_
+    const uint32_t* label_offsets_ = nullptr; // size_ + 1 offsets into labels_
+    const uint8_t* kinds_ = nullptr;
+    const char* labels_ = nullptr;
+};
+
+// Binary PitchSet files are PitchSetIndex images; reading returns the pitches sorted by log2fr
+void writePitchSetFile(const std::string& path, const PitchSet& pitchset, double equave_log2fr = 1.0);
+PitchSet readPitchSetFile(const std::string& path);
+
+} // namespace scalatrix
+
+#endif // SCALATRIX_PITCHSET_INDEX_HPP
@@ -0,0 +1,128 @@
+#ifndef SCALATRIX_PRIMES_HPP
+#define SCALATRIX_PRIMES_HPP
+
+#include "pitchset.hpp"
+#include <memory>
+#include <vector>
+
+namespace scalatrix {
+
+/**
+ * Smallest-prime-factor table for 0..limit, built with a linear sieve in O(limit).
+ * Factorising any n <= limit then takes O(number of prime factors) divisions.
+ */
+class PrimeSieve {
+public:
+    explicit PrimeSieve(unsigned int limit);
+
+    unsigned int limit() const { return static_cast<unsigned int>(spf_.size()) - 1; }
+    // Smallest prime factor of n (2 <= n <= limit), n itself for primes
+    unsigned int smallestFactor(unsigned int n) const { return spf_[n]; }
+    bool isPrime(unsigned int n) const { return n >= 2 && spf_[n] == n; }
+    // All primes <= limit in increasing order
+    const std::vector<unsigned int>& primes() const { return primes_; }
+
+    /**
+     * Process-wide sieve covering at least 0..limit. The cached sieve is shared between
+     * calls and threads and grows by doubling, so repeated pitch set generation does not
+     * rebuild it.
+     */
+    static std::shared_ptr<const PrimeSieve> shared(unsigned int limit);
+
+    // Sieve containing at least the first n + 1 primes
+    static std::shared_ptr<const PrimeSieve> sharedWithPrimeCount(unsigned int n);
+
+private:
+    std::vector<unsigned int> spf_;
+    std::vector<unsigned int> primes_;
+};
+
+/**
+ * Integer 1 <= number <= limit whose prime factors all occur in a PrimeList, with its
+ * tempered log2 frequency ratio (sum of the list's log2fr over the factorisation).
+ */
+struct SmoothNumber {
+    unsigned int number;
+    double log2fr;
+};
+
+/**
+ * Factorisation over a PrimeList, backed by a shared PrimeSieve.
+ *
+ * Lists whose numbers are not distinct primes (pseudo-primes such as 9 standing in for
+ * a tempered 3^2) keep the original semantics of dividing by each entry in list order.
+ */
+class PrimeListFactorizer {
+public:
+    PrimeListFactorizer(const PrimeList& primes, unsigned int limit);
+
+    /**
+     * Exponents of n over the list (monzo in list order).
+     * @return false if n has a factor outside the list, monzo is then left unspecified
+     */
+    bool monzo(unsigned int n, std::vector<int>& exponents) const;
+
+    /**
+     * Tempered log2 frequency ratio of n, i.e. sum of exponent * log2fr over the list.
+     * Any cofactor outside the list is added as its exact log2 when allow_cofactor is set,
+     * otherwise the function returns false for such n.
+     */
+    bool log2fr(unsigned int n, double& result, bool allow_cofactor = false) const;
+
+    bool hasPrimeBasis() const { return prime_basis_; }
+
+    // All list-smooth numbers in [1, limit], ascending, computed in O(limit)
+    std::vector<SmoothNumber> smoothNumbers() const;
+
+private:
+    std::vector<unsigned int> numbers_;
+    std::vector<double> log2frs_;
+    std::shared_ptr<const PrimeSieve> sieve_;
+    std::vector<int> index_;   // index_[p] = position of prime p in the list, -1 if absent
+    bool prime_basis_;         // list numbers are distinct primes
+    unsigned int limit_;
+};
+
+// List-smooth numbers in [1, limit] with their tempered log2fr, ascending
+std::vector<SmoothNumber> smoothNumbers(const PrimeList& primes, unsigned int limit);
+
+/**
+ * Ascending list-smooth numbers without an upper limit, extended lazily by merging the
+ * products p * s for every list entry p (Dijkstra's Hamming number construction). Used
+ * when the largest number needed is not known in advance, e.g. when ranking ratios by
+ * complexity. The sequence ends at the last smooth number that fits in unsigned int.
+ */
+class SmoothSequence {
+public:
+    explicit SmoothSequence(const PrimeList& primes);
+
+    // i-th smooth number (0-based, at(0) is 1); false once the sequence is exhausted
+    bool at(size_t i, SmoothNumber& out);
+
+    // Index of the first smooth number n with log2(n) >= exact_log2, extending as needed
+    size_t firstAtLeast(double exact_log2);
+
+    /**
+     * Largest relative tempering of the list, max |log2fr - log2(p)| / log2(p). For any
+     * smooth n, |tempered log2fr - log2(n)| <= maxRelativeTempering() * log2(n), which
+     * lets callers bound tempered values by the integer order of the sequence.
+     */
+    double maxRelativeTempering() const { return max_relative_tempering_; }
+
+private:
+    bool extend();
+
+    PrimeListFactorizer factorizer_;
+    std::vector<unsigned long long> factors_;
+    std::vector<double> factor_log2frs_;
+    std::vector<size_t> ptr_;                  // per factor, next product to multiply
+    std::vector<unsigned long long> products_; // all products of list entries, ascending
+    std::vector<double> product_log2frs_;
+    std::vector<SmoothNumber> values_;
+    double max_relative_tempering_;
+    bool exhausted_;
+};
+
+} // namespace scalatrix
+
+#endif // SCALATRIX_PRIMES_HPP
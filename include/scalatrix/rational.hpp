@@ -0,0 +1,67 @@
+#ifndef SCALATRIX_RATIONAL_HPP
+#define SCALATRIX_RATIONAL_HPP
+
+#include "affine_transform.hpp"
+
+namespace scalatrix {
+
+/**
+ * Exact rational number num/den, always normalized to den > 0 and gcd(num, den) = 1.
+ * Used by the exact tuning mode (RationalAffineTransform, MOS::fromRational), where
+ * strips are computed in integer arithmetic and the results are bit-reproducible.
+ */
+struct Rational {
+    long long num, den;
+
+    Rational(long long num_ = 0, long long den_ = 1);
+
+    double toDouble() const { return (double)num / (double)den; }
+    long long floor() const;
+
+    Rational operator-() const { return Rational(-num, den); }
+    Rational operator+(const Rational& r) const;
+    Rational operator-(const Rational& r) const;
+    Rational operator*(const Rational& r) const;
+    Rational operator/(const Rational& r) const;
+
+    bool operator==(const Rational& r) const { return num == r.num && den == r.den; }
+    bool operator!=(const Rational& r) const { return !(*this == r); }
+    bool operator<(const Rational& r) const;
+    bool operator>(const Rational& r) const { return r < *this; }
+    bool operator<=(const Rational& r) const { return !(r < *this); }
+    bool operator>=(const Rational& r) const { return !(*this < r); }
+
+    // Best rational approximation of x with denominator <= max_den (continued fractions)
+    static Rational approximate(double x, long long max_den = 1 << 20);
+};
+
+struct Vector2r {
+    Rational x, y;
+    Vector2r(Rational x_ = Rational(), Rational y_ = Rational()) : x(x_), y(y_) {}
+    Vector2d toDouble() const { return {x.toDouble(), y.toDouble()}; }
+};
+
+/**
+ * Affine transform with exact rational coefficients. Images of lattice points are exact,
+ * so strip membership (0 <= y < 1) is decided without tolerances and conversion to double
+ * happens only once per coordinate, in toDouble().
+ */
+class RationalAffineTransform {
+public:
+    Rational a, b, c, d;  // 2x2 matrix
+    Rational tx, ty;      // Offset vector
+
+    RationalAffineTransform(Rational a_ = 1, Rational b_ = 0, Rational c_ = 0, Rational d_ = 1,
+                            Rational tx_ = 0, Rational ty_ = 0);
+    Vector2r operator*(const Vector2i& v) const;
+    Vector2r apply(const Vector2i& v) const;
+    Vector2d applyToDouble(const Vector2i& v) const;
+    RationalAffineTransform operator*(const RationalAffineTransform& M) const;
+    RationalAffineTransform inverse() const;
+    Rational det() const { return a * d - b * c; }
+    AffineTransform toAffine() const;
+};
+
+} // namespace scalatrix
+
+#endif // SCALATRIX_RATIONAL_HPP
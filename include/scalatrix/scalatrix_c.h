@@ -0,0 +1,142 @@
+#ifndef SCALATRIX_C_H
+#define SCALATRIX_C_H
+
+/**
+ * C interface to scalatrix for plugin hosts and other languages.
+ *
+ * Objects are opaque handles created and destroyed by the library. Every function returns
+ * a scalatrix_status and writes results to caller-allocated buffers; no exception crosses
+ * the interface. Vectors are passed as interleaved pairs (x0, y0, x1, y1, ...).
+ *
+ * Functions marked "retune path" neither allocate nor throw and can be called from a
+ * real-time thread, as long as no other thread uses the same handles at the same time.
+ * Handles may be used from any thread, one thread at a time.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Shared library builds (scalatrix_c) export only these functions
+#if defined(SCALATRIX_C_SHARED) && defined(_WIN32)
+#  ifdef SCALATRIX_C_BUILD
+#    define SCALATRIX_C_API __declspec(dllexport)
+#  else
+#    define SCALATRIX_C_API __declspec(dllimport)
+#  endif
+#elif defined(SCALATRIX_C_SHARED) && defined(__GNUC__)
+#  define SCALATRIX_C_API __attribute__((visibility("default")))
+#else
+#  define SCALATRIX_C_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum scalatrix_status {
+    SCALATRIX_OK = 0,
+    SCALATRIX_ERROR_INVALID_ARGUMENT = 1,
+    SCALATRIX_ERROR_BUFFER_TOO_SMALL = 2,
+    SCALATRIX_ERROR_OUT_OF_MEMORY = 3,
+    SCALATRIX_ERROR_IO = 4,
+    SCALATRIX_ERROR_INTERNAL = 5
+} scalatrix_status;
+
+typedef struct scalatrix_mos scalatrix_mos;
+typedef struct scalatrix_scale scalatrix_scale;
+typedef struct scalatrix_pitchset_index scalatrix_pitchset_index;
+
+// Arguments of MOS::fromParams
+typedef struct scalatrix_mos_params {
+    int a, b, mode;
+    double equave, generator;
+} scalatrix_mos_params;
+
+// Static description of a status, never NULL
+SCALATRIX_C_API const char* scalatrix_status_string(scalatrix_status status);
+
+/* MOS */
+
+SCALATRIX_C_API scalatrix_status scalatrix_mos_create(const scalatrix_mos_params* params, scalatrix_mos** out);
+SCALATRIX_C_API void scalatrix_mos_destroy(scalatrix_mos* mos);
+SCALATRIX_C_API scalatrix_status scalatrix_mos_adjust(scalatrix_mos* mos, const scalatrix_mos_params* params);
+SCALATRIX_C_API scalatrix_status scalatrix_mos_get_params(const scalatrix_mos* mos, scalatrix_mos_params* out);
+// Number of notes per equave
+SCALATRIX_C_API scalatrix_status scalatrix_mos_size(const scalatrix_mos* mos, int* out);
+
+// Retune path: MOS::retuneOnePoint, retuneTwoPoints and retuneThreePoints
+SCALATRIX_C_API scalatrix_status scalatrix_mos_retune_one_point(scalatrix_mos* mos, int x, int y, double log2fr);
+SCALATRIX_C_API scalatrix_status scalatrix_mos_retune_two_points(scalatrix_mos* mos, int fixed_x, int fixed_y,
+                                                 int x, int y, double log2fr);
+SCALATRIX_C_API scalatrix_status scalatrix_mos_retune_three_points(scalatrix_mos* mos, const int32_t fixed[4],
+                                                   int x, int y, double log2fr);
+
+// Retune path: out[i] = frequency of the tuning coordinate (coords[2i], coords[2i + 1])
+SCALATRIX_C_API scalatrix_status scalatrix_mos_coords_to_freqs(const scalatrix_mos* mos, const double* coords, size_t n,
+                                               double base_freq, double* out);
+// Retune path: out[i] = 1 if the lattice node (coords[2i], coords[2i + 1]) is in the scale
+SCALATRIX_C_API scalatrix_status scalatrix_mos_nodes_in_scale(const scalatrix_mos* mos, const int32_t* coords, size_t n,
+                                              uint8_t* out);
+
+/* Scale */
+
+// The keyboard of mos: n_nodes nodes with node root at the origin, 0 <= root <= n_nodes
+SCALATRIX_C_API scalatrix_status scalatrix_scale_create_from_mos(scalatrix_mos* mos, double base_freq, int n_nodes, int root,
+                                                 scalatrix_scale** out);
+SCALATRIX_C_API void scalatrix_scale_destroy(scalatrix_scale* scale);
+SCALATRIX_C_API scalatrix_status scalatrix_scale_size(const scalatrix_scale* scale, size_t* out);
+
+// Retune path: retunes the scale to the current tuning of mos
+SCALATRIX_C_API scalatrix_status scalatrix_scale_retune_with_mos(scalatrix_scale* scale, scalatrix_mos* mos, double base_freq);
+
+// Tempers every node to the nearest pitch of the index; may allocate
+SCALATRIX_C_API scalatrix_status scalatrix_scale_temper(scalatrix_scale* scale, const scalatrix_pitchset_index* index);
+
+/*
+ * Retune path: copy node data into caller buffers of capacity elements (pitches) or
+ * capacity pairs (coordinates). Fail with SCALATRIX_ERROR_BUFFER_TOO_SMALL, writing nothing,
+ * if the scale has more nodes than that.
+ */
+SCALATRIX_C_API scalatrix_status scalatrix_scale_get_pitches(const scalatrix_scale* scale, double* out, size_t capacity);
+SCALATRIX_C_API scalatrix_status scalatrix_scale_get_natural_coords(const scalatrix_scale* scale, int32_t* out, size_t capacity);
+SCALATRIX_C_API scalatrix_status scalatrix_scale_get_tuning_coords(const scalatrix_scale* scale, double* out, size_t capacity);
+
+/* PitchSetIndex */
+
+// Equal temperament with n_et steps per equave between min_log2fr and max_log2fr
+SCALATRIX_C_API scalatrix_status scalatrix_pitchset_index_create_et(unsigned int n_et, double equave_log2fr, double min_log2fr,
+                                                    double max_log2fr, scalatrix_pitchset_index** out);
+// Unlabelled pitches given in log2 frequency ratios
+SCALATRIX_C_API scalatrix_status scalatrix_pitchset_index_create(const double* log2frs, size_t n, double equave_log2fr,
+                                                 scalatrix_pitchset_index** out);
+// Memory-maps a file written by PitchSetIndex::save
+SCALATRIX_C_API scalatrix_status scalatrix_pitchset_index_load(const char* path, scalatrix_pitchset_index** out);
+SCALATRIX_C_API void scalatrix_pitchset_index_destroy(scalatrix_pitchset_index* index);
+SCALATRIX_C_API scalatrix_status scalatrix_pitchset_index_size(const scalatrix_pitchset_index* index, size_t* out);
+
+// Retune path: sorted log2fr of each pitch
+SCALATRIX_C_API scalatrix_status scalatrix_pitchset_index_get_log2frs(const scalatrix_pitchset_index* index, double* out,
+                                                      size_t capacity);
+// Retune path: out[i] = sorted position of the pitch nearest to log2frs[i], the index must not be empty
+SCALATRIX_C_API scalatrix_status scalatrix_pitchset_index_nearest(const scalatrix_pitchset_index* index, const double* log2frs,
+                                                  size_t n, uint32_t* out);
+
+/* Batch */
+
+// Caps the threads of batch calls, see scalatrix::setConcurrencyLimit; 0 = all cores, 1 = caller only
+SCALATRIX_C_API void scalatrix_set_concurrency_limit(unsigned limit);
+SCALATRIX_C_API unsigned scalatrix_concurrency_limit(void);
+
+/*
+ * Generates the keyboard of every MOS in parallel and writes the pitches, n_nodes per MOS,
+ * to pitches (n * n_nodes elements), with root as in scalatrix_scale_create_from_mos. n_threads = 0 uses
+ * all cores up to the concurrency limit, larger counts are capped at the number of cores. Allocates internally.
+ */
+SCALATRIX_C_API scalatrix_status scalatrix_generate_mos_pitches(const scalatrix_mos_params* params, size_t n, double base_freq,
+                                                int n_nodes, int root, unsigned n_threads, double* pitches);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SCALATRIX_C_H
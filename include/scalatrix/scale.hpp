@@ -4,6 +4,7 @@
 #include "lattice.hpp"
 #include "affine_transform.hpp"
 #include "pitchset.hpp"
+#include "pitchset_index.hpp"
 #include "node.hpp"
 #include <string>
 #include <vector>
@@ -50,12 +51,47 @@ public:
      */
     static Scale fromAffine(const AffineTransform& M, const double base_freq, int N, int n_root);
 
+    /**
+     * Exact version of fromAffine for transforms with rational coefficients (e.g. equal
+     * temperaments). Strip membership is decided in integer arithmetic, so the node path does
+     * not depend on floating point tolerances and is identical on every platform; tuning
+     * coordinates are converted to double only at the end.
+     */
+    static Scale fromRationalAffine(const RationalAffineTransform& M, const double base_freq, int N, int n_root);
+
+    /**
+     * Fokker periodicity block: the lattice points inside the fundamental parallelogram
+     * spanned by the unison vectors u1 and u2, i.e. v = o + s*u1 + t*u2 with 0 <= s, t < 1.
+     *
+     * Generalises fromAffine from the horizontal strip to arbitrary parallelograms. The block
+     * has |det(u1, u2)| nodes, enumerated in O(block size) from the Hermite basis of the
+     * sublattice spanned by u1 and u2. Nodes are tuned with M and sorted by pitch; the root
+     * index points at the origin when it lies in the block.
+     *
+     * @param offset Position o of the parallelogram in (s, t) coefficients, e.g. (-0.5, -0.5)
+     *               for a block centred on the origin
+     */
+    static Scale fromPeriodicityBlock(const AffineTransform& M, const Vector2i& u1, const Vector2i& u2,
+                                      double base_freq, Vector2d offset = Vector2d(0.0, 0.0));
+
+    // Batch version of fromPeriodicityBlock for many unison vector pairs, n_threads = 0 selects defaultConcurrency()
+    static std::vector<Scale> fromPeriodicityBlocks(const AffineTransform& M,
+                                                    const std::vector<std::pair<Vector2i, Vector2i>>& unison_vectors,
+                                                    double base_freq, Vector2d offset = Vector2d(0.0, 0.0),
+                                                    unsigned n_threads = 0);
+
     void print(int first = 58, int num = 5) const;
     std::vector<Node>& getNodes();
+    const std::vector<Node>& getNodes() const { return nodes_; }
     void recalcWithAffine(const AffineTransform& A, int N, int n_root);
+    void recalcWithRationalAffine(const RationalAffineTransform& A, int N, int n_root);
+    void recalcWithPeriodicityBlock(const AffineTransform& A, const Vector2i& u1, const Vector2i& u2,
+                                    Vector2d offset = Vector2d(0.0, 0.0));
     void retuneWithAffine(const AffineTransform& A);
     int getRootIdx() const { return root_idx_; }
     void temperToPitchSet(PitchSet& pitchset);
+    // Same, reusing an index built once for many scales
+    void temperToPitchSet(const PitchSetIndex& index);
     double getBaseFreq() const { return base_freq_; }
 
     ~Scale();
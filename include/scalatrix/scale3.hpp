@@ -0,0 +1,61 @@
+#ifndef SCALATRIX_SCALE3_HPP
+#define SCALATRIX_SCALE3_HPP
+
+#include "lattice3.hpp"
+#include "scale.hpp"
+#include <vector>
+
+namespace scalatrix {
+
+/**
+ * Node3 is a single note of a rank-3 scale, the 3D counterpart of Node.
+ */
+struct Node3 {
+    Vector3i natural_coord;    // Integer coords in the rank-3 lattice (e.g. a 5-limit monzo)
+    Vector3d tuning_coord;     // Coords after the affine transform, x is log2 frequency ratio
+    double pitch;              // Frequency in Hz
+
+    Node3() noexcept : natural_coord(), tuning_coord(), pitch(0.0) {}
+    Node3(const Vector3i& natural, const Vector3d& tuning, double freq) noexcept
+        : natural_coord(natural), tuning_coord(tuning), pitch(freq) {}
+
+    bool operator<(const Node3& other) const noexcept {
+        return tuning_coord.x < other.tuning_coord.x;
+    }
+};
+
+/**
+ * Scale3 is a path on a 3D lattice: the nodes inside the prism 0 <= y < 1, 0 <= z < 1
+ * after an AffineTransform3, ordered by x.
+ *
+ * Like Scale::fromAffine, the nodes are generated by an incremental walk. The step
+ * vectors between consecutive nodes are computed once per transform with
+ * findStepsWithinPrism, then each node follows from the previous one by the
+ * shortest step that stays inside the prism.
+ */
+class Scale3 {
+private:
+    std::vector<Node3> nodes_;
+    double base_freq_;
+    int root_idx_;
+public:
+    Scale3(double base_freq = DEFAULT_12TET_C_PITCH, int N = 128, int root_node_idx = 60);
+
+    /**
+     * @param A Affine transform, must map the origin into the prism (0 <= y < 1, 0 <= z < 1)
+     * @param base_freq Base frequency for the scale
+     * @param N Number of nodes to generate
+     * @param root_node_idx Index of the root node (origin) in the generated scale
+     */
+    static Scale3 fromAffine(const AffineTransform3& A, double base_freq, int N, int root_node_idx);
+
+    void recalcWithAffine(const AffineTransform3& A, int N, int root_node_idx);
+    void retuneWithAffine(const AffineTransform3& A);
+    std::vector<Node3>& getNodes() { return nodes_; }
+    int getRootIdx() const { return root_idx_; }
+    double getBaseFreq() const { return base_freq_; }
+};
+
+} // namespace scalatrix
+
+#endif // SCALATRIX_SCALE3_HPP
@@ -0,0 +1,69 @@
+#ifndef SCALATRIX_SCALE_ARRAYS_HPP
+#define SCALATRIX_SCALE_ARRAYS_HPP
+
+#include "scalatrix/scale.hpp"
+#include "scalatrix/params.hpp"
+#include "scalatrix/mos.hpp"
+#include "scalatrix/pitchset_index.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace scalatrix {
+
+/**
+ * The nodes of many scales of equal length as flat arrays, one column per Node field.
+ *
+ * Scale s, node i is at s * n_nodes + i; vector columns hold two components per node,
+ * so natural_coords and tuning_coords are (n_scales, n_nodes, 2) and pitches and
+ * tempered are (n_scales, n_nodes) in row-major order.
+ */
+struct ScaleArrays {
+    size_t n_scales = 0, n_nodes = 0;
+    std::vector<int32_t> natural_coords;
+    std::vector<double> tuning_coords;
+    std::vector<double> pitches;          // Hz
+    std::vector<uint8_t> tempered;        // Node::isTempered
+    std::vector<double> tempered_log2frs; // Node::temperedPitch.log2fr, 0 where not tempered
+
+    void resize(size_t scales, size_t nodes);
+    // Copies the nodes of scale into row s, the scale must have n_nodes nodes
+    void setScale(size_t s, const Scale& scale);
+};
+
+/**
+ * Generates the scale of every MOS with MOS::generateScaleFromMOS, in parallel. Each
+ * MOSParams holds the arguments of MOS::fromParams, with r the generator.
+ *
+ * @param n_threads Number of threads, 0 selects defaultConcurrency()
+ */
+ScaleArrays generateMOSScales(const std::vector<MOSParams>& params, double base_freq, int n_nodes, int root,
+                              unsigned n_threads = 0);
+
+// As generateMOSScales, with every scale tempered to the same pitch set
+ScaleArrays temperMOSScales(const std::vector<MOSParams>& params, const PitchSetIndex& index, double base_freq,
+                            int n_nodes, int root, unsigned n_threads = 0);
+
+// Row i is a copy of scale tempered to indices[i]
+ScaleArrays temperScales(const Scale& scale, const std::vector<PitchSetIndex>& indices, unsigned n_threads = 0);
+
+/**
+ * Single-row fills that reuse the storage of out, for callers that keep one ScaleArrays
+ * and refresh it every frame. Views into the columns stay valid as long as the node
+ * count does not grow.
+ */
+void fillScaleArrays(const Scale& scale, ScaleArrays& out);
+
+// The keyboard of mos: generateScaleFromMOS(base_freq, n_nodes, root)
+void fillMOSScaleArrays(MOS& mos, double base_freq, int n_nodes, int root, ScaleArrays& out);
+
+/**
+ * The rectangular lattice window min <= v <= max (componentwise) of mos, y-major: node
+ * (x, y) is at (y - min.y) * (max.x - min.x + 1) + (x - min.x). Tuning coordinates use
+ * the implied affine transform of mos; tempered is 0 for every node.
+ */
+void fillLatticeArrays(const MOS& mos, Vector2i min, Vector2i max, double base_freq, ScaleArrays& out);
+
+} // namespace scalatrix
+
+#endif // SCALATRIX_SCALE_ARRAYS_HPP
@@ -0,0 +1,70 @@
+#ifndef SCALATRIX_TUNING_TABLE_HPP
+#define SCALATRIX_TUNING_TABLE_HPP
+
+#include "scalatrix/scale.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace scalatrix {
+
+/**
+ * Per-key frequency and phase increment, published by one writer and read without locks.
+ *
+ * The table is one contiguous, 8-byte aligned block that can be shared as is, e.g. with an
+ * AudioWorklet through the SharedArrayBuffer of a pthreads Wasm build:
+ *
+ *   offset 0   uint32  sequence, odd while a publish is in progress
+ *   offset 4   uint32  number of keys n
+ *   offset 8   float64 sample rate
+ *   offset 16  float64 frequency[n] in Hz
+ *   then       float64 phase_increment[n], frequency / sample rate in cycles per sample
+ *
+ * Readers follow the seqlock protocol: read the sequence, skip if odd, read the values,
+ * and accept them only if the sequence is unchanged. Publishing never allocates.
+ */
+class TuningTable {
+public:
+    static constexpr size_t HEADER_BYTES = 16;
+
+    explicit TuningTable(size_t n_keys = 128, double sample_rate = 48000.0);
+
+    size_t size() const { return n_keys_; }
+    double sampleRate() const { return sample_rate_->load(std::memory_order_relaxed); }
+    uint32_t sequence() const { return sequence_->load(std::memory_order_acquire); }
+
+    // Key i gets the pitch of node i, keys past the last node get 0 Hz
+    void publish(const Scale& scale);
+    void publish(const double* frequencies, size_t n);
+    // Recomputes the phase increments
+    void setSampleRate(double sample_rate);
+
+    /**
+     * Copies a consistent snapshot, either output may be null.
+     * @return false if a publish was in progress or happened during the copy
+     */
+    bool tryRead(double* frequencies, double* phase_increments) const;
+    // Retries tryRead until it succeeds
+    void read(double* frequencies, double* phase_increments) const;
+
+    // The shared block
+    const uint8_t* data() const { return reinterpret_cast<const uint8_t*>(storage_.get()); }
+    size_t byteSize() const { return HEADER_BYTES + 2 * n_keys_ * sizeof(double); }
+
+private:
+    template <typename F>
+    void write(F&& update);
+
+    size_t n_keys_;
+    std::unique_ptr<uint64_t[]> storage_;
+    std::atomic<uint32_t>* sequence_;
+    // Values are atomics accessed with relaxed order; the sequence fences order them
+    std::atomic<double>* sample_rate_;
+    std::atomic<double>* frequencies_;
+    std::atomic<double>* phase_increments_;
+};
+
+} // namespace scalatrix
+
+#endif // SCALATRIX_TUNING_TABLE_HPP
@@ -1,14 +1,14 @@
 #include "scalatrix/affine_transform.hpp"
 #include <cassert>
 #include <cmath>
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#endif
 
 
 namespace scalatrix {
 
 
-IntegerAffineTransform::IntegerAffineTransform(int a_, int b_, int c_, int d_, int tx_, int ty_)
-    : a(a_), b(b_), c(c_), d(d_), tx(tx_), ty(ty_) {}
-
 IntegerAffineTransform IntegerAffineTransform::operator*(int s) const {
     return {a * s, b * s, c * s, d * s, tx * s, ty * s};
 }
@@ -31,27 +31,12 @@ IntegerAffineTransform IntegerAffineTransform::inverse() const {
     return {d / det, -b / det, -c / det, a / det, -(d * tx - b * ty) / det, -(a * ty - c * tx) / det};
 }
 
-IntegerAffineTransform& IntegerAffineTransform::linearFromTwoDots(
-    const Vector2i& a1, const Vector2i& a2,
-    const Vector2i& b1, const Vector2i& b2) 
-{
-    // make sure a1 and a2 are not collinear
-    assert(a1.x * a2.y - a1.y * a2.x != 0);
-    // make sure b1 and b2 are not collinear
-    assert(b1.x * b2.y - b1.y * b2.x != 0);
-
-    static IntegerAffineTransform _self;
-    _self.tx=0;
-    _self.ty=0;
-    // find linear transform that maps a1 to b1 and a2 to b2
-    // find the linear transform that maps a1 to b1 and a2 to b2
-    int det = a1.x * a2.y - a1.y * a2.x;
-    _self.a = (b1.x * a2.y - b2.x * a1.y) / det;
-    _self.b = (a1.x * b2.x - b1.x * a2.x) / det;
-    _self.c = (b1.y * a2.y - a1.y * b2.y) / det;
-    _self.d = (a1.x * b2.y - a2.x * b1.y) / det;
-
-    return _self;
+void IntegerAffineTransform::linearFromTwoDots(const Vector2i& a1, const Vector2i& a2,
+                                               const Vector2i* b1, const Vector2i* b2, size_t n,
+                                               IntegerAffineTransform* out) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = linearFromTwoDots(a1, a2, b1[i], b2[i]);
+    }
 }
 
 AffineTransform::AffineTransform(double a_, double b_, double c_, double d_, double tx_, double ty_)
@@ -77,6 +62,45 @@ Vector2d AffineTransform::apply(const Vector2d& v) const {
     return {a * v.x + b * v.y + tx, c * v.x + d * v.y + ty};
 }
 
+// With SIMD128 both output components are computed in one f64x2 as (a, c) * x + (b, d) * y
+// + (tx, ty), in the same order as the scalar code, so results are bit-identical
+void AffineTransform::apply(const Vector2d* v, size_t n, Vector2d* out) const {
+#if defined(__wasm_simd128__)
+    const v128_t col_x = wasm_f64x2_make(a, c);
+    const v128_t col_y = wasm_f64x2_make(b, d);
+    const v128_t t = wasm_f64x2_make(tx, ty);
+    for (size_t i = 0; i < n; ++i) {
+        v128_t x = wasm_f64x2_splat(v[i].x);
+        v128_t y = wasm_f64x2_splat(v[i].y);
+        v128_t r = wasm_f64x2_add(wasm_f64x2_add(wasm_f64x2_mul(col_x, x), wasm_f64x2_mul(col_y, y)), t);
+        wasm_v128_store(&out[i], r);
+    }
+#else
+    for (size_t i = 0; i < n; ++i) {
+        double x = v[i].x, y = v[i].y;
+        out[i] = {a * x + b * y + tx, c * x + d * y + ty};
+    }
+#endif
+}
+
+void AffineTransform::apply(const Vector2i* v, size_t n, Vector2d* out) const {
+#if defined(__wasm_simd128__)
+    const v128_t col_x = wasm_f64x2_make(a, c);
+    const v128_t col_y = wasm_f64x2_make(b, d);
+    const v128_t t = wasm_f64x2_make(tx, ty);
+    for (size_t i = 0; i < n; ++i) {
+        v128_t x = wasm_f64x2_splat((double)v[i].x);
+        v128_t y = wasm_f64x2_splat((double)v[i].y);
+        v128_t r = wasm_f64x2_add(wasm_f64x2_add(wasm_f64x2_mul(col_x, x), wasm_f64x2_mul(col_y, y)), t);
+        wasm_v128_store(&out[i], r);
+    }
+#else
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = {a * v[i].x + b * v[i].y + tx, c * v[i].x + d * v[i].y + ty};
+    }
+#endif
+}
+
 //Vector2d AffineTransform::applyInt(const Vector2i& v) const {
 //    return {a * v.x + b * v.y + tx, c * v.x + d * v.y + ty};
 //}
@@ -0,0 +1,161 @@
+#include "scalatrix/comma_search.hpp"
+#include "scalatrix/parallel.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace scalatrix {
+
+namespace {
+
+class CommaSearch {
+public:
+    CommaSearch(const AffineTransform& A, double equave, double tolerance_cents, double max_norm,
+                const LatticeMetric& metric, bool include_equave_multiples)
+        : A_(A), metric_(metric), equave_(equave), tol_(tolerance_cents / 1200.0),
+          R2_(max_norm * max_norm), multiples_(include_equave_multiples && equave > 0.0)
+    {
+        auto [r1, r2] = reduceBasis({1, 0}, {0, 1}, metric);
+        b1_ = r1;
+        b2_ = r2;
+        G11_ = metric.norm2(b1_);
+        G12_ = metric.dot(b1_, b2_);
+        G22_ = metric.norm2(b2_);
+        det_ = G11_ * G22_ - G12_ * G12_;
+        assert(G11_ > 0 && det_ > 0);
+        p1_ = pitch(b1_);
+        p2_ = pitch(b2_);
+        j_max_ = (int)std::floor(std::sqrt(R2_ * G11_ / det_));
+    }
+
+    int rowCount() const { return 2 * j_max_ + 1; }
+
+    // Collects all matches with coefficient j = row - j_max along the second basis vector
+    void searchRow(int row, std::vector<CommaVector>& out) const {
+        long j = row - j_max_;
+        double disc = G11_ * R2_ - (double)(j * j) * det_;
+        if (disc < 0) return;
+        double sq = std::sqrt(disc);
+        // widen by one to be robust against rounding, candidates are re-checked exactly
+        long i_lo = (long)std::ceil((-G12_ * j - sq) / G11_) - 1;
+        long i_hi = (long)std::floor((-G12_ * j + sq) / G11_) + 1;
+
+        if (p1_ == 0.0) {
+            for (long i = i_lo; i <= i_hi; ++i) consider(i, j, 0, false, out);
+            return;
+        }
+
+        double P0 = j * p2_;
+        double Pa = i_lo * p1_ + P0;
+        double Pb = i_hi * p1_ + P0;
+        double Pmin = std::min(Pa, Pb), Pmax = std::max(Pa, Pb);
+        long k_min = 0, k_max = 0;
+        if (multiples_) {
+            k_min = (long)std::ceil((Pmin - tol_) / equave_);
+            k_max = (long)std::floor((Pmax + tol_) / equave_);
+        }
+        for (long k = k_min; k <= k_max; ++k) {
+            // i * p1 + P0 in [k * equave - tol, k * equave + tol]
+            double t0 = (k * equave_ - tol_ - P0) / p1_;
+            double t1 = (k * equave_ + tol_ - P0) / p1_;
+            if (t0 > t1) std::swap(t0, t1);
+            long lo = std::max(i_lo, (long)std::ceil(t0) - 1);
+            long hi = std::min(i_hi, (long)std::floor(t1) + 1);
+            for (long i = lo; i <= hi; ++i) consider(i, j, k, true, out);
+        }
+    }
+
+    CommaSearch(const CommaSearch&) = delete;
+    CommaSearch& operator=(const CommaSearch&) = delete;
+
+private:
+    double pitch(const Vector2i& v) const { return A_.a * v.x + A_.b * v.y; }
+
+    void consider(long i, long j, long k_window, bool check_window, std::vector<CommaVector>& out) const {
+        Vector2i v((int)(i * b1_.x + j * b2_.x), (int)(i * b1_.y + j * b2_.y));
+        if (v.x == 0 && v.y == 0) return;
+        double norm2 = metric_.norm2(v);
+        if (norm2 > R2_) return;
+
+        double P = pitch(v);
+        long k = multiples_ ? std::lround(P / equave_) : 0;
+        // each vector is reported from the window of its nearest equave multiple only
+        if (check_window && k != k_window) return;
+        double dev = P - k * equave_;
+        if (std::abs(dev) > tol_) return;
+
+        // keep one representative of +-v
+        bool canonical;
+        if (k != 0) canonical = k > 0;
+        else if (dev != 0.0) canonical = dev > 0;
+        else canonical = v.x > 0 || (v.x == 0 && v.y > 0);
+        if (!canonical) return;
+
+        out.push_back({v, (int)k, 1200.0 * dev, std::sqrt(norm2)});
+    }
+
+    AffineTransform A_;
+    LatticeMetric metric_;
+    double equave_, tol_, R2_;
+    bool multiples_;
+    Vector2i b1_, b2_;
+    double G11_, G12_, G22_, det_;
+    double p1_, p2_;
+    int j_max_;
+};
+
+void sortCommas(std::vector<CommaVector>& commas) {
+    std::sort(commas.begin(), commas.end(), [](const CommaVector& a, const CommaVector& b) {
+        if (a.norm != b.norm) return a.norm < b.norm;
+        if (std::abs(a.cents) != std::abs(b.cents)) return std::abs(a.cents) < std::abs(b.cents);
+        return a.v < b.v;
+    });
+}
+
+} // namespace
+
+
+std::vector<CommaVector> findCommas(const AffineTransform& A, double equave,
+                                    double tolerance_cents, double max_norm,
+                                    const LatticeMetric& metric, bool include_equave_multiples) {
+    CommaSearch search(A, equave, tolerance_cents, max_norm, metric, include_equave_multiples);
+    std::vector<CommaVector> result;
+    for (int row = 0; row < search.rowCount(); ++row) {
+        search.searchRow(row, result);
+    }
+    sortCommas(result);
+    return result;
+}
+
+std::vector<CommaVector> findCommas(const MOS& mos, double tolerance_cents, double max_norm,
+                                    const LatticeMetric& metric, bool include_equave_multiples) {
+    return findCommas(mos.impliedAffine, mos.equave, tolerance_cents, max_norm, metric, include_equave_multiples);
+}
+
+std::vector<CommaVector> findCommasParallel(const AffineTransform& A, double equave,
+                                            double tolerance_cents, double max_norm,
+                                            const LatticeMetric& metric, bool include_equave_multiples,
+                                            unsigned n_threads) {
+    CommaSearch search(A, equave, tolerance_cents, max_norm, metric, include_equave_multiples);
+    std::vector<std::vector<CommaVector>> rows(search.rowCount());
+    parallelFor(0, rows.size(), [&](size_t row) {
+        search.searchRow((int)row, rows[row]);
+    }, n_threads);
+
+    std::vector<CommaVector> result;
+    size_t total = 0;
+    for (auto& r : rows) total += r.size();
+    result.reserve(total);
+    for (auto& r : rows) result.insert(result.end(), r.begin(), r.end());
+    sortCommas(result);
+    return result;
+}
+
+std::vector<CommaVector> findCommasParallel(const MOS& mos, double tolerance_cents, double max_norm,
+                                            const LatticeMetric& metric, bool include_equave_multiples,
+                                            unsigned n_threads) {
+    return findCommasParallel(mos.impliedAffine, mos.equave, tolerance_cents, max_norm, metric,
+                              include_equave_multiples, n_threads);
+}
+
+} // namespace scalatrix
@@ -0,0 +1,91 @@
+#include "scalatrix/et_table.hpp"
+#include "scalatrix/parallel.hpp"
+#include "scalatrix/primes.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace scalatrix {
+
+ETComparisonTable compareETs(const PitchSet& targets, unsigned int min_et, unsigned int max_et,
+                             double equave_log2fr, const PrimeList& primes, unsigned n_threads) {
+    assert(min_et >= 1);
+    assert(equave_log2fr > 0.0);
+    ETComparisonTable table;
+    table.min_et = min_et;
+    table.max_et = max_et;
+    table.n_targets = targets.size();
+    table.n_primes = primes.size();
+    table.equave_log2fr = equave_log2fr;
+    const size_t rows = table.rows();
+    const size_t n_targets = table.n_targets;
+    const size_t n_primes = table.n_primes;
+
+    // target values in equaves and monzos, computed once for all ETs
+    std::vector<double> target_equaves(n_targets);
+    for (size_t t = 0; t < n_targets; ++t) {
+        target_equaves[t] = targets[t].log2fr / equave_log2fr;
+    }
+    std::vector<double> prime_equaves(n_primes);
+    for (size_t p = 0; p < n_primes; ++p) {
+        prime_equaves[p] = primes[p].log2fr / equave_log2fr;
+    }
+    std::vector<int> monzos(n_targets * n_primes, 0);
+    std::vector<char> has_monzo(n_targets, 0);
+    if (n_primes > 0) {
+        PrimeListFactorizer factorizer(primes, 0);
+        std::vector<int> num_monzo, den_monzo;
+        for (size_t t = 0; t < n_targets; ++t) {
+            const PitchSetPitch& target = targets[t];
+            if (target.kind != RatioPitch || target.num <= 0 || target.den <= 0 ||
+                target.num > 0xFFFFFFFFll || target.den > 0xFFFFFFFFll) continue;
+            if (!factorizer.monzo((unsigned int)target.num, num_monzo) ||
+                !factorizer.monzo((unsigned int)target.den, den_monzo)) continue;
+            has_monzo[t] = 1;
+            for (size_t p = 0; p < n_primes; ++p) {
+                monzos[t * n_primes + p] = num_monzo[p] - den_monzo[p];
+            }
+        }
+    }
+
+    table.best_steps.resize(rows * n_targets);
+    table.errors.resize(rows * n_targets);
+    table.patent_vals.resize(rows * n_primes);
+    table.mapped_steps.resize(rows * n_targets);
+    table.max_errors.resize(rows);
+    table.rms_errors.resize(rows);
+
+    parallelFor(0, rows, [&](size_t r) {
+        const double n = (double)(min_et + r);
+        int* val = table.patent_vals.data() + r * n_primes;
+        for (size_t p = 0; p < n_primes; ++p) {
+            val[p] = (int)std::lround(prime_equaves[p] * n);
+        }
+        int* best = table.best_steps.data() + r * n_targets;
+        double* err = table.errors.data() + r * n_targets;
+        int* mapped = table.mapped_steps.data() + r * n_targets;
+        double max_error = 0.0, sum_sq = 0.0;
+        for (size_t t = 0; t < n_targets; ++t) {
+            double steps = target_equaves[t] * n;
+            int step = (int)std::lround(steps);
+            double e = (step - steps) * equave_log2fr / n;
+            best[t] = step;
+            err[t] = e;
+            max_error = std::max(max_error, std::abs(e));
+            sum_sq += e * e;
+            if (has_monzo[t]) {
+                const int* monzo = monzos.data() + t * n_primes;
+                int m = 0;
+                for (size_t p = 0; p < n_primes; ++p) m += monzo[p] * val[p];
+                mapped[t] = m;
+            } else {
+                mapped[t] = step;
+            }
+        }
+        table.max_errors[r] = max_error;
+        table.rms_errors[r] = n_targets > 0 ? std::sqrt(sum_sq / n_targets) : 0.0;
+    }, n_threads);
+    return table;
+}
+
+} // namespace scalatrix
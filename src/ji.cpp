@@ -0,0 +1,391 @@
+#include "scalatrix/ji.hpp"
+#include "scalatrix/primes.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <numeric>
+
+namespace scalatrix {
+
+JIRatioStream::JIRatioStream(const PrimeList& primes, int max_numorden,
+                             double min_log2fr, double max_log2fr)
+    : min_log2fr_(min_log2fr - 1e-6), max_log2fr_(max_log2fr + 1e-6) {
+    unsigned int limit = max_numorden > 1 ? max_numorden - 1 : 0;
+    PrimeListFactorizer factorizer(primes, limit);
+    auto smooth = factorizer.smoothNumbers();
+
+    numbers_.reserve(smooth.size());
+    log2frs_.reserve(smooth.size());
+    for (const auto& s : smooth) {
+        numbers_.push_back(s.number);
+        log2frs_.push_back(s.log2fr);
+    }
+
+    // prime support masks replace the gcd test when the list is a basis of <= 64 primes
+    if (factorizer.hasPrimeBasis() && primes.size() <= 64) {
+        masks_.reserve(numbers_.size());
+        std::vector<int> monzo;
+        for (unsigned int n : numbers_) {
+            factorizer.monzo(n, monzo);
+            uint64_t mask = 0;
+            for (size_t i = 0; i < monzo.size(); ++i) {
+                if (monzo[i] != 0) mask |= uint64_t(1) << i;
+            }
+            masks_.push_back(mask);
+        }
+    }
+
+    // tempered prime tunings need not preserve the integer order
+    order_.resize(numbers_.size());
+    std::iota(order_.begin(), order_.end(), 0);
+    std::sort(order_.begin(), order_.end(), [this](uint32_t a, uint32_t b) {
+        if (log2frs_[a] != log2frs_[b]) return log2frs_[a] < log2frs_[b];
+        return numbers_[a] < numbers_[b];
+    });
+    sorted_log2frs_.reserve(order_.size());
+    for (uint32_t i : order_) sorted_log2frs_.push_back(log2frs_[i]);
+
+    // one cursor per denominator, at its first numerator above the lower bound
+    for (uint32_t d = 0; d < numbers_.size(); ++d) {
+        double lo = min_log2fr_ + log2frs_[d];
+        Cursor c;
+        c.den_idx = d;
+        c.pos = (uint32_t)(std::upper_bound(sorted_log2frs_.begin(), sorted_log2frs_.end(), lo)
+                           - sorted_log2frs_.begin());
+        if (advance(c)) heap_.push(c);
+    }
+}
+
+bool JIRatioStream::coprime(uint32_t i, uint32_t j) const {
+    if (!masks_.empty()) return (masks_[i] & masks_[j]) == 0;
+    return std::gcd(numbers_[i], numbers_[j]) == 1;
+}
+
+// Moves c to the first coprime numerator at or after c.pos, false once past the range
+bool JIRatioStream::advance(Cursor& c) const {
+    while (c.pos < order_.size()) {
+        uint32_t n = order_[c.pos];
+        double log2fr = log2frs_[n] - log2frs_[c.den_idx];
+        if (!(log2fr < max_log2fr_)) return false;
+        if (coprime(n, c.den_idx) && log2fr > min_log2fr_) {
+            c.log2fr = log2fr;
+            c.num = numbers_[n];
+            c.den = numbers_[c.den_idx];
+            return true;
+        }
+        c.pos++;
+    }
+    return false;
+}
+
+bool JIRatioStream::next(JIRatio& out) {
+    if (heap_.empty()) return false;
+    Cursor c = heap_.top();
+    heap_.pop();
+    out = {c.num, c.den, c.log2fr};
+    c.pos++;
+    if (advance(c)) heap_.push(c);
+    return true;
+}
+
+std::vector<JIRatio> generateJIRatios(const PrimeList& primes, int max_numorden,
+                                      double min_log2fr, double max_log2fr) {
+    JIRatioStream stream(primes, max_numorden, min_log2fr, max_log2fr);
+    std::vector<JIRatio> ratios;
+    JIRatio r;
+    while (stream.next(r)) ratios.push_back(r);
+    return ratios;
+}
+
+PitchSet jiRatiosToPitchSet(const std::vector<JIRatio>& ratios) {
+    PitchSet pitchset;
+    pitchset.reserve(ratios.size());
+    for (const auto& r : ratios) {
+        // ratios are already reduced, so fromRatio's gcd is skipped
+        pitchset.push_back(PitchSetPitch::fromReducedRatio(r.num, r.den, r.log2fr));
+    }
+    return pitchset;
+}
+
+namespace {
+
+struct RankedRatio {
+    unsigned long long tenney;
+    JIRatio ratio;
+};
+
+bool rankedLess(const RankedRatio& a, const RankedRatio& b) {
+    if (a.tenney != b.tenney) return a.tenney < b.tenney;
+    return a.ratio.num < b.ratio.num;
+}
+
+/**
+ * Tenney height: pairs (i, j) of the smooth sequence popped in increasing s_i * s_j.
+ *
+ * Row i (numerator s_i) only holds denominators whose tempered ratio can reach the range.
+ * With relative tempering rho, t_j lies in [(1 - rho), (1 + rho)] * log2(s_j), so a row
+ * starts at the first j that can fall below hi and ends once every later j is below lo.
+ * Rows are seeded in order as soon as their smallest key s_i could be the next minimum.
+ */
+void simplestByTenneyHeight(SmoothSequence& seq, size_t k, double lo, double hi,
+                            std::vector<JIRatio>& out) {
+    struct Entry {
+        unsigned long long key;
+        size_t i, j;
+        bool operator>(const Entry& e) const {
+            if (key != e.key) return key > e.key;
+            if (i != e.i) return i > e.i;
+            return j > e.j;
+        }
+    };
+    double rho = seq.maxRelativeTempering();
+    bool prune = rho < 1.0;
+
+    // false once (i, j) and every later entry of row i lie below the range
+    auto rowContinues = [&](const SmoothNumber& n, const SmoothNumber& d) {
+        return !prune || n.log2fr - (1.0 - rho) * std::log2((double)d.number) > lo;
+    };
+
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> frontier;
+    size_t next_row = 0;
+    SmoothNumber a, b, next;
+    while (out.size() < k) {
+        // seed rows whose smallest possible key does not exceed the current minimum
+        while (seq.at(next_row, a) && (frontier.empty() || a.number <= frontier.top().key)) {
+            size_t j0 = prune ? seq.firstAtLeast((a.log2fr - hi) / (1.0 + rho)) : 0;
+            if (seq.at(j0, b) && rowContinues(a, b)) {
+                frontier.push({(unsigned long long)a.number * b.number, next_row, j0});
+            }
+            next_row++;
+        }
+        if (frontier.empty()) break;
+
+        Entry e = frontier.top();
+        frontier.pop();
+        seq.at(e.i, a);
+        seq.at(e.j, b);
+        double log2fr = a.log2fr - b.log2fr;
+        if (log2fr > lo && log2fr < hi && std::gcd(a.number, b.number) == 1) {
+            out.push_back({a.number, b.number, log2fr});
+        }
+        if (seq.at(e.j + 1, next) && rowContinues(a, next)) {
+            frontier.push({(unsigned long long)a.number * next.number, e.i, e.j + 1});
+        }
+    }
+}
+
+/**
+ * Weil height and odd limit: layer m holds the pairs with max(n, d) = s_m. For the odd
+ * limit the sequence runs over the odd entries and each pair is expanded by the octave
+ * transpositions that fall in range.
+ */
+void simplestByLayers(SmoothSequence& seq, size_t k, double lo, double hi,
+                      const PseudoPrimeInt* octave, std::vector<JIRatio>& out) {
+    std::vector<RankedRatio> layer;
+    SmoothNumber top, other;
+    double rho = seq.maxRelativeTempering();
+    for (size_t m = 0; out.size() < k && seq.at(m, top); ++m) {
+        layer.clear();
+        // without octave expansion s_j must be large enough for top/s_j < hi or s_j/top > lo
+        size_t j0 = 0;
+        if (!octave && rho < 1.0) {
+            j0 = std::min(m, seq.firstAtLeast(std::min(top.log2fr - hi, top.log2fr + lo) / (1.0 + rho)));
+        }
+        for (size_t j = j0; j <= m; ++j) {
+            seq.at(j, other);
+            if (std::gcd(top.number, other.number) != 1) continue;
+            for (int flip = 0; flip < (j == m ? 1 : 2); ++flip) {
+                const SmoothNumber& n = flip ? other : top;
+                const SmoothNumber& d = flip ? top : other;
+                double log2fr = n.log2fr - d.log2fr;
+                if (!octave) {
+                    if (log2fr > lo && log2fr < hi) {
+                        layer.push_back({(unsigned long long)n.number * d.number, {n.number, d.number, log2fr}});
+                    }
+                    continue;
+                }
+                // octaves e with lo < log2fr + e * log2(2) < hi
+                double step = octave->log2fr;
+                assert(step > 0.0);
+                long e_min = (long)std::floor((lo - log2fr) / step) - 1;
+                long e_max = (long)std::ceil((hi - log2fr) / step) + 1;
+                for (long e = e_min; e <= e_max; ++e) {
+                    double l = log2fr + e * step;
+                    if (!(l > lo && l < hi)) continue;
+                    unsigned long long num = n.number, den = d.number;
+                    if (e >= 0 && e < 32) num <<= e;
+                    if (e < 0 && e > -32) den <<= -e;
+                    if (e >= 32 || e <= -32 || num > 0xFFFFFFFFull || den > 0xFFFFFFFFull) continue;
+                    layer.push_back({num * den, {(unsigned int)num, (unsigned int)den, l}});
+                }
+            }
+        }
+        std::sort(layer.begin(), layer.end(), rankedLess);
+        for (const auto& r : layer) {
+            if (out.size() >= k) break;
+            out.push_back(r.ratio);
+        }
+    }
+}
+
+} // namespace
+
+std::vector<JIRatio> generateSimplestRatios(const PrimeList& primes, size_t k,
+                                            HarmonicComplexity complexity,
+                                            double min_log2fr, double max_log2fr) {
+    std::vector<JIRatio> out;
+    out.reserve(k);
+    double lo = min_log2fr - 1e-6, hi = max_log2fr + 1e-6;
+    if (complexity == TenneyHeight) {
+        SmoothSequence seq(primes);
+        simplestByTenneyHeight(seq, k, lo, hi, out);
+    } else if (complexity == WeilHeight) {
+        SmoothSequence seq(primes);
+        simplestByLayers(seq, k, lo, hi, nullptr, out);
+    } else {
+        PrimeList odd;
+        const PseudoPrimeInt* octave = nullptr;
+        for (const auto& p : primes) {
+            if (p.number == 2) {
+                octave = &p;
+            } else {
+                odd.push_back(p);
+            }
+        }
+        SmoothSequence seq(odd);
+        simplestByLayers(seq, k, lo, hi, octave, out);
+    }
+    return out;
+}
+
+PitchSet generateSimplestPitchSet(const PrimeList& primes, size_t k,
+                                  HarmonicComplexity complexity,
+                                  double min_log2fr, double max_log2fr) {
+    return jiRatiosToPitchSet(generateSimplestRatios(primes, k, complexity, min_log2fr, max_log2fr));
+}
+
+namespace {
+
+// Octave-reduces num/den into [1, 2) keeping it in lowest terms, tracking the octave count
+class OctaveReducer {
+public:
+    explicit OctaveReducer(const PrimeList& primes) : factorizer_(primes, 0), octave_(1.0) {
+        for (const auto& p : primes) {
+            if (p.number == 2) octave_ = p.log2fr;
+        }
+    }
+
+    double octave() const { return octave_; }
+
+    double log2fr(unsigned int n) const {
+        double l;
+        factorizer_.log2fr(n, l, true);
+        return l;
+    }
+
+    // ratio (n / d) with tempered value t, false if the reduced terms overflow unsigned int
+    bool reduce(unsigned long long n, unsigned long long d, double t, JIRatio& out) const {
+        unsigned long long g = std::gcd(n, d);
+        n /= g;
+        d /= g;
+        int e = 0;
+        while (n >= 2 * d) {
+            if (n % 2 == 0) n /= 2; else d *= 2;
+            e--;
+        }
+        while (n < d) {
+            if (d % 2 == 0) d /= 2; else n *= 2;
+            e++;
+        }
+        if (n > 0xFFFFFFFFull || d > 0xFFFFFFFFull) return false;
+        out = {(unsigned int)n, (unsigned int)d, t + e * octave_};
+        return true;
+    }
+
+private:
+    PrimeListFactorizer factorizer_;
+    double octave_;
+};
+
+std::vector<JIRatio> sortUnique(std::vector<JIRatio> ratios, const OctaveReducer& reducer, bool include_equave) {
+    std::sort(ratios.begin(), ratios.end(), [](const JIRatio& a, const JIRatio& b) {
+        if (a.num != b.num || a.den != b.den) {
+            return (unsigned long long)a.num * b.den < (unsigned long long)b.num * a.den;
+        }
+        return false;
+    });
+    ratios.erase(std::unique(ratios.begin(), ratios.end(), [](const JIRatio& a, const JIRatio& b) {
+        return a.num == b.num && a.den == b.den;
+    }), ratios.end());
+    // the reduced ratios lie below 2:1, but a tempered octave can sort before some of them
+    if (include_equave) ratios.push_back({2, 1, reducer.octave()});
+    // tempering may reorder ratios that are close in just intonation
+    std::stable_sort(ratios.begin(), ratios.end(), [](const JIRatio& a, const JIRatio& b) {
+        return a.log2fr < b.log2fr;
+    });
+    return ratios;
+}
+
+} // namespace
+
+std::vector<JIRatio> generateDiamondRatios(const std::vector<unsigned int>& identities,
+                                           const PrimeList& primes, bool include_equave) {
+    OctaveReducer reducer(primes);
+    std::vector<double> t;
+    t.reserve(identities.size());
+    for (unsigned int i : identities) {
+        assert(i > 0);
+        t.push_back(reducer.log2fr(i));
+    }
+    std::vector<JIRatio> ratios;
+    ratios.reserve(identities.size() * identities.size());
+    JIRatio r;
+    for (size_t i = 0; i < identities.size(); ++i) {
+        for (size_t j = 0; j < identities.size(); ++j) {
+            if (reducer.reduce(identities[i], identities[j], t[i] - t[j], r)) ratios.push_back(r);
+        }
+    }
+    return sortUnique(std::move(ratios), reducer, include_equave);
+}
+
+PitchSet generateDiamondPitchSet(const std::vector<unsigned int>& identities,
+                                 const PrimeList& primes, bool include_equave) {
+    return jiRatiosToPitchSet(generateDiamondRatios(identities, primes, include_equave));
+}
+
+PitchSet generateOddLimitDiamondPitchSet(const PrimeList& primes, unsigned int odd_limit,
+                                         bool include_equave) {
+    std::vector<unsigned int> identities;
+    for (const auto& s : smoothNumbers(primes, odd_limit)) {
+        if (s.number % 2 == 1) identities.push_back(s.number);
+    }
+    return generateDiamondPitchSet(identities, primes, include_equave);
+}
+
+static PitchSet generateHarmonicChordPitchSet(const std::vector<unsigned int>& identities,
+                                              const PrimeList& primes, bool include_equave, bool otonal) {
+    OctaveReducer reducer(primes);
+    std::vector<JIRatio> ratios;
+    ratios.reserve(identities.size());
+    JIRatio r;
+    for (unsigned int i : identities) {
+        assert(i > 0);
+        double t = reducer.log2fr(i);
+        bool ok = otonal ? reducer.reduce(i, 1, t, r) : reducer.reduce(1, i, -t, r);
+        if (ok) ratios.push_back(r);
+    }
+    return jiRatiosToPitchSet(sortUnique(std::move(ratios), reducer, include_equave));
+}
+
+PitchSet generateOtonalPitchSet(const std::vector<unsigned int>& identities,
+                                const PrimeList& primes, bool include_equave) {
+    return generateHarmonicChordPitchSet(identities, primes, include_equave, true);
+}
+
+PitchSet generateUtonalPitchSet(const std::vector<unsigned int>& identities,
+                                const PrimeList& primes, bool include_equave) {
+    return generateHarmonicChordPitchSet(identities, primes, include_equave, false);
+}
+
+} // namespace scalatrix
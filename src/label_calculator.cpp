@@ -1,82 +1,291 @@
 #include "scalatrix/label_calculator.hpp"
+#include <cassert>
+#include <charconv>
+#include <map>
+#include <mutex>
+#include <tuple>
 
 namespace scalatrix {
 
-std::string LabelCalculator::accidentalString(const MOS& mos, Vector2i v) {
-    int acc_sign = mos.L_vec.x == 1 ? 1 : -1;
-    int neutral_mode =  mos.L_vec.x == 1 ? 1 : mos.n0 - 2;
+namespace {
+
+// UTF-8 runs of accidentals, copied in chunks instead of one glyph at a time
+const int GLYPH_BYTES = 3;
+const int GLYPH_RUN = 8;
+const char FLATS[] = "\xe2\x99\xad\xe2\x99\xad\xe2\x99\xad\xe2\x99\xad\xe2\x99\xad\xe2\x99\xad\xe2\x99\xad\xe2\x99\xad";   // ♭ (U+266D)
+const char SHARPS[] = "\xe2\x99\xaf\xe2\x99\xaf\xe2\x99\xaf\xe2\x99\xaf\xe2\x99\xaf\xe2\x99\xaf\xe2\x99\xaf\xe2\x99\xaf"; // ♯ (U+266F)
+
+int floorDiv(int num, int den) {
+    int q = num / den;
+    return (num % den != 0 && ((num < 0) != (den < 0))) ? q - 1 : q;
+}
+
+int positiveMod(int num, int den) {
+    int r = num % den;
+    return r < 0 ? r + den : r;
+}
+
+// Appends to std::string and std::vector<char> alike
+template <typename Out>
+void append(Out& out, const char* s, size_t n) {
+    out.insert(out.end(), s, s + n);
+}
+
+template <typename Out>
+void appendInt(Out& out, long long value) {
+    char buf[24];
+    char* end = std::to_chars(buf, buf + sizeof(buf), value).ptr;
+    append(out, buf, end - buf);
+}
+
+// The parts of a MOS that node labels depend on
+struct LabelStructure {
+    int n, n0, a0, b0;
+    bool large_step_x;
+
+    explicit LabelStructure(const MOS& mos)
+        : n(mos.n), n0(mos.n0), a0(mos.a0), b0(mos.b0), large_step_x(mos.L_vec.x == 1) {}
+    LabelStructure(int n, int n0, int a0, int b0, bool large_step_x)
+        : n(n), n0(n0), a0(a0), b0(b0), large_step_x(large_step_x) {}
+};
+
+// Signed count of sharps (> 0) or flats (< 0); floor((n + m + 0.5) / n0) == floorDiv(n + m, n0)
+int accidentalCount(const LabelStructure& mos, Vector2i v) {
+    int acc_sign = mos.large_step_x ? 1 : -1;
+    int neutral_mode = mos.large_step_x ? 1 : mos.n0 - 2;
     int n_generators = v.x * mos.b0 - v.y * mos.a0;
-    int acc = acc_sign * floor((n_generators + neutral_mode + 0.5) / mos.n0);
-    std::string result = "";
-    if (acc != 0) {
-        while (acc < 0) {
-            acc += 1;
-            // Use direct UTF-8 byte sequences for better Windows compatibility
-            result += "\xe2\x99\xad"; // UTF-8 bytes for ♭ (U+266D)
-        }
-        while (acc > 0) {
-            acc -= 1;
-            // Use direct UTF-8 byte sequences for better Windows compatibility
-            result += "\xe2\x99\xaf"; // UTF-8 bytes for ♯ (U+266F)
+    return acc_sign * floorDiv(n_generators + neutral_mode, mos.n0);
+}
+
+template <typename Out>
+void appendAccidentals(Out& out, int acc) {
+    const char* glyphs = acc < 0 ? FLATS : SHARPS;
+    int count = acc < 0 ? -acc : acc;
+    while (count > 0) {
+        int run = count < GLYPH_RUN ? count : GLYPH_RUN;
+        append(out, glyphs, run * GLYPH_BYTES);
+        count -= run;
+    }
+}
+
+// Accidentals and the digit or letter of step (v.x + v.y) mod n
+template <typename Out>
+void appendLabelPrefix(Out& out, const LabelStructure& mos, int acc, int step, bool letter) {
+    appendAccidentals(out, acc);
+    if (!letter) {
+        appendInt(out, step + 1);
+        return;
+    }
+    char c = (char)('A' + positiveMod(step + 2, mos.n));
+    append(out, &c, 1);
+}
+
+template <typename Out>
+void appendOctave(Out& out, const LabelStructure& mos, Vector2i v, LabelStyle style, int middle_C_octave) {
+    if (style == LetterWithOctaveNumberLabel) {
+        appendInt(out, middle_C_octave + floorDiv(v.x + v.y, mos.n));
+    }
+}
+
+template <typename Out>
+void appendNodeLabel(Out& out, const LabelStructure& mos, Vector2i v, LabelStyle style, int middle_C_octave) {
+    appendLabelPrefix(out, mos, accidentalCount(mos, v), positiveMod(v.x + v.y, mos.n), style != DigitLabel);
+    appendOctave(out, mos, v, style, middle_C_octave);
+}
+
+// "label", or "label+12.3ct" / "label-12.3ct" with the deviation rounded to 0.1 cent
+template <typename Out>
+void appendDeviationLabel(Out& out, const Node& node, double thresholdCents, bool compareWithTempered) {
+    const PitchSetPitch& referencePitch = node.closestPitch;
+    if (referencePitch.label.empty()) return;
+    append(out, referencePitch.label.data(), referencePitch.label.size());
+
+    double actualPitchLog2fr = compareWithTempered ? node.temperedPitch.log2fr : node.tuning_coord.x;
+    double deviationCents = 1200.0 * (actualPitchLog2fr - referencePitch.log2fr);
+    if (std::abs(deviationCents) < thresholdCents) return;
+
+    // fixed with precision 1 rounds like printf's "%.1f"; the largest double needs 311 chars
+    char digits[320];
+    auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), std::abs(deviationCents),
+                                   std::chars_format::fixed, 1);
+    if (ec != std::errc()) return;
+    if (deviationCents > 0) append(out, "+", 1);
+    if (deviationCents < 0) append(out, "-", 1);
+    append(out, digits, end - digits);
+    append(out, "ct", 2);
+}
+
+void closeLabel(LabelBuffer& out) {
+    out.offsets.push_back((uint32_t)out.chars.size());
+}
+
+} // namespace
+
+bool LabelTable::Key::operator<(const Key& other) const {
+    return std::tie(a, b, mode, large_step_x) < std::tie(other.a, other.b, other.mode, other.large_step_x);
+}
+
+bool LabelTable::Key::operator==(const Key& other) const {
+    return a == other.a && b == other.b && mode == other.mode && large_step_x == other.large_step_x;
+}
+
+/*static*/
+LabelTable::Key LabelTable::keyOf(const MOS& mos) {
+    return {mos.a, mos.b, mos.mode, mos.L_vec.x == 1};
+}
+
+LabelTable::LabelTable(const MOS& mos, int max_accidentals)
+    : key_(keyOf(mos)), n_(mos.n), n0_(mos.n0), a0_(mos.a0), b0_(mos.b0),
+      max_accidentals_(max_accidentals), large_step_x_(mos.L_vec.x == 1) {
+    assert(max_accidentals >= 0);
+    LabelStructure structure(mos);
+    int width = 2 * max_accidentals + 1;
+    offsets_.reserve(2 * n_ * width + 1);
+    for (int letter = 0; letter < 2; ++letter) {
+        for (int step = 0; step < n_; ++step) {
+            for (int acc = -max_accidentals; acc <= max_accidentals; ++acc) {
+                offsets_.push_back((uint32_t)chars_.size());
+                appendLabelPrefix(chars_, structure, acc, step, letter == 1);
+            }
         }
     }
+    offsets_.push_back((uint32_t)chars_.size());
+}
+
+/*static*/
+std::shared_ptr<const LabelTable> LabelTable::shared(const MOS& mos) {
+    static std::mutex mutex;
+    static std::map<Key, std::shared_ptr<const LabelTable>> cache;
+
+    Key key = keyOf(mos);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = cache.find(key);
+    if (it != cache.end()) return it->second;
+    // structures are few in practice; drop everything rather than track usage if they pile up
+    if (cache.size() >= 256) cache.clear();
+    auto table = std::make_shared<const LabelTable>(mos);
+    cache.emplace(key, table);
+    return table;
+}
+
+template <typename Out>
+void LabelTable::appendLabel(Out& out, Vector2i v, LabelStyle style, int middle_C_octave) const {
+    LabelStructure structure(n_, n0_, a0_, b0_, large_step_x_);
+    int acc = accidentalCount(structure, v);
+    int step = positiveMod(v.x + v.y, n_);
+    if (acc >= -max_accidentals_ && acc <= max_accidentals_) {
+        int width = 2 * max_accidentals_ + 1;
+        size_t i = ((style != DigitLabel ? n_ : 0) + step) * width + (acc + max_accidentals_);
+        append(out, chars_.data() + offsets_[i], offsets_[i + 1] - offsets_[i]);
+    } else {
+        appendLabelPrefix(out, structure, acc, step, style != DigitLabel);
+    }
+    appendOctave(out, structure, v, style, middle_C_octave);
+}
+
+std::string LabelTable::label(Vector2i v, LabelStyle style, int middle_C_octave) const {
+    std::string result;
+    appendLabel(result, v, style, middle_C_octave);
+    return result;
+}
+
+void LabelTable::labels(const Vector2i* coords, size_t n, LabelStyle style, LabelBuffer& out,
+                        int middle_C_octave) const {
+    out.offsets.reserve(out.offsets.size() + n);
+    for (size_t i = 0; i < n; ++i) {
+        appendLabel(out.chars, coords[i], style, middle_C_octave);
+        closeLabel(out);
+    }
+}
+
+std::string LabelCalculator::accidentalString(const MOS& mos, Vector2i v) {
+    std::string result;
+    appendAccidentals(result, accidentalCount(LabelStructure(mos), v));
     return result;
 }
 
 std::string LabelCalculator::nodeLabelDigit(const MOS& mos, Vector2i v) {
-    int dia = (v.x + v.y + 128*mos.n) % mos.n;
-    std::string result = std::to_string(dia+1);
-    result = accidentalString(mos, v) + result;
+    std::string result;
+    appendNodeLabel(result, LabelStructure(mos), v, DigitLabel, 0);
     return result;
 }
 
 std::string LabelCalculator::nodeLabelLetter(const MOS& mos, Vector2i v) {
-    int dia = (v.x + v.y + 2 + 128*mos.n) % mos.n;
-    char letter = 'A' + dia;
-    std::string result(1, letter);
-    result = accidentalString(mos, v) + result;
+    std::string result;
+    appendNodeLabel(result, LabelStructure(mos), v, LetterLabel, 0);
     return result;
 }
 
 std::string LabelCalculator::nodeLabelLetterWithOctaveNumber(const MOS& mos, Vector2i v, int middle_C_octave) {
-    std::string result = nodeLabelLetter(mos, v);
-    int octave = middle_C_octave + floor((.0 + v.x + v.y) / mos.n);
-    result += std::to_string(octave);
+    std::string result;
+    appendNodeLabel(result, LabelStructure(mos), v, LetterWithOctaveNumberLabel, middle_C_octave);
     return result;
 }
 
-std::string LabelCalculator::deviationLabel(const Node& node, double thresholdCents, 
+std::string LabelCalculator::deviationLabel(const Node& node, double thresholdCents,
                                             bool compareWithTempered) {
-    // Select which pitch to use as reference
-    const PitchSetPitch& referencePitch = node.closestPitch;
-    
-    // If no reference pitch is set, return empty string
-    if (referencePitch.label.empty()) {
-        return "";
+    std::string result;
+    appendDeviationLabel(result, node, thresholdCents, compareWithTempered);
+    return result;
+}
+
+void LabelCalculator::nodeLabels(const MOS& mos, const Vector2i* coords, size_t n, LabelStyle style,
+                                 LabelBuffer& out, int middle_C_octave) {
+    LabelTable::shared(mos)->labels(coords, n, style, out, middle_C_octave);
+}
+
+void LabelCalculator::nodeLabels(const MOS& mos, const Scale& scale, LabelStyle style,
+                                 LabelBuffer& out, int middle_C_octave) {
+    auto table = LabelTable::shared(mos);
+    const std::vector<Node>& nodes = scale.getNodes();
+    out.offsets.reserve(out.offsets.size() + nodes.size());
+    for (const Node& node : nodes) {
+        table->labels(&node.natural_coord, 1, style, out, middle_C_octave);
     }
-    
-    // Calculate the actual pitch of this node
-    double actualPitchLog2fr = compareWithTempered ? node.temperedPitch.log2fr : node.tuning_coord.x;
-    
-    // Calculate deviation in cents
-    double deviationCents = 1200.0 * (actualPitchLog2fr - referencePitch.log2fr);
-    
-    // If deviation is small enough, use plain label
-    if (std::abs(deviationCents) < thresholdCents) {
-        return referencePitch.label;
+}
+
+/*static*/
+const MOS& LabelCalculator::diatonicReference() {
+    // initialised once, thread-safe since C++11
+    static const MOS diatonic = MOS::fromParams(5, 2, 1, 1.0, .585);
+    return diatonic;
+}
+
+bool LabelCalculator::usesDiatonicLetters(const MOS& mos, bool override_letter_labels) {
+    return mos.generator > 4.0/7 && mos.generator < 3.0/5 && mos.equave > 0.9 && mos.equave < 1.2 &&
+           !override_letter_labels;
+}
+
+std::string LabelCalculator::noteLabelNormalized(const MOS& mos, Vector2i v, bool override_letter_labels) {
+    if (usesDiatonicLetters(mos, override_letter_labels)) {
+        const MOS& diatonic = diatonicReference();
+        return nodeLabelLetter(diatonic, diatonic.mapFromMOS(mos, v));
     }
-    
-    // Otherwise, append deviation
-    char deviationStr[32];
-    if (deviationCents > 0) {
-        std::snprintf(deviationStr, sizeof(deviationStr), "%s+%.1fct", 
-                     referencePitch.label.c_str(), deviationCents);
-    } else {
-        std::snprintf(deviationStr, sizeof(deviationStr), "%s%.1fct", 
-                     referencePitch.label.c_str(), deviationCents);
+    return nodeLabelDigit(mos, v);
+}
+
+void LabelCalculator::noteLabelsNormalized(const MOS& mos, const Vector2i* coords, size_t n, LabelBuffer& out,
+                                           bool override_letter_labels) {
+    if (!usesDiatonicLetters(mos, override_letter_labels)) {
+        nodeLabels(mos, coords, n, DigitLabel, out);
+        return;
+    }
+    const MOS& diatonic = diatonicReference();
+    auto table = LabelTable::shared(diatonic);
+    out.offsets.reserve(out.offsets.size() + n);
+    for (size_t i = 0; i < n; ++i) {
+        Vector2i mapped = diatonic.mapFromMOS(mos, coords[i]);
+        table->labels(&mapped, 1, LetterLabel, out);
+    }
+}
+
+void LabelCalculator::deviationLabels(const std::vector<Node>& nodes, LabelBuffer& out,
+                                      double thresholdCents, bool compareWithTempered) {
+    out.offsets.reserve(out.offsets.size() + nodes.size());
+    for (const Node& node : nodes) {
+        appendDeviationLabel(out.chars, node, thresholdCents, compareWithTempered);
+        closeLabel(out);
     }
-    
-    return std::string(deviationStr);
 }
 
-} // namespace scalatrix
\ No newline at end of file
+} // namespace scalatrix
@@ -1,7 +1,9 @@
 #include "scalatrix/lattice.hpp"
+#include <algorithm>
 #include <vector>
 #include <cassert>
 #include <cmath>
+#include <numeric>
 
 namespace scalatrix {
 
@@ -144,4 +146,120 @@ std::pair<Vector2i, Vector2i> findClosestWithinStrip(const AffineTransform& M) {
     return {r, s};
 }
 
-} // namespace scalatrix
\ No newline at end of file
+StripPeriod findStripPeriod(const RationalAffineTransform& M) {
+    // y(v) = (C * v.x + D * v.y + T) / Q over a common denominator
+    long long Q = std::lcm(std::lcm(M.c.den, M.d.den), M.ty.den);
+    long long C = M.c.num * (Q / M.c.den);
+    long long D = M.d.num * (Q / M.d.den);
+    long long T = M.ty.num * (Q / M.ty.den);
+    assert(0 <= T && T < Q);
+    assert(C != 0 || D != 0);
+
+    // extended Euclid: u * C + w * D = g
+    long long old_r = C, r = D;
+    long long old_u = 1, u = 0;
+    long long old_w = 0, w = 1;
+    while (r != 0) {
+        long long q = old_r / r;
+        std::swap(old_r, r); r -= q * old_r;
+        std::swap(old_u, u); u -= q * old_u;
+        std::swap(old_w, w); w -= q * old_w;
+    }
+    if (old_r < 0) {
+        old_r = -old_r; old_u = -old_u; old_w = -old_w;
+    }
+    long long g = old_r;
+
+    // y is constant along the kernel direction, orient it towards increasing pitch
+    Vector2i k((int)(D / g), (int)(-C / g));
+    Rational xk = M.a * k.x + M.b * k.y;
+    assert(xk.num != 0);
+    if (xk.num < 0) {
+        k = -k;
+        xk = -xk;
+    }
+
+    // admissible numerators j * g with 0 <= j * g + T < Q, one coset of k each
+    long long j_min = -(T / g);
+    long long j_max = (Q - 1 - T) / g;
+    StripPeriod result;
+    result.period = k;
+    result.nodes.reserve((size_t)(j_max - j_min + 1));
+    for (long long j = j_min; j <= j_max; ++j) {
+        Vector2i v((int)(j * old_u), (int)(j * old_w));
+        Rational x = M.a * v.x + M.b * v.y;
+        long long t = (x / xk).floor();
+        v -= k * (int)t;
+        result.nodes.push_back(v);
+    }
+
+    std::vector<std::pair<Rational, Vector2i>> keyed;
+    keyed.reserve(result.nodes.size());
+    for (auto& v : result.nodes) {
+        keyed.emplace_back(M.a * v.x + M.b * v.y, v);
+    }
+    std::sort(keyed.begin(), keyed.end(), [](const auto& p, const auto& q) {
+        if (p.first != q.first) return p.first < q.first;
+        return p.second < q.second;
+    });
+
+    result.root = 0;
+    for (size_t i = 0; i < keyed.size(); ++i) {
+        result.nodes[i] = keyed[i].second;
+        if (keyed[i].second == Vector2i(0, 0)) result.root = (int)i;
+    }
+    return result;
+}
+
+std::pair<Vector2i, Vector2i> reduceBasis(Vector2i b1, Vector2i b2, const LatticeMetric& metric) {
+    assert(b1.x * b2.y - b1.y * b2.x != 0);
+    double q1 = metric.norm2(b1);
+    double q2 = metric.norm2(b2);
+    if (q1 > q2) {
+        std::swap(b1, b2);
+        std::swap(q1, q2);
+    }
+    while (true) {
+        // subtract the nearest integer multiple of b1 from b2
+        int mu = (int)std::lround(metric.dot(b1, b2) / q1);
+        if (mu != 0) {
+            b2 -= b1 * mu;
+            q2 = metric.norm2(b2);
+        }
+        if (q2 >= q1) {
+            break;
+        }
+        std::swap(b1, b2);
+        std::swap(q1, q2);
+    }
+    return {b1, b2};
+}
+
+std::pair<Vector2i, Vector2i> hermiteBasis(const Vector2i& u1, const Vector2i& u2) {
+    long long det = (long long)u1.x * u2.y - (long long)u1.y * u2.x;
+    assert(det != 0);
+
+    // extended Euclid on the y components: s * u1.y + t * u2.y = g
+    long long old_r = u1.y, r = u2.y;
+    long long old_s = 1, s = 0;
+    long long old_t = 0, t = 1;
+    while (r != 0) {
+        long long q = old_r / r;
+        std::swap(old_r, r); r -= q * old_r;
+        std::swap(old_s, s); s -= q * old_s;
+        std::swap(old_t, t); t -= q * old_t;
+    }
+    if (old_r < 0) {
+        old_r = -old_r; old_s = -old_s; old_t = -old_t;
+    }
+    long long g = old_r;
+
+    // h2 has the smallest positive y in the sublattice, h1 spans its intersection with y = 0
+    long long C = g;
+    long long B = old_s * u1.x + old_t * u2.x;
+    long long A = std::abs(det) / g;
+    B = ((B % A) + A) % A;
+    return {Vector2i((int)A, 0), Vector2i((int)B, (int)C)};
+}
+
+} // namespace scalatrix
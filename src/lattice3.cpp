@@ -0,0 +1,153 @@
+#include "scalatrix/lattice3.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace scalatrix {
+
+AffineTransform3::AffineTransform3()
+    : m{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}, tx(0), ty(0), tz(0) {}
+
+AffineTransform3::AffineTransform3(double m00, double m01, double m02,
+                                   double m10, double m11, double m12,
+                                   double m20, double m21, double m22,
+                                   double tx_, double ty_, double tz_)
+    : m{{m00, m01, m02}, {m10, m11, m12}, {m20, m21, m22}}, tx(tx_), ty(ty_), tz(tz_) {}
+
+Vector3d AffineTransform3::operator*(const Vector3d& v) const {
+    return {m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z + tx,
+            m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z + ty,
+            m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z + tz};
+}
+
+Vector3d AffineTransform3::operator*(const Vector3i& v) const {
+    return (*this) * Vector3d(v);
+}
+
+Vector3d AffineTransform3::apply(const Vector3d& v) const {
+    return (*this) * v;
+}
+
+AffineTransform3 AffineTransform3::operator*(const AffineTransform3& M) const {
+    AffineTransform3 R;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            R.m[i][j] = m[i][0] * M.m[0][j] + m[i][1] * M.m[1][j] + m[i][2] * M.m[2][j];
+        }
+    }
+    Vector3d t = (*this) * Vector3d(M.tx, M.ty, M.tz);
+    R.tx = t.x;
+    R.ty = t.y;
+    R.tz = t.z;
+    return R;
+}
+
+double AffineTransform3::det() const {
+    return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+         - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+         + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+}
+
+AffineTransform3 AffineTransform3::inverse() const {
+    double D = det();
+    assert(std::abs(D) > 1e-12);
+    AffineTransform3 R(
+        (m[1][1] * m[2][2] - m[1][2] * m[2][1]) / D,
+        (m[0][2] * m[2][1] - m[0][1] * m[2][2]) / D,
+        (m[0][1] * m[1][2] - m[0][2] * m[1][1]) / D,
+        (m[1][2] * m[2][0] - m[1][0] * m[2][2]) / D,
+        (m[0][0] * m[2][2] - m[0][2] * m[2][0]) / D,
+        (m[0][2] * m[1][0] - m[0][0] * m[1][2]) / D,
+        (m[1][0] * m[2][1] - m[1][1] * m[2][0]) / D,
+        (m[0][1] * m[2][0] - m[0][0] * m[2][1]) / D,
+        (m[0][0] * m[1][1] - m[0][1] * m[1][0]) / D
+    );
+    Vector3d t = R * Vector3d(tx, ty, tz);
+    R.tx = -t.x;
+    R.ty = -t.y;
+    R.tz = -t.z;
+    return R;
+}
+
+AffineTransform3 affineFromFourDots(
+    const Vector3d& a1, const Vector3d& a2, const Vector3d& a3, const Vector3d& a4,
+    const Vector3d& b1, const Vector3d& b2, const Vector3d& b3, const Vector3d& b4) {
+    // linear part maps the edge vectors a_k - a1 to b_k - b1
+    Vector3d da[3] = {a2 - a1, a3 - a1, a4 - a1};
+    Vector3d db[3] = {b2 - b1, b3 - b1, b4 - b1};
+    AffineTransform3 A(da[0].x, da[1].x, da[2].x,
+                       da[0].y, da[1].y, da[2].y,
+                       da[0].z, da[1].z, da[2].z);
+    AffineTransform3 B(db[0].x, db[1].x, db[2].x,
+                       db[0].y, db[1].y, db[2].y,
+                       db[0].z, db[1].z, db[2].z);
+    AffineTransform3 R = B * A.inverse();
+    Vector3d t = b1 - R * a1;
+    R.tx = t.x;
+    R.ty = t.y;
+    R.tz = t.z;
+    return R;
+}
+
+std::vector<Vector3i> findStepsWithinPrism(const AffineTransform3& M, double max_step) {
+    AffineTransform3 L = M;
+    L.tx = L.ty = L.tz = 0;
+    AffineTransform3 Li = L.inverse();
+
+    // bounding box of the preimage of (0, max_step] x (-1, 1) x (-1, 1) in the first two coordinates
+    int lo[2], hi[2];
+    for (int i = 0; i < 2; ++i) {
+        double span_x = Li.m[i][0] * max_step;
+        double min_v = std::min(0.0, span_x) - std::abs(Li.m[i][1]) - std::abs(Li.m[i][2]);
+        double max_v = std::max(0.0, span_x) + std::abs(Li.m[i][1]) + std::abs(Li.m[i][2]);
+        lo[i] = (int)std::floor(min_v);
+        hi[i] = (int)std::ceil(max_v);
+    }
+
+    // w = L (v0, v1, 0) + v2 * col, solve each window constraint for v2
+    double col[3] = {L.m[0][2], L.m[1][2], L.m[2][2]};
+    double w_lo[3] = {0.0, -1.0, -1.0};
+    double w_hi[3] = {max_step, 1.0, 1.0};
+
+    std::vector<Vector3i> steps;
+    for (int v0 = lo[0]; v0 <= hi[0]; ++v0) {
+        for (int v1 = lo[1]; v1 <= hi[1]; ++v1) {
+            Vector3d w0 = L * Vector3d(v0, v1, 0);
+            double base[3] = {w0.x, w0.y, w0.z};
+            double t_lo = -1e18, t_hi = 1e18;
+            bool empty = false;
+            for (int k = 0; k < 3 && !empty; ++k) {
+                if (col[k] == 0.0) {
+                    empty = base[k] < w_lo[k] || base[k] > w_hi[k];
+                    continue;
+                }
+                double t0 = (w_lo[k] - base[k]) / col[k];
+                double t1 = (w_hi[k] - base[k]) / col[k];
+                if (t0 > t1) std::swap(t0, t1);
+                t_lo = std::max(t_lo, t0);
+                t_hi = std::min(t_hi, t1);
+                empty = t_lo > t_hi;
+            }
+            if (empty) continue;
+            // candidates are re-checked exactly below
+            long v2_lo = (long)std::ceil(t_lo) - 1;
+            long v2_hi = (long)std::floor(t_hi) + 1;
+            for (long v2 = v2_lo; v2 <= v2_hi; ++v2) {
+                Vector3i v(v0, v1, (int)v2);
+                Vector3d w = L * v;
+                if (w.x > 0 && w.x <= max_step && std::abs(w.y) < 1 && std::abs(w.z) < 1) {
+                    steps.push_back(v);
+                }
+            }
+        }
+    }
+
+    std::sort(steps.begin(), steps.end(), [&L](const Vector3i& a, const Vector3i& b) {
+        double xa = (L * a).x, xb = (L * b).x;
+        if (xa != xb) return xa < xb;
+        return a < b;
+    });
+    return steps;
+}
+
+} // namespace scalatrix
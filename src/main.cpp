@@ -3,6 +3,7 @@ using namespace scalatrix;
 
 #ifdef EMSCRIPTEN
 #include <emscripten/bind.h>
+#include <emscripten/val.h>
 
 EMSCRIPTEN_BINDINGS(scalatrix) {
     emscripten::class_<IntegerAffineTransform>("IntegerAffineTransform")
@@ -25,16 +26,25 @@ EMSCRIPTEN_BINDINGS(scalatrix) {
         .property("d", &AffineTransform::d)
         .property("tx", &AffineTransform::tx)
         .property("ty", &AffineTransform::ty)
-        .function("apply", &AffineTransform::apply)
+        .function("apply", emscripten::select_overload<Vector2d(const Vector2d&) const>(&AffineTransform::apply))
         .function("applyAffine", &AffineTransform::applyAffine)
         .function("inverse", &AffineTransform::inverse);
 
     emscripten::class_<Scale>("Scale")
         .constructor<double, int>()
         .class_function("fromAffine", &Scale::fromAffine)
+        .class_function("fromPeriodicityBlock", &Scale::fromPeriodicityBlock)
+        .function("recalcWithPeriodicityBlock", &Scale::recalcWithPeriodicityBlock)
         .function("recalcWithAffine", &Scale::recalcWithAffine)
+        .class_function("fromRationalAffine", emscripten::optional_override(
+            [](int a_num, int a_den, int b_num, int b_den, int c_num, int c_den, int d_num, int d_den,
+               int ty_num, int ty_den, double base_freq, int N, int n_root) {
+                RationalAffineTransform A({a_num, a_den}, {b_num, b_den}, {c_num, c_den}, {d_num, d_den},
+                                          0, {ty_num, ty_den});
+                return Scale::fromRationalAffine(A, base_freq, N, n_root);
+            }))
         .function("retuneWithAffine", &Scale::retuneWithAffine)
-        .function("getNodes", &Scale::getNodes)
+        .function("getNodes", emscripten::select_overload<std::vector<Node>&()>(&Scale::getNodes))
         .function("print", &Scale::print);
     
     //emscripten::register_vector<bool>("mosPath");
@@ -42,15 +52,28 @@ EMSCRIPTEN_BINDINGS(scalatrix) {
     emscripten::class_<MOS>("MOS")
         .class_function("fromG", &MOS::fromG)
         .class_function("fromParams", &MOS::fromParams)
+        // 64-bit Rational fields are not exposed to JS, exact values are passed as int fractions
+        .class_function("fromRational", emscripten::optional_override(
+            [](int a, int b, int m, int e_num, int e_den, int g_num, int g_den) {
+                return MOS::fromRational(a, b, m, Rational(e_num, e_den), Rational(g_num, g_den));
+            }))
+        .function("adjustParamsRational", emscripten::optional_override(
+            [](MOS& self, int a, int b, int m, int e_num, int e_den, int g_num, int g_den) {
+                self.adjustParamsRational(a, b, m, Rational(e_num, e_den), Rational(g_num, g_den));
+            }))
+        .property("exact", &MOS::exact)
+        .property("has_exact_params", &MOS::has_exact_params)
         .function("adjustG", &MOS::adjustG)
         .function("adjustParams", &MOS::adjustParams)
         .function("coordToFreq", &MOS::coordToFreq)
         .function("angle", &MOS::angle)
         .function("angleStd", &MOS::angleStd)
         .function("gFromAngle", &MOS::gFromAngle)
+#ifndef SCALATRIX_WASM_CORE
         .function("nodeLabelDigit", &MOS::nodeLabelDigit)
         .function("nodeLabelLetter", &MOS::nodeLabelLetter)
         .function("nodeLabelLetterWithOctaveNumber", &MOS::nodeLabelLetterWithOctaveNumber)
+#endif
         .function("retuneZeroPoint", &MOS::retuneZeroPoint)
         .function("retuneOnePoint", &MOS::retuneOnePoint)
         .function("retuneTwoPoints", &MOS::retuneTwoPoints)
@@ -116,8 +139,84 @@ EMSCRIPTEN_BINDINGS(scalatrix) {
 
     emscripten::register_vector<Node>("VectorNode");
 
+    // Flat node columns as Int32Array/Float64Array/Uint8Array views over the WASM heap. A view
+    // stays valid until the ScaleArrays is refilled with more nodes, deleted, or memory grows.
+    emscripten::class_<ScaleArrays>("ScaleArrays")
+        .constructor<>()
+        .property("n_scales", &ScaleArrays::n_scales)
+        .property("n_nodes", &ScaleArrays::n_nodes)
+        .function("naturalCoords", emscripten::optional_override([](ScaleArrays& a) {
+            return emscripten::val(emscripten::typed_memory_view(a.natural_coords.size(), a.natural_coords.data()));
+        }))
+        .function("tuningCoords", emscripten::optional_override([](ScaleArrays& a) {
+            return emscripten::val(emscripten::typed_memory_view(a.tuning_coords.size(), a.tuning_coords.data()));
+        }))
+        .function("pitches", emscripten::optional_override([](ScaleArrays& a) {
+            return emscripten::val(emscripten::typed_memory_view(a.pitches.size(), a.pitches.data()));
+        }))
+        .function("tempered", emscripten::optional_override([](ScaleArrays& a) {
+            return emscripten::val(emscripten::typed_memory_view(a.tempered.size(), a.tempered.data()));
+        }))
+        .function("temperedLog2frs", emscripten::optional_override([](ScaleArrays& a) {
+            return emscripten::val(emscripten::typed_memory_view(a.tempered_log2frs.size(), a.tempered_log2frs.data()));
+        }))
+        // one boundary crossing per keyboard or lattice view
+        .function("fillScale", emscripten::optional_override([](ScaleArrays& a, const Scale& scale) {
+            fillScaleArrays(scale, a);
+        }))
+        .function("fillMOSScale", emscripten::optional_override(
+            [](ScaleArrays& a, MOS& mos, double base_freq, int n_nodes, int root) {
+                fillMOSScaleArrays(mos, base_freq, n_nodes, root, a);
+            }))
+        .function("fillLattice", emscripten::optional_override(
+            [](ScaleArrays& a, const MOS& mos, int x_min, int y_min, int x_max, int y_max, double base_freq) {
+                fillLatticeArrays(mos, {x_min, y_min}, {x_max, y_max}, base_freq, a);
+            }));
+
+    // Tuning table for audio threads: pass HEAPU8.buffer and byteOffset() to a
+    // TuningTableReader (tuning_table_reader.mjs) in a pthreads build, or mirror bytes()
+    // into a SharedArrayBuffer after each publish otherwise
+    emscripten::class_<TuningTable>("TuningTable")
+        .constructor<size_t, double>()
+        .function("size", &TuningTable::size)
+        .function("sampleRate", &TuningTable::sampleRate)
+        .function("sequence", &TuningTable::sequence)
+        .function("publishScale", emscripten::select_overload<void(const Scale&)>(&TuningTable::publish))
+        .function("setSampleRate", &TuningTable::setSampleRate)
+        .function("byteOffset", emscripten::optional_override([](const TuningTable& t) {
+            return (uintptr_t)t.data();
+        }))
+        .function("byteSize", &TuningTable::byteSize)
+        .function("bytes", emscripten::optional_override([](const TuningTable& t) {
+            return emscripten::val(emscripten::typed_memory_view(t.byteSize(), t.data()));
+        }));
+
+    // Sweeps; the pthreads build runs them on its worker pool
+    emscripten::value_object<MOSParams>("MOSParams")
+        .field("a", &MOSParams::a)
+        .field("b", &MOSParams::b)
+        .field("m", &MOSParams::m)
+        .field("e", &MOSParams::e)
+        .field("r", &MOSParams::r);
+    emscripten::register_vector<MOSParams>("MOSParamsList");
+    emscripten::function("generateMOSScales", emscripten::optional_override(
+        [](const std::vector<MOSParams>& params, double base_freq, int n_nodes, int root) {
+            return generateMOSScales(params, base_freq, n_nodes, root);
+        }));
+    // worker count of the pthreads build, 1 keeps batch calls on the calling thread
+    emscripten::function("setConcurrencyLimit", &setConcurrencyLimit);
+    emscripten::function("concurrencyLimit", &concurrencyLimit);
+
     emscripten::function("affineFromThreeDots", &scalatrix::affineFromThreeDots);
+}
 
+// Labels and pitch sets, left out of the size-optimised core module (SCALATRIX_WASM_CORE)
+#ifndef SCALATRIX_WASM_CORE
+EMSCRIPTEN_BINDINGS(scalatrix_pitch_sets) {
+    emscripten::function("temperMOSScales", emscripten::optional_override(
+        [](const std::vector<MOSParams>& params, const PitchSetIndex& index, double base_freq, int n_nodes, int root) {
+            return temperMOSScales(params, index, base_freq, n_nodes, root);
+        }));
 
     emscripten::value_object<PseudoPrimeInt>("PseudoPrimeInt")
         .field("label", &PseudoPrimeInt::label)
@@ -134,7 +233,50 @@ EMSCRIPTEN_BINDINGS(scalatrix) {
     emscripten::function("generateHarmonicSeriesPitchSet", &scalatrix::generateHarmonicSeriesPitchSet);
     emscripten::function("generateETPitchSet", &scalatrix::generateETPitchSet);
     emscripten::function("generateJIPitchSet", &scalatrix::generateJIPitchSet);
+    emscripten::function("pitchSetUnion", &scalatrix::pitchSetUnion);
+    emscripten::function("pitchSetIntersection", &scalatrix::pitchSetIntersection);
+    emscripten::function("transposePitchSet", &scalatrix::transposePitchSet);
+    emscripten::function("stackPitchSets", &scalatrix::stackPitchSets);
+
+    emscripten::class_<ETComparisonTable>("ETComparisonTable")
+        .function("rows", &ETComparisonTable::rows)
+        .function("bestStep", &ETComparisonTable::bestStep)
+        .function("error", &ETComparisonTable::error)
+        .function("mappedStep", &ETComparisonTable::mappedStep)
+        .function("consistent", &ETComparisonTable::consistent)
+        .function("maxError", emscripten::optional_override([](const ETComparisonTable& t, unsigned int et) {
+            return t.max_errors[et - t.min_et];
+        }))
+        .function("rmsError", emscripten::optional_override([](const ETComparisonTable& t, unsigned int et) {
+            return t.rms_errors[et - t.min_et];
+        }));
+    emscripten::function("compareETs", &scalatrix::compareETs);
+
+    emscripten::enum_<HarmonicComplexity>("HarmonicComplexity")
+        .value("TenneyHeight", TenneyHeight)
+        .value("WeilHeight", WeilHeight)
+        .value("OddLimit", OddLimit);
+    emscripten::function("generateSimplestPitchSet", &scalatrix::generateSimplestPitchSet);
+
+    emscripten::class_<PitchSetIndex>("PitchSetIndex")
+        .constructor<const PitchSet&, double>()
+        .function("size", &PitchSetIndex::size)
+        .function("pitch", &PitchSetIndex::pitch)
+        .function("nearest", emscripten::select_overload<size_t(double) const>(&PitchSetIndex::nearest))
+        .function("kNearest", &PitchSetIndex::kNearest)
+        .function("nearestReduced", emscripten::optional_override([](const PitchSetIndex& index, double log2fr) {
+            double matched;
+            return index.pitch(index.nearestReduced(log2fr, matched));
+        }));
+    emscripten::register_vector<size_t>("IndexList");
+
+    emscripten::register_vector<unsigned int>("IdentityList");
+    emscripten::function("generateDiamondPitchSet", &scalatrix::generateDiamondPitchSet);
+    emscripten::function("generateOddLimitDiamondPitchSet", &scalatrix::generateOddLimitDiamondPitchSet);
+    emscripten::function("generateOtonalPitchSet", &scalatrix::generateOtonalPitchSet);
+    emscripten::function("generateUtonalPitchSet", &scalatrix::generateUtonalPitchSet);
 }
+#endif // SCALATRIX_WASM_CORE
 #endif
 
 
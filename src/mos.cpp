@@ -7,6 +7,9 @@
 #include <algorithm>
 #include <cassert>
 #include <iostream>
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#endif
 
 #ifndef M_PI_2
 #define M_PI_2 1.57079632679489661923
@@ -19,12 +22,30 @@ MOS::MOS(int a, int b, int m, double e, double g) {
     adjustParams(a, b, m, e, g);
 }
 
+MOS::MOS(int a, int b, int m, Rational e, Rational g) {
+    adjustParamsRational(a, b, m, e, g);
+}
+
 
 int gcd(int a, int b) {
     if (b == 0) return a;
     return gcd(b, a % b);
 }
 
+static bool sameAffine(const AffineTransform& A, const AffineTransform& B) {
+    return A.a == B.a && A.b == B.b && A.c == B.c && A.d == B.d && A.tx == B.tx && A.ty == B.ty;
+}
+
+// Octave number and base scale index of step i: i == octave * n + idx with 0 <= idx < n
+static void splitStep(int i, int n, int& octave, int& idx) {
+    octave = i / n;
+    idx = i % n;
+    if (idx < 0) {
+        idx += n;
+        octave -= 1;
+    }
+}
+
 double MOS::angleStd() const {
     // inverse of
     // double generator = 1.0 / (1.0 + tan((1 - angle) * M_PI * .5)); 
@@ -67,7 +88,7 @@ std::vector<bool> calcPath(int a, int b){
 }
 
 
-Vector2i applyPath(const std::vector<bool> path, const Vector2i& v) {
+Vector2i applyPath(const std::vector<bool>& path, const Vector2i& v) {
     int a = v.x;
     int b = v.y;
     for (bool p : path) {
@@ -80,7 +101,7 @@ Vector2i applyPath(const std::vector<bool> path, const Vector2i& v) {
     return {a,b};
 }
 
-Vector2i applyPathReverse(const std::vector<bool> path, const Vector2i& v) {
+Vector2i applyPathReverse(const std::vector<bool>& path, const Vector2i& v) {
     int a = v.x;
     int b = v.y;
     std::vector<bool> reversed_path = path;
@@ -128,10 +149,15 @@ double MOS::coordToFreq(double x, double y, double base_freq){
     return base_freq * std::exp2((this->impliedAffine * Vector2d(x,y)).x);
 }
 
-void MOS::adjustParams(int a, int b, int m, double e, double g){
+void MOS::coordsToFreqs(const Vector2d* coords, size_t count, double base_freq, double* out) const {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = base_freq * std::exp2((impliedAffine * coords[i]).x);
+    }
+}
+
+void MOS::_setStructure(int a, int b, int m){
     assert(a > 0);
     assert(b > 0);
-    assert(0.0 <= g && g <= 1.0);
 
     int n = a + b;
     int r = gcd(a, b);
@@ -147,14 +173,22 @@ void MOS::adjustParams(int a, int b, int m, double e, double g){
     this->n0 = n0;
     this->mode = m;
     this->repetitions = r;
-    
-    this->equave = e;
-    this->period = e / r;
-    this->generator = g;
 
     this->path = calcPath(a0, b0);
     this->depth = this->path.size();
     this->v_gen = applyPath(this->path, {1, 0});
+}
+
+void MOS::adjustParams(int a, int b, int m, double e, double g){
+    assert(0.0 <= g && g <= 1.0);
+    _setStructure(a, b, m);
+
+    this->exact = false;
+    this->has_exact_params = false;
+    this->equave = e;
+    this->period = e / repetitions;
+    this->generator = g;
+
     this->impliedAffine = calcImpliedAffine();
 
     this->updateVectors();
@@ -168,6 +202,35 @@ void MOS::adjustParams(int a, int b, int m, double e, double g){
     );
 }
 
+void MOS::adjustParamsRational(int a, int b, int m, Rational e, Rational g){
+    assert(Rational(0) <= g && g <= Rational(1));
+    _setStructure(a, b, m);
+
+    this->exact = true;
+    this->has_exact_params = true;
+    this->exact_equave = e;
+    this->exact_generator = g;
+    this->equave = e.toDouble();
+    this->period = (e / Rational(repetitions)).toDouble();
+    this->generator = g.toDouble();
+
+    this->exactAffine = calcImpliedRationalAffine();
+    this->impliedAffine = exactAffine.toAffine();
+
+    this->updateVectors();
+
+    this->base_scale = Scale::fromRationalAffine(this->exactAffine, 1.0, n+1, 0);
+
+    this->mosTransform = IntegerAffineTransform::linearFromTwoDots(
+        {1, 0}, {1, 1},
+        v_gen, {a0, b0}
+    );
+}
+
+MOS MOS::fromRational(int a, int b, int m, Rational e, Rational g){
+    return MOS(a, b, m, e, g);
+}
+
 void MOS::adjustG(int depth, int m, double g, double e, int _repetitions){
     int a0 = 1;
     int b0 = 1;
@@ -244,7 +307,25 @@ AffineTransform MOS::calcImpliedAffine() const {
 
 
 
+/**
+ * Exact counterpart of calcImpliedAffine: solves the same three point constraints
+ * (origin, v_gen, period vector) in rationals. det(v_gen, (a0, b0)) = +-1, so the
+ * coefficients have the denominators of the period, generator and 2 * n0 only.
+ */
+RationalAffineTransform MOS::calcImpliedRationalAffine() const {
+    Rational P = exact_equave / Rational(repetitions);
+    Rational G = exact_generator * P;
+    Rational det = Rational((long long)v_gen.x * b0 - (long long)v_gen.y * a0);
+    Rational inv_n0(1, n0);
+    return RationalAffineTransform(
+        (G * b0 - P * v_gen.y) / det, (P * v_gen.x - G * a0) / det,
+        (inv_n0 * b0) / det, (-inv_n0 * a0) / det,
+        Rational(0), Rational(2 * mode + 1, 2 * n0)
+    );
+}
+
 void MOS::_recalcOnRetuneUsingAffine(AffineTransform& A){
+    this->exact = false;
     this->base_scale.retuneWithAffine(A);
     this->impliedAffine = A;
     this->equave = A.apply(Vector2i(a,b)).x - A.apply(Vector2i(0,0)).x;
@@ -254,7 +335,12 @@ void MOS::_recalcOnRetuneUsingAffine(AffineTransform& A){
 };
 
 void MOS::retuneZeroPoint(){
-    // use to undo tempering
+    // use to undo tempering, keeping earlier retunes; the exact tuning comes back only
+    // while no retune has moved the affine away from it
+    if (has_exact_params && sameAffine(this->impliedAffine, this->exactAffine.toAffine())) {
+        adjustParamsRational(a, b, mode, exact_equave, exact_generator);
+        return;
+    }
     _recalcOnRetuneUsingAffine(this->impliedAffine);
 }
 void MOS::retuneOnePoint(Vector2i v, double log2fr){
@@ -292,13 +378,17 @@ void MOS::retuneThreePoints(Vector2i fixed1, Vector2i fixed2, Vector2i v, double
 Scale MOS::generateScaleFromMOS(double base_freq, int n_nodes, int root){
     Scale scale = Scale(base_freq, n_nodes, root);
     for (int i=-root; i<n_nodes-root; i++){
-        int idx = (i +  128*n) % n;
-        int octave_nr = (i + 128*n) / n - 128;
+        int idx, octave_nr;
+        splitStep(i, n, octave_nr, idx);
         Node& ref = this->base_scale.getNodes()[idx];
         Node& node = scale.getNodes()[i+root];
         node.natural_coord = (Vector2i(a,b) * octave_nr) + ref.natural_coord;
-        node.tuning_coord = this->impliedAffine * node.natural_coord;
-        node.tuning_coord.x = ref.tuning_coord.x + octave_nr * this->equave;
+        if (exact) {
+            node.tuning_coord = this->exactAffine.applyToDouble(node.natural_coord);
+        } else {
+            node.tuning_coord = this->impliedAffine * node.natural_coord;
+            node.tuning_coord.x = ref.tuning_coord.x + octave_nr * this->equave;
+        }
         node.pitch = base_freq * exp2(node.tuning_coord.x);
         node.isTempered = ref.isTempered;
         node.temperedPitch = ref.temperedPitch;
@@ -307,14 +397,47 @@ Scale MOS::generateScaleFromMOS(double base_freq, int n_nodes, int root){
 };
 
 void MOS::retuneScaleWithMOS(Scale& scale, double base_freq){
-    //int n_nodes = scale.getNodes().size();
+    std::vector<Node>& nodes = scale.getNodes();
+    const std::vector<Node>& ref_nodes = this->base_scale.getNodes();
     int root_idx = scale.getRootIdx();
-    for (int i = 0; i < scale.getNodes().size(); i++) {
-        int idx = (i - root_idx + 128*n) % n;
-        int octave_nr = (i - root_idx + 128*n) / n - 128;
-        Node& ref = this->base_scale.getNodes()[idx];
-        Node& node = scale.getNodes()[i];
-        node.tuning_coord.x = ref.tuning_coord.x + octave_nr * this->equave;
+    size_t i = 0;
+#if defined(__wasm_simd128__)
+    // two nodes per f64x2: x = ref.x + octave_nr * equave as in the scalar loop, so results
+    // are bit-identical; exp2 stays scalar
+    if (!exact) {
+        const v128_t equave_x2 = wasm_f64x2_splat(this->equave);
+        for (; i + 1 < nodes.size(); i += 2) {
+            int idx0, octave0, idx1, octave1;
+            splitStep((int)i - root_idx, n, octave0, idx0);
+            splitStep((int)i + 1 - root_idx, n, octave1, idx1);
+            const Node& ref0 = ref_nodes[idx0];
+            const Node& ref1 = ref_nodes[idx1];
+            v128_t ref_x = wasm_f64x2_make(ref0.tuning_coord.x, ref1.tuning_coord.x);
+            v128_t octave = wasm_f64x2_make((double)octave0, (double)octave1);
+            v128_t x = wasm_f64x2_add(ref_x, wasm_f64x2_mul(octave, equave_x2));
+            nodes[i].tuning_coord.x = wasm_f64x2_extract_lane(x, 0);
+            nodes[i + 1].tuning_coord.x = wasm_f64x2_extract_lane(x, 1);
+            for (size_t k = 0; k < 2; ++k) {
+                Node& node = nodes[i + k];
+                const Node& ref = k == 0 ? ref0 : ref1;
+                node.pitch = base_freq * std::exp2(node.tuning_coord.x);
+                node.isTempered = ref.isTempered;
+                node.temperedPitch = ref.temperedPitch;
+            }
+        }
+    }
+#endif
+    for (; i < nodes.size(); i++) {
+        int idx, octave_nr;
+        splitStep((int)i - root_idx, n, octave_nr, idx);
+        const Node& ref = ref_nodes[idx];
+        Node& node = nodes[i];
+        if (exact) {
+            Rational x = (this->exactAffine * ref.natural_coord).x + this->exact_equave * octave_nr;
+            node.tuning_coord.x = x.toDouble();
+        } else {
+            node.tuning_coord.x = ref.tuning_coord.x + octave_nr * this->equave;
+        }
         node.pitch = base_freq * std::exp2(node.tuning_coord.x);
         node.isTempered = ref.isTempered;
         node.temperedPitch = ref.temperedPitch;
@@ -322,7 +445,7 @@ void MOS::retuneScaleWithMOS(Scale& scale, double base_freq){
 };
 
 
-Vector2i MOS::mapFromMOS(MOS& other, Vector2i v){
+Vector2i MOS::mapFromMOS(const MOS& other, Vector2i v) const {
     Vector2i result = applyPathReverse(other.path, v);
     result = applyPath(path, result);
     return result;
@@ -337,6 +460,13 @@ bool MOS::nodeInScale(Vector2i v) const{
     return true;
 }
 
+void MOS::nodesInScale(const Vector2i* v, size_t count, bool* out) const {
+    for (size_t i = 0; i < count; ++i) {
+        int d = v[i].x * b - v[i].y * a + mode;
+        out[i] = d >= 0 && d < n;
+    }
+}
+
 // Deprecated methods - forwarding to LabelCalculator
 std::string MOS::nodeLabelDigit(Vector2i v) const {
     return LabelCalculator::nodeLabelDigit(*this, v);
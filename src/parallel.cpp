@@ -0,0 +1,245 @@
+#include "scalatrix/parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if (defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)) || defined(SCALATRIX_SINGLE_THREADED)
+#define SCALATRIX_NO_THREADS 1
+#endif
+
+namespace scalatrix {
+
+namespace {
+
+std::atomic<unsigned> concurrency_limit{0};
+
+// Set while a thread runs indices of a parallelFor; nested calls then run inline
+thread_local bool inside_parallel_for = false;
+
+#ifndef SCALATRIX_NO_THREADS
+
+unsigned hardwareConcurrency() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+// The indices [next, end) not yet taken from one participant's block
+struct alignas(64) Block {
+    std::mutex mutex;
+    size_t next = 0;
+    size_t end = 0;
+};
+
+struct Job {
+    detail::RangeFn range;
+    void* fn;
+    size_t grain;
+    unsigned n_slots;
+    std::unique_ptr<Block[]> blocks;
+    unsigned next_slot = 1; // slot 0 is the caller's, guarded by the pool mutex
+    unsigned active = 0;    // pool workers inside the job, guarded by the pool mutex
+
+    std::mutex error_mutex;
+    size_t error_index = 0;
+    std::exception_ptr error;
+
+    // Takes the next chunk from the front of block self
+    bool takeOwn(unsigned self, size_t& lo, size_t& hi) {
+        Block& block = blocks[self];
+        std::lock_guard<std::mutex> lock(block.mutex);
+        if (block.next >= block.end) return false;
+        lo = block.next;
+        hi = std::min(block.end, lo + grain);
+        block.next = hi;
+        return true;
+    }
+
+    // Moves the back half of the largest other block into block self
+    bool steal(unsigned self) {
+        for (;;) {
+            unsigned victim = self;
+            size_t largest = 0;
+            for (unsigned s = 0; s < n_slots; ++s) {
+                if (s == self) continue;
+                std::lock_guard<std::mutex> lock(blocks[s].mutex);
+                size_t remaining = blocks[s].end - blocks[s].next;
+                if (remaining > largest) {
+                    largest = remaining;
+                    victim = s;
+                }
+            }
+            if (victim == self) return false;
+
+            size_t lo, hi;
+            {
+                std::lock_guard<std::mutex> lock(blocks[victim].mutex);
+                Block& block = blocks[victim];
+                if (block.next >= block.end) continue; // drained meanwhile, look again
+                hi = block.end;
+                lo = block.next + (block.end - block.next) / 2;
+                block.end = lo;
+            }
+            std::lock_guard<std::mutex> lock(blocks[self].mutex);
+            blocks[self].next = lo;
+            blocks[self].end = hi;
+            return true;
+        }
+    }
+
+    void run(unsigned self) {
+        bool was_inside = inside_parallel_for;
+        inside_parallel_for = true;
+        size_t lo, hi;
+        for (;;) {
+            if (!takeOwn(self, lo, hi)) {
+                if (!steal(self)) break;
+                continue;
+            }
+            std::exception_ptr e;
+            size_t failed = range(fn, lo, hi, e);
+            if (e) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error || failed < error_index) {
+                    error = e;
+                    error_index = failed;
+                }
+            }
+        }
+        inside_parallel_for = was_inside;
+    }
+};
+
+// Workers are started on demand, up to the largest concurrency any call asked for, and
+// live until exit. They pick up jobs in submission order.
+class ThreadPool {
+public:
+    static ThreadPool& shared() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        work_cv_.notify_all();
+        for (auto& w : workers_) w.join();
+    }
+
+    void run(Job& job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            while (workers_.size() < job.n_slots - 1) {
+                workers_.emplace_back([this]() { workerLoop(); });
+            }
+            jobs_.push_back(&job);
+        }
+        work_cv_.notify_all();
+
+        job.run(0);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        jobs_.erase(std::find(jobs_.begin(), jobs_.end(), &job));
+        done_cv_.wait(lock, [&]() { return job.active == 0; });
+    }
+
+private:
+    Job* openJob() {
+        for (Job* job : jobs_) {
+            if (job->next_slot < job->n_slots) return job;
+        }
+        return nullptr;
+    }
+
+    void workerLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            work_cv_.wait(lock, [&]() { return stop_ || openJob(); });
+            if (stop_) return;
+            Job* job = openJob();
+            unsigned slot = job->next_slot++;
+            ++job->active;
+            lock.unlock();
+            job->run(slot);
+            lock.lock();
+            if (--job->active == 0) done_cv_.notify_all();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    std::vector<Job*> jobs_;
+    std::vector<std::thread> workers_;
+    bool stop_ = false;
+};
+
+#endif // SCALATRIX_NO_THREADS
+
+} // namespace
+
+unsigned defaultConcurrency() {
+#ifdef SCALATRIX_NO_THREADS
+    return 1;
+#else
+    unsigned limit = concurrency_limit.load(std::memory_order_relaxed);
+    unsigned n = hardwareConcurrency();
+    return limit == 0 ? n : std::min(n, limit);
+#endif
+}
+
+void setConcurrencyLimit(unsigned limit) {
+    concurrency_limit.store(limit, std::memory_order_relaxed);
+}
+
+unsigned concurrencyLimit() {
+    return concurrency_limit.load(std::memory_order_relaxed);
+}
+
+namespace detail {
+
+void runParallel(size_t begin, size_t end, unsigned n_threads, RangeFn range, void* fn) {
+    size_t count = end - begin;
+    unsigned limit = concurrency_limit.load(std::memory_order_relaxed);
+    size_t n_slots = n_threads == 0 ? defaultConcurrency() : n_threads;
+    if (limit != 0) n_slots = std::min<size_t>(n_slots, limit);
+#ifndef SCALATRIX_NO_THREADS
+    // pool workers live until exit, so never start more than there are cores
+    n_slots = std::min<size_t>(n_slots, hardwareConcurrency());
+#endif
+    n_slots = std::min(n_slots, count);
+#ifdef SCALATRIX_NO_THREADS
+    n_slots = 1;
+#endif
+    if (n_slots <= 1 || inside_parallel_for) {
+        std::exception_ptr error;
+        range(fn, begin, end, error);
+        if (error) std::rethrow_exception(error);
+        return;
+    }
+
+#ifndef SCALATRIX_NO_THREADS
+    Job job;
+    job.range = range;
+    job.fn = fn;
+    job.n_slots = (unsigned)n_slots;
+    // chunks small enough to rebalance, large enough to amortise the block locks
+    job.grain = std::max<size_t>(1, count / (n_slots * 16));
+    job.blocks.reset(new Block[n_slots]);
+    for (size_t s = 0; s < n_slots; ++s) {
+        job.blocks[s].next = begin + count * s / n_slots;
+        job.blocks[s].end = begin + count * (s + 1) / n_slots;
+    }
+    ThreadPool::shared().run(job);
+    if (job.error) std::rethrow_exception(job.error);
+#endif
+}
+
+} // namespace detail
+
+} // namespace scalatrix
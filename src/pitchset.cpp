@@ -1,8 +1,14 @@
 #include "scalatrix/pitchset.hpp"
+#include "scalatrix/primes.hpp"
+#include "scalatrix/ji.hpp"
 #include <numeric>
 #include <sstream>
 #include <algorithm>
+#include <cassert>
+#include <charconv>
 #include <cmath>
+#include <cstdint>
+#include <queue>
 
 const int PRIMES[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61, 67, 71, 73, 79, 83, 89, 97};
 
@@ -11,16 +17,20 @@ namespace scalatrix {
 
 PseudoPrimeInt pseudoPrimeFromIndexNumber(unsigned int index) {
     PseudoPrimeInt p;
-    p.label = std::to_string(PRIMES[index]);
-    p.number = PRIMES[index];
+    if (index < sizeof(PRIMES) / sizeof(PRIMES[0])) {
+        p.number = PRIMES[index];
+    } else {
+        p.number = PrimeSieve::sharedWithPrimeCount(index)->primes()[index];
+    }
+    p.label = std::to_string(p.number);
     p.log2fr = log2(p.number);
     return p;
 };
 
 
 PrimeList generateDefaultPrimeList(int n_primes) {
-    n_primes = std::min(n_primes, 25);
     PrimeList primes;
+    primes.reserve(std::max(n_primes, 0));
     for (int i = 0; i < n_primes; i++) {
         PseudoPrimeInt p = pseudoPrimeFromIndexNumber(i);
         primes.push_back(p);
@@ -39,9 +49,7 @@ PitchSet generateETPitchSet(unsigned int n_et, double equave_log2fr, double min_
     int max_step = (int)floor(max_log2fr * n_et / equave_log2fr);
     
     for (int i = min_step; i <= max_step; i++) {
-        PitchSetPitch p;
-        p.label = std::to_string(i) + "\\" + std::to_string(n_et);
-        p.log2fr = i * equave_log2fr / n_et;
+        PitchSetPitch p = PitchSetPitch::fromEDOSteps(i, n_et, i * equave_log2fr / n_et);
         
         // Filter to ensure the pitch is within the specified range
         if (p.log2fr >= min_log2fr - 1e-6 && p.log2fr <= max_log2fr + 1e-6) {
@@ -60,54 +68,8 @@ PitchSet generateETPitchSet(unsigned int n_et, double equave_log2fr, double min_
 };
 
 PitchSet generateJIPitchSet(PrimeList primes, int max_numorden, double min_log2fr, double max_log2fr) {
-    PitchSet pitchset;
-    PrimeList nums;
-    // generate all numbers with prime factors in primes up to max_numorden
-    for (int i = 1; i < max_numorden; i++) {
-        int r = i;
-        double log2fr = 0.0;
-        for (auto p : primes) {
-            while (r % p.number == 0) {
-                r /= p.number;
-                log2fr += p.log2fr;
-            }
-        }
-        bool include = r == 1;
-        if(include){
-            PseudoPrimeInt p;
-            p.label = std::to_string(i);
-            p.number = i;
-            p.log2fr = log2fr;
-            nums.push_back(p);
-        }
-    }
-    for (auto num: nums){
-        for (auto den: nums){
-            if (std::gcd(num.number, den.number) > 1){
-                continue;
-            }
-            if (num.number <= max_numorden && den.number <= max_numorden) {
-                PitchSetPitch pitch;
-                pitch.label = num.label + ":" + den.label;
-                pitch.log2fr = num.log2fr - den.log2fr;
-                pitchset.push_back(pitch);
-            }
-        }
-    }
-    // filter out pitches with log2fr outside of min_log2fr and max_log2fr
-    PitchSet filtered_pitchset;
-    for (auto pitch : pitchset) {
-        if (pitch.log2fr > min_log2fr - 1e-6 && pitch.log2fr < max_log2fr + 1e-6) {
-            filtered_pitchset.push_back(pitch);
-        }
-    }
-    // sort
-    std::sort(filtered_pitchset.begin(), filtered_pitchset.end(), 
-        [](PitchSetPitch a, PitchSetPitch b) {
-            return a.log2fr < b.log2fr;
-        }
-    );
-    return filtered_pitchset;
+    // ratios come out of the stream already sorted, labels are formatted once per ratio
+    return jiRatiosToPitchSet(generateJIRatios(primes, max_numorden, min_log2fr, max_log2fr));
 };
 
 
@@ -120,23 +82,13 @@ PitchSet generateHarmonicSeriesPitchSet(PrimeList primes, int base, double min_l
     // For max_log2fr: num/base <= 2^max_log2fr, so num <= base * 2^max_log2fr
     int min_num = std::max(1, (int)ceil(base * exp2(min_log2fr)));
     int max_num = (int)floor(base * exp2(max_log2fr));
+    PrimeListFactorizer factorizer(primes, std::max(max_num, 1));
     
     for (int num = min_num; num <= max_num; num++) {
-        PitchSetPitch pitch;
-        // Simplify the fraction by dividing by GCD
-        int gcd = std::gcd(num, base);
-        int simplified_num = num / gcd;
-        int simplified_base = base / gcd;
-        pitch.label = std::to_string(simplified_num) + ":" + std::to_string(simplified_base);
-        pitch.log2fr = -base_log2fr;
-        int r = num;
-        for (auto p : primes) {
-            while (r % p.number == 0) {
-                r /= p.number;
-                pitch.log2fr += p.log2fr;
-            }
-        }
-        pitch.log2fr += log2(r);
+        double num_log2fr;
+        factorizer.log2fr(num, num_log2fr, true);
+        // fromRatio simplifies the fraction by dividing by GCD
+        PitchSetPitch pitch = PitchSetPitch::fromRatio(num, base, num_log2fr - base_log2fr);
         
         // Filter pitches to ensure they're within the specified range
         if (pitch.log2fr >= min_log2fr - 1e-6 && pitch.log2fr <= max_log2fr + 1e-6) {
@@ -145,70 +97,109 @@ PitchSet generateHarmonicSeriesPitchSet(PrimeList primes, int base, double min_l
     }
     
     std::sort(pitchset.begin(), pitchset.end(), 
-        [](PitchSetPitch a, PitchSetPitch b) {
+        [](const PitchSetPitch& a, const PitchSetPitch& b) {
             return a.log2fr < b.log2fr;
         }
     );
     return pitchset;
 };
 
-PitchSetPitch operator+(const PitchSetPitch& a, const PitchSetPitch& b) {
-    PitchSetPitch result;
-    result.log2fr = a.log2fr + b.log2fr;
-    
-    // Parse label formats
-    auto parseRatio = [](const std::string& label) -> std::pair<bool, std::pair<int, int>> {
-        size_t colonPos = label.find(':');
-        if (colonPos != std::string::npos) {
-            try {
-                int num = std::stoi(label.substr(0, colonPos));
-                int den = std::stoi(label.substr(colonPos + 1));
-                return {true, {num, den}};
-            } catch (...) {
-                return {false, {0, 0}};
-            }
-        }
-        return {false, {0, 0}};
-    };
-    
-    auto parseET = [](const std::string& label) -> std::pair<bool, std::pair<int, int>> {
-        size_t backslashPos = label.find('\\');
-        if (backslashPos != std::string::npos) {
-            try {
-                int num = std::stoi(label.substr(0, backslashPos));
-                int den = std::stoi(label.substr(backslashPos + 1));
-                return {true, {num, den}};
-            } catch (...) {
-                return {false, {0, 0}};
-            }
-        }
-        return {false, {0, 0}};
-    };
-    
-    auto [isRatioA, ratioA] = parseRatio(a.label);
-    auto [isRatioB, ratioB] = parseRatio(b.label);
-    auto [isETA, etA] = parseET(a.label);
-    auto [isETB, etB] = parseET(b.label);
-    
-    if (isRatioA && isRatioB) {
+static std::string formatPitchLabel(long long num, char separator, long long den) {
+    char buf[48];
+    // the numerator may not take the last byte, which the separator needs
+    char* p = std::to_chars(buf, buf + sizeof(buf) - 1, num).ptr;
+    *p++ = separator;
+    p = std::to_chars(p, buf + sizeof(buf), den).ptr;
+    return std::string(buf, p);
+}
+
+static bool parseInteger(const char* first, const char* last, long long& value) {
+    auto res = std::from_chars(first, last, value);
+    return first != last && res.ec == std::errc() && res.ptr == last;
+}
+
+/*static*/
+PitchSetPitch PitchSetPitch::fromRatio(long long num, long long den, double log2fr) {
+    assert(den != 0);
+    if (den < 0) {
+        num = -num;
+        den = -den;
+    }
+    long long g = std::gcd(num, den);
+    if (g > 1) {
+        num /= g;
+        den /= g;
+    }
+    return fromReducedRatio(num, den, log2fr);
+}
+
+/*static*/
+PitchSetPitch PitchSetPitch::fromReducedRatio(long long num, long long den, double log2fr) {
+    return {formatPitchLabel(num, ':', den), log2fr, RatioPitch, num, den};
+}
+
+/*static*/
+PitchSetPitch PitchSetPitch::fromEDOSteps(long long steps, long long divisions, double log2fr) {
+    return {formatPitchLabel(steps, '\\', divisions), log2fr, EDOPitch, steps, divisions};
+}
+
+/*static*/
+PitchSetPitch PitchSetPitch::fromLabel(const std::string& label, double log2fr) {
+    PitchSetPitch pitch{label, log2fr};
+    const char* first = label.data();
+    const char* last = first + label.size();
+    size_t pos = label.find_first_of(":\\");
+    long long num, den;
+    if (pos == std::string::npos || !parseInteger(first, first + pos, num) || !parseInteger(first + pos + 1, last, den)) {
+        return pitch;
+    }
+    if (label[pos] == ':') {
+        if (den == 0) return pitch;
+        long long g = std::gcd(num, den);
+        if (den < 0) g = -g;
+        pitch.kind = RatioPitch;
+        pitch.num = num / g;
+        pitch.den = den / g;
+    } else {
+        pitch.kind = EDOPitch;
+        pitch.num = num;
+        pitch.den = den;
+    }
+    return pitch;
+}
+
+bool PitchSetPitch::sameValue(const PitchSetPitch& other) const {
+    if (kind == RatioPitch && other.kind == RatioPitch) {
+        return num == other.num && den == other.den;
+    }
+    if (kind == EDOPitch && other.kind == EDOPitch) {
+        return num * other.den == other.num * den;
+    }
+    return std::abs(log2fr - other.log2fr) <= 1e-9;
+}
+
+// Structured copy of a pitch, parsing the label only if the generator did not record its value
+static PitchSetPitch structured(const PitchSetPitch& pitch) {
+    return pitch.kind == UnknownPitch ? PitchSetPitch::fromLabel(pitch.label, pitch.log2fr) : pitch;
+}
+
+// Sum of two pitches that structured() has already been applied to
+static PitchSetPitch addStructured(const PitchSetPitch& sa, const PitchSetPitch& sb) {
+    double log2fr = sa.log2fr + sb.log2fr;
+    if (sa.kind == RatioPitch && sb.kind == RatioPitch) {
         // Both are ratios: multiply fractions and simplify
-        int newNum = ratioA.first * ratioB.first;
-        int newDen = ratioA.second * ratioB.second;
-        int gcd = std::gcd(newNum, newDen);
-        newNum /= gcd;
-        newDen /= gcd;
-        result.label = std::to_string(newNum) + ":" + std::to_string(newDen);
-    } else if (isETA && isETB && etA.second == etB.second) {
+        return PitchSetPitch::fromRatio(sa.num * sb.num, sa.den * sb.den, log2fr);
+    }
+    if (sa.kind == EDOPitch && sb.kind == EDOPitch && sa.den == sb.den) {
         // Both are ET fractions with same denominator: add numerators
-        int newNum = etA.first + etB.first;
-        int den = etA.second;
-        result.label = std::to_string(newNum) + "\\" + std::to_string(den);
-    } else {
-        // Incompatible formats or different denominators - return empty label
-        result.label = "";
+        return PitchSetPitch::fromEDOSteps(sa.num + sb.num, sa.den, log2fr);
     }
-    
-    return result;
+    // Incompatible formats or different denominators - return empty label
+    return {"", log2fr};
+}
+
+PitchSetPitch operator+(const PitchSetPitch& a, const PitchSetPitch& b) {
+    return addStructured(structured(a), structured(b));
 }
 
 PitchSetPitch operator*(int multiplier, const PitchSetPitch& pitch) {
@@ -216,92 +207,136 @@ PitchSetPitch operator*(int multiplier, const PitchSetPitch& pitch) {
 }
 
 PitchSetPitch operator*(const PitchSetPitch& pitch, int multiplier) {
-    PitchSetPitch result;
-    result.log2fr = multiplier * pitch.log2fr;
-    
-    // Parse label formats
-    auto parseRatio = [](const std::string& label) -> std::pair<bool, std::pair<int, int>> {
-        size_t colonPos = label.find(':');
-        if (colonPos != std::string::npos) {
-            try {
-                int num = std::stoi(label.substr(0, colonPos));
-                int den = std::stoi(label.substr(colonPos + 1));
-                return {true, {num, den}};
-            } catch (...) {
-                return {false, {0, 0}};
-            }
-        }
-        return {false, {0, 0}};
-    };
-    
-    auto parseET = [](const std::string& label) -> std::pair<bool, std::pair<int, int>> {
-        size_t backslashPos = label.find('\\');
-        if (backslashPos != std::string::npos) {
-            try {
-                int num = std::stoi(label.substr(0, backslashPos));
-                int den = std::stoi(label.substr(backslashPos + 1));
-                return {true, {num, den}};
-            } catch (...) {
-                return {false, {0, 0}};
-            }
+    double log2fr = multiplier * pitch.log2fr;
+    PitchSetPitch sp = structured(pitch);
+
+    if (sp.kind == RatioPitch) {
+        // For ratios: integer is the power, a negative power inverts the ratio
+        long long newNum = 1;
+        long long newDen = 1;
+        for (int i = 0; i < std::abs(multiplier); i++) {
+            newNum *= sp.num;
+            newDen *= sp.den;
         }
-        return {false, {0, 0}};
-    };
-    
-    auto [isRatio, ratio] = parseRatio(pitch.label);
-    auto [isET, et] = parseET(pitch.label);
-    
-    if (isRatio) {
-        // For ratios: integer is the power
-        // multiplier * (num:den) = num^multiplier : den^multiplier
-        if (multiplier >= 0) {
-            long long newNum = 1;
-            long long newDen = 1;
-            
-            // Calculate num^multiplier and den^multiplier
-            for (int i = 0; i < multiplier; i++) {
-                newNum *= ratio.first;
-                newDen *= ratio.second;
-            }
-            
-            // Simplify with GCD
-            long long gcd = std::gcd(newNum, newDen);
-            newNum /= gcd;
-            newDen /= gcd;
-            
-            result.label = std::to_string(newNum) + ":" + std::to_string(newDen);
+        if (multiplier < 0) std::swap(newNum, newDen);
+        return PitchSetPitch::fromRatio(newNum, newDen, log2fr);
+    }
+    if (sp.kind == EDOPitch) {
+        // For ET: multiply the numerator
+        return PitchSetPitch::fromEDOSteps(multiplier * sp.num, sp.den, log2fr);
+    }
+    // Unknown format - return empty label
+    return {"", log2fr};
+}
+
+namespace {
+
+const double SAME_PITCH_LOG2FR = 1e-9;
+
+// only the asserts use it
+[[maybe_unused]] bool log2frLess(const PitchSetPitch& a, const PitchSetPitch& b) {
+    return a.log2fr < b.log2fr;
+}
+
+// Appends pitch unless the sorted output already ends with a pitch of the same value
+void appendUnique(PitchSet& out, const PitchSetPitch& pitch) {
+    for (auto it = out.rbegin(); it != out.rend() && pitch.log2fr - it->log2fr <= SAME_PITCH_LOG2FR; ++it) {
+        if (it->sameValue(pitch)) return;
+    }
+    out.push_back(pitch);
+}
+
+} // namespace
+
+PitchSet pitchSetUnion(const PitchSet& a, const PitchSet& b) {
+    assert(std::is_sorted(a.begin(), a.end(), log2frLess));
+    assert(std::is_sorted(b.begin(), b.end(), log2frLess));
+    PitchSet result;
+    result.reserve(a.size() + b.size());
+    size_t i = 0, j = 0;
+    while (i < a.size() || j < b.size()) {
+        if (j == b.size() || (i < a.size() && a[i].log2fr <= b[j].log2fr)) {
+            appendUnique(result, a[i++]);
         } else {
-            // Negative multiplier: invert and raise to positive power
-            int posMultiplier = -multiplier;
-            long long newNum = 1;
-            long long newDen = 1;
-            
-            // Calculate den^|multiplier| : num^|multiplier| (inverted)
-            for (int i = 0; i < posMultiplier; i++) {
-                newNum *= ratio.second;  // denominator becomes numerator
-                newDen *= ratio.first;   // numerator becomes denominator
+            appendUnique(result, b[j++]);
+        }
+    }
+    return result;
+}
+
+PitchSet pitchSetIntersection(const PitchSet& a, const PitchSet& b, double tolerance_cents) {
+    assert(std::is_sorted(a.begin(), a.end(), log2frLess));
+    assert(std::is_sorted(b.begin(), b.end(), log2frLess));
+    const double tolerance = std::max(tolerance_cents / 1200.0, SAME_PITCH_LOG2FR);
+    PitchSet result;
+    size_t j = 0;
+    for (const auto& pitch : a) {
+        while (j < b.size() && b[j].log2fr < pitch.log2fr - tolerance) ++j;
+        // b[j..] is the window of candidates within tolerance, it only moves forward
+        bool found = false;
+        for (size_t k = j; k < b.size() && b[k].log2fr <= pitch.log2fr + tolerance; ++k) {
+            if (tolerance_cents > 0.0 || pitch.sameValue(b[k])) {
+                found = true;
+                break;
             }
-            
-            // Simplify with GCD
-            long long gcd = std::gcd(newNum, newDen);
-            newNum /= gcd;
-            newDen /= gcd;
-            
-            result.label = std::to_string(newNum) + ":" + std::to_string(newDen);
         }
-    } else if (isET) {
-        // For ET: multiply the numerator
-        // multiplier * (num\\den) = (multiplier * num)\\den
-        int newNum = multiplier * et.first;
-        int den = et.second;
-        result.label = std::to_string(newNum) + "\\" + std::to_string(den);
-    } else {
-        // Unknown format - return empty label
-        result.label = "";
+        if (found) appendUnique(result, pitch);
+    }
+    return result;
+}
+
+PitchSet transposePitchSet(const PitchSet& pitchset, const PitchSetPitch& interval) {
+    PitchSetPitch step = structured(interval);
+    PitchSet result;
+    result.reserve(pitchset.size());
+    for (const auto& pitch : pitchset) {
+        result.push_back(pitch + step);
     }
-    
     return result;
 }
 
+PitchSet stackPitchSets(const PitchSet& a, const PitchSet& b, double min_log2fr, double max_log2fr) {
+    assert(std::is_sorted(b.begin(), b.end(), log2frLess));
+    struct Cursor {
+        double log2fr;
+        uint32_t i, j;
+    };
+    auto greater = [](const Cursor& x, const Cursor& y) {
+        if (x.log2fr != y.log2fr) return x.log2fr > y.log2fr;
+        if (x.i != y.i) return x.i > y.i;
+        return x.j > y.j;
+    };
+    std::priority_queue<Cursor, std::vector<Cursor>, decltype(greater)> heap(greater);
+
+    // labels are parsed once per pitch, not once per sum
+    std::vector<PitchSetPitch> sb;
+    sb.reserve(b.size());
+    for (const PitchSetPitch& pitch : b) sb.push_back(structured(pitch));
+
+    // every pitch of a opens a row over b at the first sum inside the range
+    std::vector<PitchSetPitch> sa;
+    sa.reserve(a.size());
+    for (uint32_t i = 0; i < a.size(); ++i) {
+        sa.push_back(structured(a[i]));
+        double target = min_log2fr - a[i].log2fr;
+        uint32_t j = (uint32_t)(std::lower_bound(b.begin(), b.end(), target, [](const PitchSetPitch& p, double v) {
+            return p.log2fr < v;
+        }) - b.begin());
+        while (j < b.size() && a[i].log2fr + b[j].log2fr < min_log2fr) ++j;
+        if (j < b.size()) heap.push({a[i].log2fr + b[j].log2fr, i, j});
+    }
+
+    PitchSet result;
+    while (!heap.empty() && heap.top().log2fr <= max_log2fr) {
+        Cursor c = heap.top();
+        heap.pop();
+        appendUnique(result, addStructured(sa[c.i], sb[c.j]));
+        if (++c.j < b.size()) {
+            c.log2fr = a[c.i].log2fr + b[c.j].log2fr;
+            heap.push(c);
+        }
+    }
+    return result;
+}
 
 };
\ No newline at end of file
@@ -0,0 +1,401 @@
+#include "scalatrix/pitchset_index.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#endif
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace scalatrix {
+
+namespace {
+
+/**
+ * Binary image: this header, then the columns in the order of Layout, each starting at a
+ * multiple of 8 bytes. Values are stored in native byte order, byte_order detects files
+ * written on a machine of the other endianness.
+ */
+struct FileHeader {
+    char magic[8];          // "SCXPSET" and a terminating zero
+    uint32_t version;
+    uint32_t byte_order;    // BYTE_ORDER_MARK as written
+    uint64_t count;         // number of pitches
+    uint64_t label_bytes;   // size of the label string table
+    double equave_log2fr;
+    uint64_t reserved[3];
+};
+static_assert(sizeof(FileHeader) == 64, "FileHeader must stay 64 bytes");
+
+const char MAGIC[8] = {'S', 'C', 'X', 'P', 'S', 'E', 'T', 0};
+const uint32_t VERSION = 1;
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+uint64_t align8(uint64_t n) { return (n + 7) & ~uint64_t(7); }
+
+// Largest count and label_bytes of a valid file; the layout then fits in 64 bits
+const uint64_t MAX_FIELD = 0xFFFFFFFFull;
+
+/**
+ * Byte offsets of the columns for count pitches and label_bytes of label text. Computed in
+ * 64 bits, which cannot overflow for count and label_bytes up to MAX_FIELD, so the total
+ * of a corrupt header is caught by fits() instead of wrapping around a 32-bit size_t.
+ */
+struct Layout {
+    uint64_t log2fr, reduced, num, den, reduced_order, label_offsets, kind, labels, total;
+
+    Layout(uint64_t count, uint64_t label_bytes) {
+        assert(count <= MAX_FIELD && label_bytes <= MAX_FIELD);
+        log2fr = sizeof(FileHeader);
+        reduced = log2fr + count * sizeof(double);
+        num = reduced + count * sizeof(double);
+        den = num + count * sizeof(int64_t);
+        reduced_order = den + count * sizeof(int64_t);
+        label_offsets = align8(reduced_order + count * sizeof(uint32_t));
+        kind = align8(label_offsets + (count + 1) * sizeof(uint32_t));
+        labels = align8(kind + count);
+        total = align8(labels + label_bytes);
+    }
+
+    bool fits(size_t size) const {
+        return total <= (uint64_t)std::numeric_limits<size_t>::max() && (size_t)total == size;
+    }
+};
+
+} // namespace
+
+// Owns the image, either as an 8-byte aligned buffer or as a read-only file mapping
+struct PitchSetIndex::Storage {
+    std::vector<uint64_t> buffer;
+    void* mapping = nullptr;
+    size_t mapping_size = 0;
+    const char* data = nullptr;
+    size_t size = 0;
+
+    Storage() = default;
+    Storage(const Storage&) = delete;
+    Storage& operator=(const Storage&) = delete;
+    ~Storage() {
+#if !defined(_WIN32)
+        if (mapping) munmap(mapping, mapping_size);
+#endif
+    }
+};
+
+PitchSetIndex::PitchSetIndex(const PitchSet& pitchset, double equave_log2fr) {
+    assert(equave_log2fr > 0.0);
+    assert(pitchset.size() < 0xFFFFFFFFull);
+    const size_t n = pitchset.size();
+    std::vector<uint32_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&pitchset](uint32_t a, uint32_t b) {
+        return pitchset[a].log2fr < pitchset[b].log2fr;
+    });
+
+    std::vector<std::pair<double, uint32_t>> keys;
+    keys.reserve(n);
+    uint64_t label_bytes = 0;
+    for (size_t i = 0; i < n; ++i) {
+        double l = pitchset[order[i]].log2fr;
+        double r = l - std::floor(l / equave_log2fr) * equave_log2fr;
+        if (r >= equave_log2fr) r = 0.0;
+        keys.push_back({r, (uint32_t)i});
+        label_bytes += pitchset[order[i]].label.size();
+    }
+    assert(label_bytes < MAX_FIELD);
+    std::stable_sort(keys.begin(), keys.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+
+    Layout layout(n, label_bytes);
+    auto storage = std::make_shared<Storage>();
+    storage->buffer.assign((size_t)(layout.total / sizeof(uint64_t)), 0);
+    char* data = reinterpret_cast<char*>(storage->buffer.data());
+    storage->data = data;
+    storage->size = (size_t)layout.total;
+
+    FileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.count = n;
+    header.label_bytes = label_bytes;
+    header.equave_log2fr = equave_log2fr;
+    std::memcpy(data, &header, sizeof(header));
+
+    double* log2frs = reinterpret_cast<double*>(data + layout.log2fr);
+    double* reduced = reinterpret_cast<double*>(data + layout.reduced);
+    int64_t* nums = reinterpret_cast<int64_t*>(data + layout.num);
+    int64_t* dens = reinterpret_cast<int64_t*>(data + layout.den);
+    uint32_t* reduced_order = reinterpret_cast<uint32_t*>(data + layout.reduced_order);
+    uint32_t* label_offsets = reinterpret_cast<uint32_t*>(data + layout.label_offsets);
+    uint8_t* kinds = reinterpret_cast<uint8_t*>(data + layout.kind);
+    char* labels = data + layout.labels;
+    uint32_t offset = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const PitchSetPitch& p = pitchset[order[i]];
+        log2frs[i] = p.log2fr;
+        nums[i] = p.num;
+        dens[i] = p.den;
+        kinds[i] = (uint8_t)p.kind;
+        label_offsets[i] = offset;
+        std::memcpy(labels + offset, p.label.data(), p.label.size());
+        offset += (uint32_t)p.label.size();
+        reduced[i] = keys[i].first;
+        reduced_order[i] = keys[i].second;
+    }
+    label_offsets[n] = offset;
+
+    storage_ = std::move(storage);
+    bindColumns();
+}
+
+void PitchSetIndex::bindColumns() {
+    const char* data = storage_->data;
+    FileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    Layout layout(header.count, header.label_bytes);
+    size_ = (size_t)header.count;
+    equave_ = header.equave_log2fr;
+    log2frs_ = reinterpret_cast<const double*>(data + layout.log2fr);
+    reduced_ = reinterpret_cast<const double*>(data + layout.reduced);
+    nums_ = reinterpret_cast<const int64_t*>(data + layout.num);
+    dens_ = reinterpret_cast<const int64_t*>(data + layout.den);
+    reduced_order_ = reinterpret_cast<const uint32_t*>(data + layout.reduced_order);
+    label_offsets_ = reinterpret_cast<const uint32_t*>(data + layout.label_offsets);
+    kinds_ = reinterpret_cast<const uint8_t*>(data + layout.kind);
+    labels_ = data + layout.labels;
+}
+
+/*static*/
+PitchSetIndex PitchSetIndex::load(const std::string& path) {
+    auto storage = std::make_shared<Storage>();
+#if !defined(_WIN32)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Cannot open pitch set file " + path);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(FileHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Not a pitch set file: " + path);
+    }
+    void* mapping = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) throw std::runtime_error("Cannot map pitch set file " + path);
+    storage->mapping = mapping;
+    storage->mapping_size = (size_t)st.st_size;
+    storage->data = static_cast<const char*>(mapping);
+    storage->size = (size_t)st.st_size;
+#else
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) throw std::runtime_error("Cannot open pitch set file " + path);
+    size_t size = (size_t)in.tellg();
+    storage->buffer.assign((size_t)(align8(size) / sizeof(uint64_t)), 0);
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(storage->buffer.data()), size);
+    if (!in || size < sizeof(FileHeader)) throw std::runtime_error("Not a pitch set file: " + path);
+    storage->data = reinterpret_cast<const char*>(storage->buffer.data());
+    storage->size = size;
+#endif
+
+    FileHeader header;
+    std::memcpy(&header, storage->data, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+        header.byte_order != BYTE_ORDER_MARK || header.count >= MAX_FIELD || header.label_bytes >= MAX_FIELD ||
+        !Layout(header.count, header.label_bytes).fits(storage->size)) {
+        throw std::runtime_error("Not a pitch set file: " + path);
+    }
+
+    PitchSetIndex index;
+    index.storage_ = std::move(storage);
+    index.bindColumns();
+    // label offsets index the string table, check them once instead of on every access
+    for (size_t i = 0; i < index.size_; ++i) {
+        if (index.label_offsets_[i] > index.label_offsets_[i + 1]) {
+            throw std::runtime_error("Corrupt label table in pitch set file " + path);
+        }
+    }
+    if (index.label_offsets_[index.size_] != header.label_bytes) {
+        throw std::runtime_error("Corrupt label table in pitch set file " + path);
+    }
+    // nearestReduced returns reduced_order entries as positions and kind() casts the bytes
+    for (size_t i = 0; i < index.size_; ++i) {
+        if (index.reduced_order_[i] >= index.size_ || index.kinds_[i] > EDOPitch) {
+            throw std::runtime_error("Corrupt pitch columns in pitch set file " + path);
+        }
+    }
+    return index;
+}
+
+void PitchSetIndex::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(storage_->data, (std::streamsize)storage_->size);
+    if (!out) throw std::runtime_error("Cannot write pitch set file " + path);
+}
+
+PitchSetPitch PitchSetIndex::pitch(size_t i) const {
+    return {std::string(label(i)), log2frs_[i], kind(i), nums_[i], dens_[i]};
+}
+
+PitchSet PitchSetIndex::toPitchSet() const {
+    PitchSet pitchset;
+    pitchset.reserve(size_);
+    for (size_t i = 0; i < size_; ++i) pitchset.push_back(pitch(i));
+    return pitchset;
+}
+
+size_t PitchSetIndex::lowerBound(double log2fr) const {
+    return std::lower_bound(log2frs_, log2frs_ + size_, log2fr) - log2frs_;
+}
+
+size_t PitchSetIndex::nearestAround(size_t lb, double log2fr) const {
+    if (lb == size_) return lb - 1;
+    if (lb == 0) return 0;
+    // the lower neighbour wins ties; lower_bound already points at the first of equal values
+    if (log2fr - log2frs_[lb - 1] <= log2frs_[lb] - log2fr) {
+        size_t i = lb - 1;
+        while (i > 0 && log2frs_[i - 1] == log2frs_[i]) --i;
+        return i;
+    }
+    return lb;
+}
+
+size_t PitchSetIndex::nearest(double log2fr) const {
+    assert(!empty());
+    return nearestAround(lowerBound(log2fr), log2fr);
+}
+
+std::vector<size_t> PitchSetIndex::kNearest(double log2fr, size_t k) const {
+    k = std::min(k, size());
+    std::vector<size_t> result;
+    result.reserve(k);
+    // expand outwards from the insertion point, taking the closer side each step
+    size_t hi = lowerBound(log2fr);
+    size_t lo = hi;
+    while (result.size() < k) {
+        bool take_lo = lo > 0 && (hi == size() || log2fr - log2frs_[lo - 1] <= log2frs_[hi] - log2fr);
+        if (take_lo) {
+            result.push_back(--lo);
+        } else {
+            result.push_back(hi++);
+        }
+    }
+    return result;
+}
+
+std::pair<size_t, size_t> PitchSetIndex::range(double min_log2fr, double max_log2fr) const {
+    size_t first = lowerBound(min_log2fr);
+    size_t last = std::upper_bound(log2frs_ + first, log2frs_ + size_, max_log2fr) - log2frs_;
+    return {first, std::max(first, last)};
+}
+
+size_t PitchSetIndex::nearestReduced(double log2fr, double& matched_log2fr) const {
+    assert(!empty());
+    double base = std::floor(log2fr / equave_) * equave_;
+    double r = log2fr - base;
+    size_t lb = std::lower_bound(reduced_, reduced_ + size_, r) - reduced_;
+
+    // neighbours in the circular order, wrapping around the equave
+    size_t upper = lb < size_ ? lb : 0;
+    size_t lower = lb > 0 ? lb - 1 : size_ - 1;
+    double upper_key = lb < size_ ? reduced_[upper] : reduced_[upper] + equave_;
+    double lower_key = lb > 0 ? reduced_[lower] : reduced_[lower] - equave_;
+    if (r - lower_key <= upper_key - r) {
+        matched_log2fr = base + lower_key;
+        return reduced_order_[lower];
+    }
+    matched_log2fr = base + upper_key;
+    return reduced_order_[upper];
+}
+
+namespace {
+
+constexpr size_t SEARCH_BLOCK = 16;
+
+// Branchless lower bounds of the m <= SEARCH_BLOCK queries x in the sorted a[0, size): the
+// step sequence depends only on size, so all queries of the block step together
+void lowerBoundBlock(const double* a, size_t size, const double* x, size_t m, uint32_t* out) {
+#if defined(__wasm_simd128__)
+    // two queries per lane pair: positions in an i64x2, one f64x2 compare per step and the
+    // half added through the compare mask; an odd last query is paired with itself
+    constexpr size_t PAIRS = SEARCH_BLOCK / 2;
+    v128_t pos[PAIRS], query[PAIRS];
+    const size_t pairs = (m + 1) / 2;
+    for (size_t p = 0; p < pairs; ++p) {
+        size_t j = 2 * p;
+        query[p] = wasm_f64x2_make(x[j], x[std::min(j + 1, m - 1)]);
+        pos[p] = wasm_i64x2_splat(0);
+    }
+    for (size_t len = size; len > 1;) {
+        const uint64_t half = len / 2;
+        const v128_t step = wasm_i64x2_splat((int64_t)half);
+        for (size_t p = 0; p < pairs; ++p) {
+            size_t p0 = (size_t)wasm_i64x2_extract_lane(pos[p], 0);
+            size_t p1 = (size_t)wasm_i64x2_extract_lane(pos[p], 1);
+            v128_t probe = wasm_f64x2_make(a[p0 + half - 1], a[p1 + half - 1]);
+            v128_t less = wasm_f64x2_lt(probe, query[p]);
+            pos[p] = wasm_i64x2_add(pos[p], wasm_v128_and(less, step));
+        }
+        len -= half;
+    }
+    for (size_t j = 0; j < m; ++j) {
+        size_t p = (size_t)(j % 2 == 0 ? wasm_i64x2_extract_lane(pos[j / 2], 0)
+                                       : wasm_i64x2_extract_lane(pos[j / 2], 1));
+        out[j] = (uint32_t)p + (a[p] < x[j] ? 1u : 0u);
+    }
+#else
+    uint32_t pos[SEARCH_BLOCK];
+    std::fill(pos, pos + m, 0u);
+    for (size_t len = size; len > 1;) {
+        const uint32_t half = (uint32_t)(len / 2);
+        for (size_t j = 0; j < m; ++j) {
+            pos[j] += (a[pos[j] + half - 1] < x[j]) ? half : 0u;
+        }
+        len -= half;
+    }
+    for (size_t j = 0; j < m; ++j) {
+        out[j] = pos[j] + (a[pos[j]] < x[j] ? 1u : 0u);
+    }
+#endif
+}
+
+} // namespace
+
+void PitchSetIndex::lowerBound(const double* log2frs, size_t n, uint32_t* out) const {
+    if (size_ == 0) {
+        std::fill(out, out + n, 0u);
+        return;
+    }
+    for (size_t q0 = 0; q0 < n; q0 += SEARCH_BLOCK) {
+        lowerBoundBlock(log2frs_, size_, log2frs + q0, std::min(SEARCH_BLOCK, n - q0), out + q0);
+    }
+}
+
+void PitchSetIndex::nearest(const double* log2frs, size_t n, uint32_t* out) const {
+    assert(!empty());
+    lowerBound(log2frs, n, out);
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = (uint32_t)nearestAround(out[i], log2frs[i]);
+    }
+}
+
+void writePitchSetFile(const std::string& path, const PitchSet& pitchset, double equave_log2fr) {
+    PitchSetIndex(pitchset, equave_log2fr).save(path);
+}
+
+PitchSet readPitchSetFile(const std::string& path) {
+    return PitchSetIndex::load(path).toPitchSet();
+}
+
+} // namespace scalatrix
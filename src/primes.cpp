@@ -0,0 +1,227 @@
+#include "scalatrix/primes.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <mutex>
+
+namespace scalatrix {
+
+/**
+ * Linear sieve: every composite n is crossed out exactly once, as p * (n / p) with
+ * p its smallest prime factor.
+ */
+PrimeSieve::PrimeSieve(unsigned int limit) : spf_(std::max(limit, 1u) + 1, 0) {
+    unsigned int n_max = limit;
+    for (unsigned int i = 2; i <= n_max; ++i) {
+        if (spf_[i] == 0) {
+            spf_[i] = i;
+            primes_.push_back(i);
+        }
+        for (unsigned int p : primes_) {
+            unsigned long long ip = (unsigned long long)i * p;
+            if (p > spf_[i] || ip > n_max) break;
+            spf_[ip] = p;
+        }
+    }
+}
+
+/*static*/
+std::shared_ptr<const PrimeSieve> PrimeSieve::shared(unsigned int limit) {
+    static std::mutex mutex;
+    static std::shared_ptr<const PrimeSieve> cached;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!cached || cached->limit() < limit) {
+        unsigned long long grown = cached ? 2ull * cached->limit() : 1024ull;
+        unsigned int new_limit = (unsigned int)std::min<unsigned long long>(
+            std::max<unsigned long long>(limit, grown), 0xFFFFFFFEull);
+        cached = std::make_shared<const PrimeSieve>(new_limit);
+    }
+    return cached;
+}
+
+/*static*/
+std::shared_ptr<const PrimeSieve> PrimeSieve::sharedWithPrimeCount(unsigned int n) {
+    auto sieve = shared(1024);
+    while (sieve->primes().size() <= n) {
+        sieve = shared(2 * sieve->limit());
+    }
+    return sieve;
+}
+
+PrimeListFactorizer::PrimeListFactorizer(const PrimeList& primes, unsigned int limit)
+    : limit_(limit) {
+    unsigned int max_number = 1;
+    for (const auto& p : primes) {
+        numbers_.push_back(p.number);
+        log2frs_.push_back(p.log2fr);
+        max_number = std::max(max_number, p.number);
+    }
+    sieve_ = PrimeSieve::shared(std::max(limit, max_number));
+
+    prime_basis_ = true;
+    index_.assign(max_number + 1, -1);
+    for (size_t i = 0; i < numbers_.size(); ++i) {
+        unsigned int p = numbers_[i];
+        if (!sieve_->isPrime(p) || index_[p] >= 0) {
+            prime_basis_ = false;
+            break;
+        }
+        index_[p] = (int)i;
+    }
+}
+
+bool PrimeListFactorizer::monzo(unsigned int n, std::vector<int>& exponents) const {
+    assert(n >= 1);
+    exponents.assign(numbers_.size(), 0);
+    if (!prime_basis_ || n > sieve_->limit()) {
+        // trial division by the list entries in order
+        for (size_t i = 0; i < numbers_.size(); ++i) {
+            if (numbers_[i] <= 1) continue;
+            while (n % numbers_[i] == 0) {
+                n /= numbers_[i];
+                exponents[i]++;
+            }
+        }
+        return n == 1;
+    }
+    while (n > 1) {
+        unsigned int p = sieve_->smallestFactor(n);
+        if (p >= index_.size() || index_[p] < 0) return false;
+        exponents[index_[p]]++;
+        n /= p;
+    }
+    return true;
+}
+
+bool PrimeListFactorizer::log2fr(unsigned int n, double& result, bool allow_cofactor) const {
+    assert(n >= 1);
+    result = 0.0;
+    unsigned int cofactor = 1;
+    if (!prime_basis_ || n > sieve_->limit()) {
+        for (size_t i = 0; i < numbers_.size(); ++i) {
+            if (numbers_[i] <= 1) continue;
+            while (n % numbers_[i] == 0) {
+                n /= numbers_[i];
+                result += log2frs_[i];
+            }
+        }
+        cofactor = n;
+    } else {
+        while (n > 1) {
+            unsigned int p = sieve_->smallestFactor(n);
+            if (p < index_.size() && index_[p] >= 0) {
+                result += log2frs_[index_[p]];
+            } else {
+                cofactor *= p;
+            }
+            n /= p;
+        }
+    }
+    if (cofactor != 1) {
+        if (!allow_cofactor) return false;
+        result += std::log2(cofactor);
+    }
+    return true;
+}
+
+std::vector<SmoothNumber> PrimeListFactorizer::smoothNumbers() const {
+    std::vector<SmoothNumber> result;
+    if (limit_ < 1) return result;
+    if (!prime_basis_) {
+        for (unsigned int n = 1; n <= limit_; ++n) {
+            double l;
+            if (log2fr(n, l)) result.push_back({n, l});
+        }
+        return result;
+    }
+
+    // n is smooth iff spf(n) is listed and n / spf(n) is smooth
+    std::vector<double> lg(limit_ + 1, 0.0);
+    std::vector<char> smooth(limit_ + 1, 0);
+    smooth[1] = 1;
+    result.push_back({1, 0.0});
+    for (unsigned int n = 2; n <= limit_; ++n) {
+        unsigned int p = sieve_->smallestFactor(n);
+        if (p >= index_.size() || index_[p] < 0 || !smooth[n / p]) continue;
+        smooth[n] = 1;
+        lg[n] = lg[n / p] + log2frs_[index_[p]];
+        result.push_back({n, lg[n]});
+    }
+    return result;
+}
+
+std::vector<SmoothNumber> smoothNumbers(const PrimeList& primes, unsigned int limit) {
+    return PrimeListFactorizer(primes, limit).smoothNumbers();
+}
+
+SmoothSequence::SmoothSequence(const PrimeList& primes)
+    : factorizer_(primes, 0), max_relative_tempering_(0.0), exhausted_(false) {
+    for (const auto& p : primes) {
+        if (p.number <= 1) continue;
+        factors_.push_back(p.number);
+        factor_log2frs_.push_back(p.log2fr);
+        double exact = std::log2((double)p.number);
+        max_relative_tempering_ = std::max(max_relative_tempering_, std::abs(p.log2fr - exact) / exact);
+    }
+    ptr_.assign(factors_.size(), 0);
+    products_.push_back(1);
+    product_log2frs_.push_back(0.0);
+    values_.push_back({1, 0.0});
+}
+
+bool SmoothSequence::extend() {
+    while (!exhausted_) {
+        unsigned long long next = ~0ull;
+        size_t best = 0;
+        for (size_t f = 0; f < factors_.size(); ++f) {
+            unsigned long long candidate = factors_[f] * products_[ptr_[f]];
+            if (candidate < next) {
+                next = candidate;
+                best = f;
+            }
+        }
+        if (factors_.empty() || next > 0xFFFFFFFFull) {
+            exhausted_ = true;
+            return false;
+        }
+        double log2fr = product_log2frs_[ptr_[best]] + factor_log2frs_[best];
+        for (size_t f = 0; f < factors_.size(); ++f) {
+            if (factors_[f] * products_[ptr_[f]] == next) ptr_[f]++;
+        }
+        products_.push_back(next);
+        product_log2frs_.push_back(log2fr);
+
+        if (factorizer_.hasPrimeBasis()) {
+            values_.push_back({(unsigned int)next, log2fr});
+            return true;
+        }
+        // pseudo-prime lists: a product of entries still has to pass list-order trial division
+        double l;
+        if (factorizer_.log2fr((unsigned int)next, l)) {
+            values_.push_back({(unsigned int)next, l});
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SmoothSequence::at(size_t i, SmoothNumber& out) {
+    while (values_.size() <= i) {
+        if (!extend()) return false;
+    }
+    out = values_[i];
+    return true;
+}
+
+size_t SmoothSequence::firstAtLeast(double exact_log2) {
+    while (std::log2((double)values_.back().number) < exact_log2) {
+        if (!extend()) return values_.size();
+    }
+    auto it = std::partition_point(values_.begin(), values_.end(), [exact_log2](const SmoothNumber& s) {
+        return std::log2((double)s.number) < exact_log2;
+    });
+    return (size_t)(it - values_.begin());
+}
+
+} // namespace scalatrix
@@ -1,10 +1,188 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>  // For std::vector, std::pair
+#include <pybind11/numpy.h>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <string>
 #include <scalatrix.hpp>
 
 namespace py = pybind11;
 using namespace scalatrix;
 
+namespace {
+
+// Byte offset of a Node field, measured on an instance since Node is not standard-layout
+template <typename Field>
+size_t nodeFieldOffset(Field Node::*field) {
+    static const Node probe;
+    return reinterpret_cast<const char*>(&(probe.*field)) - reinterpret_cast<const char*>(&probe);
+}
+
+// The field components of node i, columns values of type T
+template <typename T, typename Field>
+T* nodeField(std::vector<Node>& nodes, size_t i, Field Node::*field) {
+    return reinterpret_cast<T*>(reinterpret_cast<char*>(&nodes[i]) + nodeFieldOffset(field));
+}
+
+/**
+ * One field of every node copied into a new (N,) array for scalars or (N, 2) for vectors.
+ * The array owns its memory, so it stays valid when a recalc*() reallocates the nodes.
+ */
+template <typename T, typename Field>
+py::array_t<T> nodeFieldArray(Scale& scale, Field Node::*field, size_t columns) {
+    std::vector<Node>& nodes = scale.getNodes();
+    std::vector<py::ssize_t> shape{(py::ssize_t)nodes.size()};
+    if (columns > 1) shape.push_back((py::ssize_t)columns);
+    py::array_t<T> result(shape);
+    T* out = result.mutable_data();
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const T* values = nodeField<T>(nodes, i, field);
+        for (size_t j = 0; j < columns; ++j) out[i * columns + j] = values[j];
+    }
+    return result;
+}
+
+// Bulk write of one field of every node, the values must have the shape nodeFieldArray returns
+template <typename T, typename Field>
+void assignNodeField(Scale& scale, Field Node::*field, size_t columns, const py::array_t<T>& values) {
+    std::vector<Node>& nodes = scale.getNodes();
+    if (values.ndim() != (columns > 1 ? 2 : 1)) throw py::value_error("array has the wrong number of dimensions");
+    if (values.shape(0) != (py::ssize_t)nodes.size() || (columns > 1 && values.shape(1) != (py::ssize_t)columns)) {
+        throw py::value_error("array shape does not match the scale");
+    }
+    auto src = values.template unchecked<>();
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        T* dst = nodeField<T>(nodes, i, field);
+        if (columns > 1) {
+            for (size_t j = 0; j < columns; ++j) dst[j] = src((py::ssize_t)i, (py::ssize_t)j);
+        } else {
+            dst[0] = src((py::ssize_t)i);
+        }
+    }
+}
+
+// Arrays at least this long are processed with the GIL released
+const size_t GIL_RELEASE_THRESHOLD = 4096;
+
+using IntPairs = py::array_t<int, py::array::c_style | py::array::forcecast>;
+using DoublePairs = py::array_t<double, py::array::c_style | py::array::forcecast>;
+
+template <typename F>
+void runBatch(size_t n, F&& f) {
+    if (n >= GIL_RELEASE_THRESHOLD) {
+        py::gil_scoped_release release;
+        f();
+    } else {
+        f();
+    }
+}
+
+// An (N, 2) C-contiguous array read as N vectors of two components
+template <typename Vec, typename Array>
+const Vec* pairsOf(const Array& values) {
+    static_assert(sizeof(Vec) == 2 * sizeof(typename Array::value_type), "vector must be two packed components");
+    if (values.ndim() != 2 || values.shape(1) != 2) throw py::value_error("expected an (N, 2) array");
+    return reinterpret_cast<const Vec*>(values.data());
+}
+
+template <typename Vec>
+py::array_t<double> transformPairs(const AffineTransform& t, const Vec* v, size_t n) {
+    py::array_t<double> result({(py::ssize_t)n, (py::ssize_t)2});
+    Vector2d* out = reinterpret_cast<Vector2d*>(result.mutable_data());
+    runBatch(n, [&]() { t.apply(v, n, out); });
+    return result;
+}
+
+// Doubles below this round to an int
+const double INT_LIMIT = (double)std::numeric_limits<int>::max();
+
+// Rows of a, b, mode, equave, generator
+std::vector<MOSParams> mosParamsOf(const DoublePairs& params) {
+    if (params.ndim() != 2 || params.shape(1) != 5) {
+        throw py::value_error("expected an (N, 5) array of a, b, mode, equave, generator");
+    }
+    auto rows = params.unchecked<2>();
+    std::vector<MOSParams> result((size_t)params.shape(0));
+    for (py::ssize_t i = 0; i < params.shape(0); ++i) {
+        // the checks of the C API: MOS::fromParams only asserts, and runs later on pool threads
+        double a = rows(i, 0), b = rows(i, 1), mode = rows(i, 2), equave = rows(i, 3), generator = rows(i, 4);
+        bool valid = a >= 0.5 && a < INT_LIMIT && b >= 0.5 && b < INT_LIMIT && std::abs(mode) < INT_LIMIT &&
+                     std::isfinite(equave) && equave > 0.0 && generator >= 0.0 && generator <= 1.0;
+        if (!valid) {
+            throw py::value_error("invalid MOS parameters in row " + std::to_string(i) +
+                                  ": expected a > 0, b > 0, a finite equave > 0 and a generator in [0, 1]");
+        }
+        result[i] = {(int)std::lround(a), (int)std::lround(b), (int)std::lround(mode), equave, generator};
+    }
+    return result;
+}
+
+// The keyboard of the batch calls: n_nodes nodes with the root node among them, or just past them
+void checkKeyboard(int n_nodes, int root) {
+    if (n_nodes < 0 || root < 0 || root > n_nodes) {
+        throw py::value_error("expected n_nodes >= 0 and 0 <= root <= n_nodes");
+    }
+}
+
+// A NumPy view over one column of arrays that shares ownership of the storage
+template <typename T, typename Column>
+py::array_t<T> columnView(const std::shared_ptr<ScaleArrays>& arrays, const Column& column,
+                          std::vector<py::ssize_t> shape) {
+    auto* owner = new std::shared_ptr<ScaleArrays>(arrays);
+    py::capsule base(owner, [](void* p) { delete static_cast<std::shared_ptr<ScaleArrays>*>(p); });
+    return py::array_t<T>(shape, reinterpret_cast<const T*>(column.data()), base);
+}
+
+py::dict columnViews(const std::shared_ptr<ScaleArrays>& arrays) {
+    py::ssize_t s = (py::ssize_t)arrays->n_scales, n = (py::ssize_t)arrays->n_nodes;
+    py::dict result;
+    result["natural_coords"] = columnView<int32_t>(arrays, arrays->natural_coords, {s, n, 2});
+    result["tuning_coords"] = columnView<double>(arrays, arrays->tuning_coords, {s, n, 2});
+    result["pitches"] = columnView<double>(arrays, arrays->pitches, {s, n});
+    result["tempered"] = columnView<bool>(arrays, arrays->tempered, {s, n});
+    result["tempered_log2frs"] = columnView<double>(arrays, arrays->tempered_log2frs, {s, n});
+    return result;
+}
+
+// NumPy arrays over the columns of arrays, which move into storage the arrays keep alive
+py::dict scaleArraysToNumPy(ScaleArrays&& arrays) {
+    return columnViews(std::make_shared<ScaleArrays>(std::move(arrays)));
+}
+
+/**
+ * ScaleArrays for Python, refilled in place like the Wasm class. The NumPy views share
+ * ownership of the storage: a refill of the same shape updates them, a refill of another
+ * shape while views are alive moves to new storage and leaves them with the old values,
+ * so a view never dangles.
+ */
+class PyScaleArrays {
+public:
+    PyScaleArrays() : arrays_(std::make_shared<ScaleArrays>()) {}
+
+    // The storage to refill with n_scales rows of n_nodes nodes
+    ScaleArrays& target(size_t n_scales, size_t n_nodes) {
+        bool viewed = arrays_.use_count() > 1;
+        if (viewed && (arrays_->n_scales != n_scales || arrays_->n_nodes != n_nodes)) {
+            arrays_ = std::make_shared<ScaleArrays>();
+        }
+        return *arrays_;
+    }
+
+    const std::shared_ptr<ScaleArrays>& arrays() const { return arrays_; }
+
+private:
+    std::shared_ptr<ScaleArrays> arrays_;
+};
+
+py::list labelList(const LabelBuffer& buffer) {
+    py::list labels(buffer.size());
+    for (size_t i = 0; i < buffer.size(); ++i) labels[i] = py::str(buffer[i].data(), buffer[i].size());
+    return labels;
+}
+
+} // namespace
+
 PYBIND11_MODULE(scalatrix, m) {
     py::class_<Vector2d>(m, "Vector2d")
         .def(py::init<double, double>())
@@ -68,7 +246,8 @@ PYBIND11_MODULE(scalatrix, m) {
                    ", c=" + std::to_string(t.c) + ", d=" + std::to_string(t.d) +
                    ", tx=" + std::to_string(t.tx) + ", ty=" + std::to_string(t.ty) + ")";
         })
-        .def_static("linearFromTwoDots", &IntegerAffineTransform::linearFromTwoDots);
+        .def_static("linearFromTwoDots", py::overload_cast<const Vector2i&, const Vector2i&, const Vector2i&,
+                                                          const Vector2i&>(&IntegerAffineTransform::linearFromTwoDots));
 
     py::class_<AffineTransform>(m, "AffineTransform")
         .def(py::init<double, double, double, double, double, double>())
@@ -78,11 +257,17 @@ PYBIND11_MODULE(scalatrix, m) {
         .def_readwrite("d", &AffineTransform::d)
         .def_readwrite("tx", &AffineTransform::tx)
         .def_readwrite("ty", &AffineTransform::ty)
-        .def("apply", &AffineTransform::apply)
+        .def("apply", [](const AffineTransform& t, const DoublePairs& v) {
+            return transformPairs(t, pairsOf<Vector2d>(v), (size_t)v.shape(0));
+        }, py::arg("v"))
+        .def("apply", py::overload_cast<const Vector2d&>(&AffineTransform::apply, py::const_))
         .def("inverse", &AffineTransform::inverse)
         .def("__mul__", [](const AffineTransform &a, const Vector2d &b) {
             return a.apply(b);
         }, py::is_operator())
+        .def("applyToVector2i", [](const AffineTransform& t, const IntPairs& v) {
+            return transformPairs(t, pairsOf<Vector2i>(v), (size_t)v.shape(0));
+        }, py::arg("v"))
         .def("applyToVector2i", [](const AffineTransform &a, const Vector2i &b) {
             return a * b;
         })
@@ -92,14 +277,97 @@ PYBIND11_MODULE(scalatrix, m) {
                    ", tx=" + std::to_string(t.tx) + ", ty=" + std::to_string(t.ty) + ")";
         });
 
+    // rational.hpp
+
+    py::class_<Rational>(m, "Rational")
+        .def(py::init<long long, long long>(), py::arg("num") = 0, py::arg("den") = 1)
+        .def_readonly("num", &Rational::num)
+        .def_readonly("den", &Rational::den)
+        .def("toDouble", &Rational::toDouble)
+        .def("floor", &Rational::floor)
+        .def_static("approximate", &Rational::approximate, py::arg("x"), py::arg("max_den") = 1 << 20)
+        .def("__neg__", [](const Rational& a) { return -a; })
+        .def("__add__", [](const Rational& a, const Rational& b) { return a + b; })
+        .def("__sub__", [](const Rational& a, const Rational& b) { return a - b; })
+        .def("__mul__", [](const Rational& a, const Rational& b) { return a * b; })
+        .def("__truediv__", [](const Rational& a, const Rational& b) { return a / b; })
+        .def("__eq__", [](const Rational& a, const Rational& b) { return a == b; })
+        .def("__lt__", [](const Rational& a, const Rational& b) { return a < b; })
+        .def("__le__", [](const Rational& a, const Rational& b) { return a <= b; })
+        .def("__float__", &Rational::toDouble)
+        .def("__repr__", [](const Rational& r) {
+            return "Rational(" + std::to_string(r.num) + ", " + std::to_string(r.den) + ")";
+        });
+    py::implicitly_convertible<int, Rational>();
+
+    py::class_<Vector2r>(m, "Vector2r")
+        .def(py::init<Rational, Rational>())
+        .def_readwrite("x", &Vector2r::x)
+        .def_readwrite("y", &Vector2r::y)
+        .def("toDouble", &Vector2r::toDouble);
+
+    py::class_<RationalAffineTransform>(m, "RationalAffineTransform")
+        .def(py::init<Rational, Rational, Rational, Rational, Rational, Rational>(),
+            py::arg("a") = Rational(1), py::arg("b") = Rational(0), py::arg("c") = Rational(0),
+            py::arg("d") = Rational(1), py::arg("tx") = Rational(0), py::arg("ty") = Rational(0))
+        .def_readwrite("a", &RationalAffineTransform::a)
+        .def_readwrite("b", &RationalAffineTransform::b)
+        .def_readwrite("c", &RationalAffineTransform::c)
+        .def_readwrite("d", &RationalAffineTransform::d)
+        .def_readwrite("tx", &RationalAffineTransform::tx)
+        .def_readwrite("ty", &RationalAffineTransform::ty)
+        .def("apply", &RationalAffineTransform::apply)
+        .def("applyToDouble", &RationalAffineTransform::applyToDouble)
+        .def("inverse", &RationalAffineTransform::inverse)
+        .def("det", &RationalAffineTransform::det)
+        .def("toAffine", &RationalAffineTransform::toAffine)
+        .def("__mul__", [](const RationalAffineTransform& a, const RationalAffineTransform& b) {
+            return a * b;
+        });
+
+    py::class_<StripPeriod>(m, "StripPeriod")
+        .def_readonly("period", &StripPeriod::period)
+        .def_readonly("nodes", &StripPeriod::nodes)
+        .def_readonly("root", &StripPeriod::root);
+
+    m.def("findStripPeriod", &findStripPeriod, py::arg("M"));
+
     py::class_<Scale>(m, "Scale")
         .def(py::init<double>())
         .def("fromAffine", &Scale::fromAffine)
+        .def_static("fromPeriodicityBlock", &Scale::fromPeriodicityBlock,
+            py::arg("M"), py::arg("u1"), py::arg("u2"), py::arg("base_freq"),
+            py::arg("offset") = Vector2d(0.0, 0.0))
+        .def_static("fromPeriodicityBlocks", &Scale::fromPeriodicityBlocks,
+            py::arg("M"), py::arg("unison_vectors"), py::arg("base_freq"),
+            py::arg("offset") = Vector2d(0.0, 0.0), py::arg("n_threads") = 0,
+            py::call_guard<py::gil_scoped_release>())
+        .def("recalcWithPeriodicityBlock", &Scale::recalcWithPeriodicityBlock,
+            py::arg("A"), py::arg("u1"), py::arg("u2"), py::arg("offset") = Vector2d(0.0, 0.0))
         .def("recalcWithAffine", &Scale::recalcWithAffine)
+        .def_static("fromRationalAffine", &Scale::fromRationalAffine)
+        .def("recalcWithRationalAffine", &Scale::recalcWithRationalAffine)
         .def("retuneWithAffine", &Scale::retuneWithAffine)
-        .def("getNodes", &Scale::getNodes, py::return_value_policy::reference)
+        .def("getNodes", py::overload_cast<>(&Scale::getNodes), py::return_value_policy::reference)
         .def("getRootIdx", &Scale::getRootIdx)
-        .def("temperToPitchSet", &Scale::temperToPitchSet)
+        // NumPy copies of the node fields, assigning an array of the same shape writes it back
+        .def_property("natural_coords",
+            [](Scale& self) { return nodeFieldArray<int>(self, &Node::natural_coord, 2); },
+            [](Scale& self, const py::array_t<int, py::array::forcecast>& values) {
+                assignNodeField<int>(self, &Node::natural_coord, 2, values);
+            })
+        .def_property("tuning_coords",
+            [](Scale& self) { return nodeFieldArray<double>(self, &Node::tuning_coord, 2); },
+            [](Scale& self, const py::array_t<double, py::array::forcecast>& values) {
+                assignNodeField<double>(self, &Node::tuning_coord, 2, values);
+            })
+        .def_property("pitches",
+            [](Scale& self) { return nodeFieldArray<double>(self, &Node::pitch, 1); },
+            [](Scale& self, const py::array_t<double, py::array::forcecast>& values) {
+                assignNodeField<double>(self, &Node::pitch, 1, values);
+            })
+        .def("temperToPitchSet", py::overload_cast<PitchSet&>(&Scale::temperToPitchSet))
+        .def("temperToPitchSet", py::overload_cast<const PitchSetIndex&>(&Scale::temperToPitchSet))
         .def("print", &Scale::print);
 
     py::class_<MOS>(m, "MOS")
@@ -129,7 +397,15 @@ PYBIND11_MODULE(scalatrix, m) {
         .def_readwrite("mosTransform", &MOS::mosTransform)
         .def_readwrite("v_gen", &MOS::v_gen)
         .def_readwrite("base_scale", &MOS::base_scale)
+        .def_readonly("exact", &MOS::exact)
+        .def_readonly("has_exact_params", &MOS::has_exact_params)
+        .def_readonly("exact_equave", &MOS::exact_equave)
+        .def_readonly("exact_generator", &MOS::exact_generator)
+        .def_readonly("exactAffine", &MOS::exactAffine)
         .def_static("fromParams", &MOS::fromParams)
+        .def_static("fromRational", &MOS::fromRational)
+        .def("adjustParamsRational", &MOS::adjustParamsRational)
+        .def("calcImpliedRationalAffine", &MOS::calcImpliedRationalAffine)
         .def_static("fromG", &MOS::fromG)
         .def("adjustParams", &MOS::adjustParams)
         .def("angle", &MOS::angle)
@@ -145,21 +421,317 @@ PYBIND11_MODULE(scalatrix, m) {
         .def("retuneThreePoints", &MOS::retuneThreePoints)
         .def("generateScaleFromMOS", &MOS::generateScaleFromMOS)
         .def("retuneScaleWithMOS", &MOS::retuneScaleWithMOS)
-        .def("mapFromMOS", &MOS::mapFromMOS);
+        .def("mapFromMOS", &MOS::mapFromMOS)
+        .def("coordToFreq", [](const MOS& mos, const DoublePairs& coords, double base_freq) {
+            const Vector2d* v = pairsOf<Vector2d>(coords);
+            size_t n = (size_t)coords.shape(0);
+            py::array_t<double> result((py::ssize_t)n);
+            double* out = result.mutable_data();
+            runBatch(n, [&]() { mos.coordsToFreqs(v, n, base_freq, out); });
+            return result;
+        }, py::arg("coords"), py::arg("base_freq"))
+        .def("coordToFreq", &MOS::coordToFreq)
+        .def("nodeInScale", [](const MOS& mos, const IntPairs& coords) {
+            const Vector2i* v = pairsOf<Vector2i>(coords);
+            size_t n = (size_t)coords.shape(0);
+            py::array_t<bool> result((py::ssize_t)n);
+            bool* out = result.mutable_data();
+            runBatch(n, [&]() { mos.nodesInScale(v, n, out); });
+            return result;
+        }, py::arg("coords"))
+        .def("nodeInScale", &MOS::nodeInScale);
+
+    // label_calculator.hpp
+
+    py::enum_<LabelStyle>(m, "LabelStyle")
+        .value("DigitLabel", DigitLabel)
+        .value("LetterLabel", LetterLabel)
+        .value("LetterWithOctaveNumberLabel", LetterWithOctaveNumberLabel)
+        .export_values();
+
+    py::class_<LabelTable, std::shared_ptr<LabelTable>>(m, "LabelTable")
+        .def(py::init<const MOS&, int>(), py::arg("mos"), py::arg("max_accidentals") = 4)
+        .def_static("shared", [](const MOS& mos) { return std::const_pointer_cast<LabelTable>(LabelTable::shared(mos)); })
+        .def("label", &LabelTable::label, py::arg("v"), py::arg("style") = DigitLabel, py::arg("middle_C_octave") = 4);
+
+    m.def("nodeLabels", [](const MOS& mos, const IntPairs& coords, LabelStyle style, int middle_C_octave) {
+        const Vector2i* v = pairsOf<Vector2i>(coords);
+        size_t n = (size_t)coords.shape(0);
+        LabelBuffer buffer;
+        runBatch(n, [&]() { LabelCalculator::nodeLabels(mos, v, n, style, buffer, middle_C_octave); });
+        return labelList(buffer);
+    }, py::arg("mos"), py::arg("coords"), py::arg("style") = DigitLabel, py::arg("middle_C_octave") = 4);
+    m.def("nodeLabels", [](const MOS& mos, const std::vector<Vector2i>& coords, LabelStyle style, int middle_C_octave) {
+        LabelBuffer buffer;
+        LabelCalculator::nodeLabels(mos, coords.data(), coords.size(), style, buffer, middle_C_octave);
+        std::vector<std::string> labels;
+        labels.reserve(buffer.size());
+        for (size_t i = 0; i < buffer.size(); ++i) labels.emplace_back(buffer[i]);
+        return labels;
+    }, py::arg("mos"), py::arg("coords"), py::arg("style") = DigitLabel, py::arg("middle_C_octave") = 4);
+    m.def("noteLabelsNormalized", [](const MOS& mos, const IntPairs& coords, bool override_letter_labels) {
+        const Vector2i* v = pairsOf<Vector2i>(coords);
+        size_t n = (size_t)coords.shape(0);
+        LabelBuffer buffer;
+        runBatch(n, [&]() { LabelCalculator::noteLabelsNormalized(mos, v, n, buffer, override_letter_labels); });
+        return labelList(buffer);
+    }, py::arg("mos"), py::arg("coords"), py::arg("override_letter_labels") = false);
+    m.def("noteLabelsNormalized", [](const MOS& mos, const std::vector<Vector2i>& coords, bool override_letter_labels) {
+        LabelBuffer buffer;
+        LabelCalculator::noteLabelsNormalized(mos, coords.data(), coords.size(), buffer, override_letter_labels);
+        std::vector<std::string> labels;
+        labels.reserve(buffer.size());
+        for (size_t i = 0; i < buffer.size(); ++i) labels.emplace_back(buffer[i]);
+        return labels;
+    }, py::arg("mos"), py::arg("coords"), py::arg("override_letter_labels") = false);
+    m.def("deviationLabels", [](const std::vector<Node>& nodes, double thresholdCents, bool compareWithTempered) {
+        LabelBuffer buffer;
+        LabelCalculator::deviationLabels(nodes, buffer, thresholdCents, compareWithTempered);
+        std::vector<std::string> labels;
+        labels.reserve(buffer.size());
+        for (size_t i = 0; i < buffer.size(); ++i) labels.emplace_back(buffer[i]);
+        return labels;
+    }, py::arg("nodes"), py::arg("thresholdCents") = 0.1, py::arg("compareWithTempered") = false);
+
+    // lattice3.hpp, scale3.hpp
+
+    py::class_<Vector3i>(m, "Vector3i")
+        .def(py::init<int, int, int>())
+        .def_readwrite("x", &Vector3i::x)
+        .def_readwrite("y", &Vector3i::y)
+        .def_readwrite("z", &Vector3i::z)
+        .def("__eq__", [](const Vector3i& a, const Vector3i& b) { return a == b; })
+        .def("__add__", [](const Vector3i& a, const Vector3i& b) { return a + b; })
+        .def("__sub__", [](const Vector3i& a, const Vector3i& b) { return a - b; })
+        .def("__mul__", [](const Vector3i& a, int s) { return a * s; })
+        .def("__rmul__", [](int s, const Vector3i& a) { return s * a; })
+        .def("__repr__", [](const Vector3i &v) {
+            return "(" + std::to_string(v.x) + ", " + std::to_string(v.y) + ", " + std::to_string(v.z) + ")";
+        });
+
+    py::class_<Vector3d>(m, "Vector3d")
+        .def(py::init<double, double, double>())
+        .def_readwrite("x", &Vector3d::x)
+        .def_readwrite("y", &Vector3d::y)
+        .def_readwrite("z", &Vector3d::z)
+        .def("__repr__", [](const Vector3d &v) {
+            return "(" + std::to_string(v.x) + ", " + std::to_string(v.y) + ", " + std::to_string(v.z) + ")";
+        });
+
+    py::class_<AffineTransform3>(m, "AffineTransform3")
+        .def(py::init<>())
+        .def(py::init<double, double, double, double, double, double, double, double, double, double, double, double>(),
+            py::arg("m00"), py::arg("m01"), py::arg("m02"),
+            py::arg("m10"), py::arg("m11"), py::arg("m12"),
+            py::arg("m20"), py::arg("m21"), py::arg("m22"),
+            py::arg("tx") = 0.0, py::arg("ty") = 0.0, py::arg("tz") = 0.0)
+        .def_readwrite("tx", &AffineTransform3::tx)
+        .def_readwrite("ty", &AffineTransform3::ty)
+        .def_readwrite("tz", &AffineTransform3::tz)
+        .def("get", [](const AffineTransform3 &t, int i, int j) { return t.m[i][j]; })
+        .def("set", [](AffineTransform3 &t, int i, int j, double v) { t.m[i][j] = v; })
+        .def("apply", &AffineTransform3::apply)
+        .def("applyToVector3i", [](const AffineTransform3 &t, const Vector3i &v) { return t * v; })
+        .def("inverse", &AffineTransform3::inverse)
+        .def("det", &AffineTransform3::det);
+
+    m.def("affineFromFourDots", &affineFromFourDots);
+    m.def("findStepsWithinPrism", &findStepsWithinPrism);
+
+    py::class_<Node3>(m, "Node3")
+        .def(py::init<>())
+        .def_readwrite("natural_coord", &Node3::natural_coord)
+        .def_readwrite("tuning_coord", &Node3::tuning_coord)
+        .def_readwrite("pitch", &Node3::pitch);
+
+    py::class_<Scale3>(m, "Scale3")
+        .def(py::init<double, int, int>(), py::arg("base_freq") = DEFAULT_12TET_C_PITCH,
+            py::arg("N") = 128, py::arg("root_node_idx") = 60)
+        .def_static("fromAffine", &Scale3::fromAffine)
+        .def("recalcWithAffine", &Scale3::recalcWithAffine)
+        .def("retuneWithAffine", &Scale3::retuneWithAffine)
+        .def("getNodes", &Scale3::getNodes, py::return_value_policy::reference_internal)
+        .def("getRootIdx", &Scale3::getRootIdx)
+        .def("getBaseFreq", &Scale3::getBaseFreq);
 
     // pitchset.hpp
 
+    py::enum_<PitchValueKind>(m, "PitchValueKind")
+        .value("UnknownPitch", UnknownPitch)
+        .value("RatioPitch", RatioPitch)
+        .value("EDOPitch", EDOPitch)
+        .export_values();
+
     py::class_<PitchSetPitch>(m, "PitchSetPitch")
         .def(py::init<>())
         .def_readwrite("label", &PitchSetPitch::label)
-        .def_readwrite("log2fr", &PitchSetPitch::log2fr);
+        .def_readwrite("log2fr", &PitchSetPitch::log2fr)
+        .def_readwrite("kind", &PitchSetPitch::kind)
+        .def_readwrite("num", &PitchSetPitch::num)
+        .def_readwrite("den", &PitchSetPitch::den)
+        .def_static("fromRatio", &PitchSetPitch::fromRatio)
+        .def_static("fromEDOSteps", &PitchSetPitch::fromEDOSteps)
+        .def_static("fromLabel", &PitchSetPitch::fromLabel)
+        .def("sameValue", &PitchSetPitch::sameValue)
+        .def("__add__", [](const PitchSetPitch& a, const PitchSetPitch& b) { return a + b; })
+        .def("__mul__", [](const PitchSetPitch& a, int k) { return a * k; });
     
     py::class_<PitchSet>(m, "PitchSet")
         .def(py::init<>())
         .def_static("generateETPitchSet", &generateETPitchSet)
         .def_static("generateJIPitchSet", &generateJIPitchSet)
         .def_static("generateHarmonicSeriesPitchSet", &generateHarmonicSeriesPitchSet);
+
+    py::class_<ETComparisonTable>(m, "ETComparisonTable")
+        .def_readonly("min_et", &ETComparisonTable::min_et)
+        .def_readonly("max_et", &ETComparisonTable::max_et)
+        .def_readonly("n_targets", &ETComparisonTable::n_targets)
+        .def_readonly("n_primes", &ETComparisonTable::n_primes)
+        .def_readonly("equave_log2fr", &ETComparisonTable::equave_log2fr)
+        .def_readonly("best_steps", &ETComparisonTable::best_steps)
+        .def_readonly("errors", &ETComparisonTable::errors)
+        .def_readonly("patent_vals", &ETComparisonTable::patent_vals)
+        .def_readonly("mapped_steps", &ETComparisonTable::mapped_steps)
+        .def_readonly("max_errors", &ETComparisonTable::max_errors)
+        .def_readonly("rms_errors", &ETComparisonTable::rms_errors)
+        .def("rows", &ETComparisonTable::rows)
+        .def("bestStep", &ETComparisonTable::bestStep)
+        .def("error", &ETComparisonTable::error)
+        .def("mappedStep", &ETComparisonTable::mappedStep)
+        .def("consistent", &ETComparisonTable::consistent);
+
+    m.def("compareETs", &compareETs,
+        py::arg("targets"), py::arg("min_et"), py::arg("max_et"), py::arg("equave_log2fr") = 1.0,
+        py::arg("primes") = PrimeList(), py::arg("n_threads") = 0,
+        py::call_guard<py::gil_scoped_release>());
+
+    m.def("writePitchSetFile", &writePitchSetFile,
+        py::arg("path"), py::arg("pitchset"), py::arg("equave_log2fr") = 1.0);
+    m.def("readPitchSetFile", &readPitchSetFile);
+    m.def("pitchSetUnion", &pitchSetUnion);
+    m.def("pitchSetIntersection", &pitchSetIntersection,
+        py::arg("a"), py::arg("b"), py::arg("tolerance_cents") = 0.0);
+    m.def("transposePitchSet", &transposePitchSet);
+    m.def("stackPitchSets", &stackPitchSets,
+        py::arg("a"), py::arg("b"), py::arg("min_log2fr") = -1e9, py::arg("max_log2fr") = 1e9);
+
+    py::class_<PitchSetIndex>(m, "PitchSetIndex")
+        .def(py::init<const PitchSet&, double>(), py::arg("pitchset"), py::arg("equave_log2fr") = 1.0)
+        .def("size", &PitchSetIndex::size)
+        .def("__len__", &PitchSetIndex::size)
+        .def("equave", &PitchSetIndex::equave)
+        .def_static("load", &PitchSetIndex::load)
+        .def("save", &PitchSetIndex::save)
+        .def("pitch", &PitchSetIndex::pitch)
+        .def("label", [](const PitchSetIndex& index, size_t i) { return std::string(index.label(i)); })
+        .def("log2frs", [](const PitchSetIndex& index) {
+            return std::vector<double>(index.log2frs(), index.log2frs() + index.size());
+        })
+        .def("toPitchSet", &PitchSetIndex::toPitchSet)
+        .def("lowerBound", py::overload_cast<double>(&PitchSetIndex::lowerBound, py::const_))
+        .def("nearest", py::overload_cast<double>(&PitchSetIndex::nearest, py::const_))
+        .def("kNearest", &PitchSetIndex::kNearest)
+        .def("range", &PitchSetIndex::range)
+        .def("nearestReduced", [](const PitchSetIndex& index, double log2fr) {
+            double matched;
+            size_t i = index.nearestReduced(log2fr, matched);
+            return std::make_pair(i, matched);
+        })
+        .def("nearestBatch", [](const PitchSetIndex& index, const std::vector<double>& log2frs) {
+            std::vector<uint32_t> out(log2frs.size());
+            if (!index.empty()) index.nearest(log2frs.data(), log2frs.size(), out.data());
+            return out;
+        })
+        .def("lowerBoundBatch", [](const PitchSetIndex& index, const std::vector<double>& log2frs) {
+            std::vector<uint32_t> out(log2frs.size());
+            index.lowerBound(log2frs.data(), log2frs.size(), out.data());
+            return out;
+        });
     
+    // scale_arrays.hpp, each call releases the GIL while the scales are generated
+
+    py::class_<PyScaleArrays>(m, "ScaleArrays")
+        .def(py::init<>())
+        .def_property_readonly("n_scales", [](const PyScaleArrays& a) { return a.arrays()->n_scales; })
+        .def_property_readonly("n_nodes", [](const PyScaleArrays& a) { return a.arrays()->n_nodes; })
+        // zero-copy NumPy views of the last fill, see PyScaleArrays for their lifetime
+        .def_property_readonly("natural_coords", [](const PyScaleArrays& a) {
+            const auto& arrays = a.arrays();
+            return columnView<int32_t>(arrays, arrays->natural_coords,
+                                       {(py::ssize_t)arrays->n_scales, (py::ssize_t)arrays->n_nodes, 2});
+        })
+        .def_property_readonly("tuning_coords", [](const PyScaleArrays& a) {
+            const auto& arrays = a.arrays();
+            return columnView<double>(arrays, arrays->tuning_coords,
+                                      {(py::ssize_t)arrays->n_scales, (py::ssize_t)arrays->n_nodes, 2});
+        })
+        .def_property_readonly("pitches", [](const PyScaleArrays& a) {
+            const auto& arrays = a.arrays();
+            return columnView<double>(arrays, arrays->pitches,
+                                      {(py::ssize_t)arrays->n_scales, (py::ssize_t)arrays->n_nodes});
+        })
+        .def_property_readonly("tempered", [](const PyScaleArrays& a) {
+            const auto& arrays = a.arrays();
+            return columnView<bool>(arrays, arrays->tempered,
+                                    {(py::ssize_t)arrays->n_scales, (py::ssize_t)arrays->n_nodes});
+        })
+        .def_property_readonly("tempered_log2frs", [](const PyScaleArrays& a) {
+            const auto& arrays = a.arrays();
+            return columnView<double>(arrays, arrays->tempered_log2frs,
+                                      {(py::ssize_t)arrays->n_scales, (py::ssize_t)arrays->n_nodes});
+        })
+        .def("fillScale", [](PyScaleArrays& a, const Scale& scale) {
+            fillScaleArrays(scale, a.target(1, scale.getNodes().size()));
+        })
+        .def("fillMOSScale", [](PyScaleArrays& a, MOS& mos, double base_freq, int n_nodes, int root) {
+            checkKeyboard(n_nodes, root);
+            fillMOSScaleArrays(mos, base_freq, n_nodes, root, a.target(1, (size_t)n_nodes));
+        }, py::arg("mos"), py::arg("base_freq"), py::arg("n_nodes") = 128, py::arg("root") = 60)
+        .def("fillLattice", [](PyScaleArrays& a, const MOS& mos, int x_min, int y_min, int x_max, int y_max,
+                               double base_freq) {
+            if (x_min > x_max || y_min > y_max) throw py::value_error("expected x_min <= x_max and y_min <= y_max");
+            size_t n_nodes = (size_t)((long long)x_max - x_min + 1) * (size_t)((long long)y_max - y_min + 1);
+            fillLatticeArrays(mos, {x_min, y_min}, {x_max, y_max}, base_freq, a.target(1, n_nodes));
+        });
+
+    m.def("generateMOSScales", [](const DoublePairs& params, double base_freq, int n_nodes, int root,
+                                  unsigned n_threads) {
+        checkKeyboard(n_nodes, root);
+        std::vector<MOSParams> mos_params = mosParamsOf(params);
+        ScaleArrays arrays;
+        {
+            py::gil_scoped_release release;
+            arrays = generateMOSScales(mos_params, base_freq, n_nodes, root, n_threads);
+        }
+        return scaleArraysToNumPy(std::move(arrays));
+    }, py::arg("params"), py::arg("base_freq"), py::arg("n_nodes") = 128, py::arg("root") = 60,
+       py::arg("n_threads") = 0);
+    m.def("temperMOSScales", [](const DoublePairs& params, const PitchSetIndex& index, double base_freq,
+                                int n_nodes, int root, unsigned n_threads) {
+        checkKeyboard(n_nodes, root);
+        std::vector<MOSParams> mos_params = mosParamsOf(params);
+        ScaleArrays arrays;
+        {
+            py::gil_scoped_release release;
+            arrays = temperMOSScales(mos_params, index, base_freq, n_nodes, root, n_threads);
+        }
+        return scaleArraysToNumPy(std::move(arrays));
+    }, py::arg("params"), py::arg("index"), py::arg("base_freq"), py::arg("n_nodes") = 128, py::arg("root") = 60,
+       py::arg("n_threads") = 0);
+    m.def("temperScales", [](const Scale& scale, const std::vector<PitchSetIndex>& indices, unsigned n_threads) {
+        ScaleArrays arrays;
+        {
+            py::gil_scoped_release release;
+            arrays = temperScales(scale, indices, n_threads);
+        }
+        return scaleArraysToNumPy(std::move(arrays));
+    }, py::arg("scale"), py::arg("indices"), py::arg("n_threads") = 0);
+
+    // parallel.hpp, the thread pool shared by every batch call
+    m.def("setConcurrencyLimit", &setConcurrencyLimit, py::arg("limit"));
+    m.def("concurrencyLimit", &concurrencyLimit);
+    m.def("defaultConcurrency", &defaultConcurrency);
+
     py::class_<PseudoPrimeInt>(m, "PseudoPrimeInt")
         .def(py::init<>())
         .def_readwrite("label", &PseudoPrimeInt::label)
@@ -171,7 +743,126 @@ PYBIND11_MODULE(scalatrix, m) {
         .def_static("generateDefaultPrimeList", &generateDefaultPrimeList)
         .def_static("pseudoPrimeFromIndexNumber", &pseudoPrimeFromIndexNumber);
 
+    // primes.hpp
+
+    py::class_<SmoothNumber>(m, "SmoothNumber")
+        .def_readonly("number", &SmoothNumber::number)
+        .def_readonly("log2fr", &SmoothNumber::log2fr);
+
+    py::class_<PrimeListFactorizer>(m, "PrimeListFactorizer")
+        .def(py::init<const PrimeList&, unsigned int>(), py::arg("primes"), py::arg("limit"))
+        .def("monzo", [](const PrimeListFactorizer& f, unsigned int n) -> py::object {
+            std::vector<int> exponents;
+            if (!f.monzo(n, exponents)) return py::none();
+            return py::cast(exponents);
+        })
+        .def("log2fr", [](const PrimeListFactorizer& f, unsigned int n, bool allow_cofactor) -> py::object {
+            double result;
+            if (!f.log2fr(n, result, allow_cofactor)) return py::none();
+            return py::cast(result);
+        }, py::arg("n"), py::arg("allow_cofactor") = false)
+        .def("hasPrimeBasis", &PrimeListFactorizer::hasPrimeBasis)
+        .def("smoothNumbers", &PrimeListFactorizer::smoothNumbers);
+
+    m.def("smoothNumbers", &smoothNumbers, py::arg("primes"), py::arg("limit"));
+
+    // ji.hpp
+
+    py::class_<JIRatio>(m, "JIRatio")
+        .def(py::init<>())
+        .def_readwrite("num", &JIRatio::num)
+        .def_readwrite("den", &JIRatio::den)
+        .def_readwrite("log2fr", &JIRatio::log2fr)
+        .def("__repr__", [](const JIRatio& r) {
+            return "JIRatio(" + std::to_string(r.num) + ":" + std::to_string(r.den) + ")";
+        });
+
+    py::class_<JIRatioStream>(m, "JIRatioStream")
+        .def(py::init<const PrimeList&, int, double, double>(),
+            py::arg("primes"), py::arg("max_numorden") = 20,
+            py::arg("min_log2fr") = 0.0, py::arg("max_log2fr") = 1.0)
+        .def("__iter__", [](JIRatioStream& s) -> JIRatioStream& { return s; })
+        .def("__next__", [](JIRatioStream& s) {
+            JIRatio r;
+            if (!s.next(r)) throw py::stop_iteration();
+            return r;
+        });
+
+    m.def("generateJIRatios", &generateJIRatios,
+        py::arg("primes"), py::arg("max_numorden") = 20,
+        py::arg("min_log2fr") = 0.0, py::arg("max_log2fr") = 1.0,
+        py::call_guard<py::gil_scoped_release>());
+    m.def("jiRatiosToPitchSet", &jiRatiosToPitchSet);
+
+    py::enum_<HarmonicComplexity>(m, "HarmonicComplexity")
+        .value("TenneyHeight", TenneyHeight)
+        .value("WeilHeight", WeilHeight)
+        .value("OddLimit", OddLimit)
+        .export_values();
+
+    m.def("generateSimplestRatios", &generateSimplestRatios,
+        py::arg("primes"), py::arg("k"), py::arg("complexity") = TenneyHeight,
+        py::arg("min_log2fr") = 0.0, py::arg("max_log2fr") = 1.0,
+        py::call_guard<py::gil_scoped_release>());
+    m.def("generateSimplestPitchSet", &generateSimplestPitchSet,
+        py::arg("primes"), py::arg("k"), py::arg("complexity") = TenneyHeight,
+        py::arg("min_log2fr") = 0.0, py::arg("max_log2fr") = 1.0);
+
+    m.def("generateDiamondRatios", &generateDiamondRatios,
+        py::arg("identities"), py::arg("primes"), py::arg("include_equave") = true);
+    m.def("generateDiamondPitchSet", &generateDiamondPitchSet,
+        py::arg("identities"), py::arg("primes"), py::arg("include_equave") = true);
+    m.def("generateOddLimitDiamondPitchSet", &generateOddLimitDiamondPitchSet,
+        py::arg("primes"), py::arg("odd_limit"), py::arg("include_equave") = true);
+    m.def("generateOtonalPitchSet", &generateOtonalPitchSet,
+        py::arg("identities"), py::arg("primes"), py::arg("include_equave") = true);
+    m.def("generateUtonalPitchSet", &generateUtonalPitchSet,
+        py::arg("identities"), py::arg("primes"), py::arg("include_equave") = true);
 
 
     m.def("affineFromThreeDots", &scalatrix::affineFromThreeDots);
+
+    // comma_search.hpp
+
+    py::class_<LatticeMetric>(m, "LatticeMetric")
+        .def(py::init<double, double, double>(), py::arg("g11") = 1.0, py::arg("g12") = 0.0, py::arg("g22") = 1.0)
+        .def_readwrite("g11", &LatticeMetric::g11)
+        .def_readwrite("g12", &LatticeMetric::g12)
+        .def_readwrite("g22", &LatticeMetric::g22)
+        .def("dot", &LatticeMetric::dot)
+        .def("norm2", &LatticeMetric::norm2)
+        .def_static("fromAffine", &LatticeMetric::fromAffine);
+
+    py::class_<CommaVector>(m, "CommaVector")
+        .def(py::init<>())
+        .def_readwrite("v", &CommaVector::v)
+        .def_readwrite("equaves", &CommaVector::equaves)
+        .def_readwrite("cents", &CommaVector::cents)
+        .def_readwrite("norm", &CommaVector::norm)
+        .def("__repr__", [](const CommaVector &c) {
+            return "CommaVector(v=(" + std::to_string(c.v.x) + ", " + std::to_string(c.v.y) +
+                   "), equaves=" + std::to_string(c.equaves) + ", cents=" + std::to_string(c.cents) +
+                   ", norm=" + std::to_string(c.norm) + ")";
+        });
+
+    m.def("reduceBasis", &reduceBasis, py::arg("b1"), py::arg("b2"), py::arg("metric") = LatticeMetric());
+    m.def("hermiteBasis", &hermiteBasis);
+    m.def("findCommas",
+        py::overload_cast<const MOS&, double, double, const LatticeMetric&, bool>(&findCommas),
+        py::arg("mos"), py::arg("tolerance_cents"), py::arg("max_norm"),
+        py::arg("metric") = LatticeMetric(), py::arg("include_equave_multiples") = true);
+    m.def("findCommas",
+        py::overload_cast<const AffineTransform&, double, double, double, const LatticeMetric&, bool>(&findCommas),
+        py::arg("A"), py::arg("equave"), py::arg("tolerance_cents"), py::arg("max_norm"),
+        py::arg("metric") = LatticeMetric(), py::arg("include_equave_multiples") = true);
+    m.def("findCommasParallel",
+        py::overload_cast<const MOS&, double, double, const LatticeMetric&, bool, unsigned>(&findCommasParallel),
+        py::arg("mos"), py::arg("tolerance_cents"), py::arg("max_norm"),
+        py::arg("metric") = LatticeMetric(), py::arg("include_equave_multiples") = true,
+        py::arg("n_threads") = 0, py::call_guard<py::gil_scoped_release>());
+    m.def("findCommasParallel",
+        py::overload_cast<const AffineTransform&, double, double, double, const LatticeMetric&, bool, unsigned>(&findCommasParallel),
+        py::arg("A"), py::arg("equave"), py::arg("tolerance_cents"), py::arg("max_norm"),
+        py::arg("metric") = LatticeMetric(), py::arg("include_equave_multiples") = true,
+        py::arg("n_threads") = 0, py::call_guard<py::gil_scoped_release>());
 }
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "scalatrix/rational.hpp"
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <numeric>
+
+namespace scalatrix {
+
+Rational::Rational(long long num_, long long den_) : num(num_), den(den_) {
+    assert(den != 0);
+    if (den < 0) {
+        num = -num;
+        den = -den;
+    }
+    long long g = std::gcd(num, den);
+    if (g > 1) {
+        num /= g;
+        den /= g;
+    }
+}
+
+long long Rational::floor() const {
+    long long q = num / den;
+    if (num % den != 0 && num < 0) q--;
+    return q;
+}
+
+Rational Rational::operator+(const Rational& r) const {
+    long long g = std::gcd(den, r.den);
+    return Rational(num * (r.den / g) + r.num * (den / g), (den / g) * r.den);
+}
+
+Rational Rational::operator-(const Rational& r) const {
+    return *this + (-r);
+}
+
+Rational Rational::operator*(const Rational& r) const {
+    // cross-reduce first to keep the intermediate products small
+    long long g1 = std::gcd(num, r.den);
+    long long g2 = std::gcd(r.num, den);
+    if (g1 == 0) g1 = 1;
+    if (g2 == 0) g2 = 1;
+    return Rational((num / g1) * (r.num / g2), (den / g2) * (r.den / g1));
+}
+
+Rational Rational::operator/(const Rational& r) const {
+    assert(r.num != 0);
+    return *this * Rational(r.den, r.num);
+}
+
+bool Rational::operator<(const Rational& r) const {
+    return (*this - r).num < 0;
+}
+
+Rational Rational::approximate(double x, long long max_den) {
+    long long sign = x < 0 ? -1 : 1;
+    x = std::abs(x);
+    long long p0 = 0, q0 = 1, p1 = 1, q1 = 0;
+    double f = x;
+    for (int i = 0; i < 64; ++i) {
+        double a = std::floor(f);
+        long long ai = (long long)a;
+        long long q2 = ai * q1 + q0;
+        if (q2 > max_den) break;
+        long long p2 = ai * p1 + p0;
+        p0 = p1; q0 = q1;
+        p1 = p2; q1 = q2;
+        if (f - a < 1e-15 || std::abs((double)p1 / q1 - x) == 0.0) break;
+        f = 1.0 / (f - a);
+    }
+    if (q1 == 0) return Rational(sign * p0, q0);
+    return Rational(sign * p1, q1);
+}
+
+RationalAffineTransform::RationalAffineTransform(Rational a_, Rational b_, Rational c_, Rational d_,
+                                                 Rational tx_, Rational ty_)
+    : a(a_), b(b_), c(c_), d(d_), tx(tx_), ty(ty_) {}
+
+Vector2r RationalAffineTransform::operator*(const Vector2i& v) const {
+    return {a * v.x + b * v.y + tx, c * v.x + d * v.y + ty};
+}
+
+Vector2r RationalAffineTransform::apply(const Vector2i& v) const {
+    return (*this) * v;
+}
+
+Vector2d RationalAffineTransform::applyToDouble(const Vector2i& v) const {
+    return ((*this) * v).toDouble();
+}
+
+RationalAffineTransform RationalAffineTransform::operator*(const RationalAffineTransform& M) const {
+    return {a * M.a + b * M.c, a * M.b + b * M.d, c * M.a + d * M.c, c * M.b + d * M.d,
+            a * M.tx + b * M.ty + tx, c * M.tx + d * M.ty + ty};
+}
+
+RationalAffineTransform RationalAffineTransform::inverse() const {
+    Rational D = det();
+    assert(D.num != 0);
+    RationalAffineTransform R(d / D, -b / D, -c / D, a / D);
+    R.tx = -(R.a * tx + R.b * ty);
+    R.ty = -(R.c * tx + R.d * ty);
+    return R;
+}
+
+AffineTransform RationalAffineTransform::toAffine() const {
+    return {a.toDouble(), b.toDouble(), c.toDouble(), d.toDouble(), tx.toDouble(), ty.toDouble()};
+}
+
+} // namespace scalatrix
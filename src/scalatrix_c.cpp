@@ -0,0 +1,308 @@
+#include "scalatrix/scalatrix_c.h"
+#include "scalatrix/mos.hpp"
+#include "scalatrix/parallel.hpp"
+#include "scalatrix/pitchset_index.hpp"
+#include "scalatrix/scale_arrays.hpp"
+#include <algorithm>
+#include <cmath>
+#include <new>
+#include <stdexcept>
+
+using namespace scalatrix;
+
+struct scalatrix_mos {
+    MOS mos;
+};
+
+struct scalatrix_scale {
+    Scale scale;
+};
+
+struct scalatrix_pitchset_index {
+    PitchSetIndex index;
+};
+
+static_assert(sizeof(Vector2i) == 2 * sizeof(int32_t), "Vector2i must be two packed int32");
+static_assert(sizeof(Vector2d) == 2 * sizeof(double), "Vector2d must be two packed doubles");
+static_assert(sizeof(bool) == sizeof(uint8_t), "bool must be one byte");
+
+namespace {
+
+// Runs a call that may allocate or throw, translating exceptions into status codes
+template <typename F>
+scalatrix_status guarded(F&& call) {
+    try {
+        call();
+        return SCALATRIX_OK;
+    } catch (const std::bad_alloc&) {
+        return SCALATRIX_ERROR_OUT_OF_MEMORY;
+    } catch (const std::invalid_argument&) {
+        return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    } catch (const std::runtime_error&) {
+        return SCALATRIX_ERROR_IO;
+    } catch (...) {
+        return SCALATRIX_ERROR_INTERNAL;
+    }
+}
+
+// The preconditions asserted by MOS::adjustParams
+bool validParams(const scalatrix_mos_params* p) {
+    return p && p->a > 0 && p->b > 0 && std::isfinite(p->equave) && p->equave > 0.0 &&
+           p->generator >= 0.0 && p->generator <= 1.0;
+}
+
+bool validFreq(double base_freq) {
+    return std::isfinite(base_freq) && base_freq > 0.0;
+}
+
+// n_nodes nodes with the root node among them, or just past the last one
+bool validKeyboard(int n_nodes, int root) {
+    return n_nodes >= 0 && root >= 0 && root <= n_nodes;
+}
+
+} // namespace
+
+extern "C" {
+
+const char* scalatrix_status_string(scalatrix_status status) {
+    switch (status) {
+        case SCALATRIX_OK: return "ok";
+        case SCALATRIX_ERROR_INVALID_ARGUMENT: return "invalid argument";
+        case SCALATRIX_ERROR_BUFFER_TOO_SMALL: return "buffer too small";
+        case SCALATRIX_ERROR_OUT_OF_MEMORY: return "out of memory";
+        case SCALATRIX_ERROR_IO: return "file error";
+        case SCALATRIX_ERROR_INTERNAL: return "internal error";
+    }
+    return "unknown status";
+}
+
+// MOS
+
+scalatrix_status scalatrix_mos_create(const scalatrix_mos_params* params, scalatrix_mos** out) {
+    if (!out) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    *out = nullptr;
+    if (!validParams(params)) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    return guarded([&]() {
+        *out = new scalatrix_mos{MOS::fromParams(params->a, params->b, params->mode, params->equave,
+                                                 params->generator)};
+    });
+}
+
+void scalatrix_mos_destroy(scalatrix_mos* mos) {
+    delete mos;
+}
+
+scalatrix_status scalatrix_mos_adjust(scalatrix_mos* mos, const scalatrix_mos_params* params) {
+    if (!mos || !validParams(params)) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    return guarded([&]() {
+        mos->mos.adjustParams(params->a, params->b, params->mode, params->equave, params->generator);
+    });
+}
+
+scalatrix_status scalatrix_mos_get_params(const scalatrix_mos* mos, scalatrix_mos_params* out) {
+    if (!mos || !out) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    const MOS& m = mos->mos;
+    *out = {m.a, m.b, m.mode, m.equave, m.generator};
+    return SCALATRIX_OK;
+}
+
+scalatrix_status scalatrix_mos_size(const scalatrix_mos* mos, int* out) {
+    if (!mos || !out) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    *out = mos->mos.n;
+    return SCALATRIX_OK;
+}
+
+scalatrix_status scalatrix_mos_retune_one_point(scalatrix_mos* mos, int x, int y, double log2fr) {
+    if (!mos || !std::isfinite(log2fr)) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    mos->mos.retuneOnePoint({x, y}, log2fr);
+    return SCALATRIX_OK;
+}
+
+scalatrix_status scalatrix_mos_retune_two_points(scalatrix_mos* mos, int fixed_x, int fixed_y,
+                                                 int x, int y, double log2fr) {
+    if (!mos || !std::isfinite(log2fr)) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    // v and fixed must be tuned apart or the rescaling divides by zero
+    const AffineTransform& A = mos->mos.impliedAffine;
+    if ((A * Vector2i(x, y)).x == (A * Vector2i(fixed_x, fixed_y)).x) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    mos->mos.retuneTwoPoints({fixed_x, fixed_y}, {x, y}, log2fr);
+    return SCALATRIX_OK;
+}
+
+scalatrix_status scalatrix_mos_retune_three_points(scalatrix_mos* mos, const int32_t fixed[4],
+                                                   int x, int y, double log2fr) {
+    if (!mos || !fixed || !std::isfinite(log2fr)) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    // the three lattice points must not be collinear
+    long long cross = (long long)(fixed[2] - fixed[0]) * (y - fixed[1]) -
+                      (long long)(fixed[3] - fixed[1]) * (x - fixed[0]);
+    if (cross == 0) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    mos->mos.retuneThreePoints({fixed[0], fixed[1]}, {fixed[2], fixed[3]}, {x, y}, log2fr);
+    return SCALATRIX_OK;
+}
+
+scalatrix_status scalatrix_mos_coords_to_freqs(const scalatrix_mos* mos, const double* coords, size_t n,
+                                               double base_freq, double* out) {
+    if (!mos || (n > 0 && (!coords || !out))) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    mos->mos.coordsToFreqs(reinterpret_cast<const Vector2d*>(coords), n, base_freq, out);
+    return SCALATRIX_OK;
+}
+
+scalatrix_status scalatrix_mos_nodes_in_scale(const scalatrix_mos* mos, const int32_t* coords, size_t n,
+                                              uint8_t* out) {
+    if (!mos || (n > 0 && (!coords || !out))) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    mos->mos.nodesInScale(reinterpret_cast<const Vector2i*>(coords), n, reinterpret_cast<bool*>(out));
+    return SCALATRIX_OK;
+}
+
+// Scale
+
+scalatrix_status scalatrix_scale_create_from_mos(scalatrix_mos* mos, double base_freq, int n_nodes, int root,
+                                                 scalatrix_scale** out) {
+    if (!out) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    *out = nullptr;
+    if (!mos || !validFreq(base_freq) || !validKeyboard(n_nodes, root)) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    return guarded([&]() {
+        *out = new scalatrix_scale{mos->mos.generateScaleFromMOS(base_freq, n_nodes, root)};
+    });
+}
+
+void scalatrix_scale_destroy(scalatrix_scale* scale) {
+    delete scale;
+}
+
+scalatrix_status scalatrix_scale_size(const scalatrix_scale* scale, size_t* out) {
+    if (!scale || !out) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    *out = scale->scale.getNodes().size();
+    return SCALATRIX_OK;
+}
+
+scalatrix_status scalatrix_scale_retune_with_mos(scalatrix_scale* scale, scalatrix_mos* mos, double base_freq) {
+    if (!scale || !mos || !validFreq(base_freq)) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    mos->mos.retuneScaleWithMOS(scale->scale, base_freq);
+    return SCALATRIX_OK;
+}
+
+scalatrix_status scalatrix_scale_temper(scalatrix_scale* scale, const scalatrix_pitchset_index* index) {
+    if (!scale || !index) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    return guarded([&]() { scale->scale.temperToPitchSet(index->index); });
+}
+
+scalatrix_status scalatrix_scale_get_pitches(const scalatrix_scale* scale, double* out, size_t capacity) {
+    if (!scale || (capacity > 0 && !out)) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    const std::vector<Node>& nodes = scale->scale.getNodes();
+    if (nodes.size() > capacity) return SCALATRIX_ERROR_BUFFER_TOO_SMALL;
+    for (size_t i = 0; i < nodes.size(); ++i) out[i] = nodes[i].pitch;
+    return SCALATRIX_OK;
+}
+
+scalatrix_status scalatrix_scale_get_natural_coords(const scalatrix_scale* scale, int32_t* out, size_t capacity) {
+    if (!scale || (capacity > 0 && !out)) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    const std::vector<Node>& nodes = scale->scale.getNodes();
+    if (nodes.size() > capacity) return SCALATRIX_ERROR_BUFFER_TOO_SMALL;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        out[2 * i] = nodes[i].natural_coord.x;
+        out[2 * i + 1] = nodes[i].natural_coord.y;
+    }
+    return SCALATRIX_OK;
+}
+
+scalatrix_status scalatrix_scale_get_tuning_coords(const scalatrix_scale* scale, double* out, size_t capacity) {
+    if (!scale || (capacity > 0 && !out)) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    const std::vector<Node>& nodes = scale->scale.getNodes();
+    if (nodes.size() > capacity) return SCALATRIX_ERROR_BUFFER_TOO_SMALL;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        out[2 * i] = nodes[i].tuning_coord.x;
+        out[2 * i + 1] = nodes[i].tuning_coord.y;
+    }
+    return SCALATRIX_OK;
+}
+
+// PitchSetIndex
+
+scalatrix_status scalatrix_pitchset_index_create_et(unsigned int n_et, double equave_log2fr, double min_log2fr,
+                                                    double max_log2fr, scalatrix_pitchset_index** out) {
+    if (!out) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    *out = nullptr;
+    if (n_et == 0 || !(equave_log2fr > 0.0) || !(min_log2fr <= max_log2fr)) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    return guarded([&]() {
+        PitchSet pitches = generateETPitchSet(n_et, equave_log2fr, min_log2fr, max_log2fr);
+        *out = new scalatrix_pitchset_index{PitchSetIndex(pitches, equave_log2fr)};
+    });
+}
+
+scalatrix_status scalatrix_pitchset_index_create(const double* log2frs, size_t n, double equave_log2fr,
+                                                 scalatrix_pitchset_index** out) {
+    if (!out) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    *out = nullptr;
+    if ((n > 0 && !log2frs) || !(equave_log2fr > 0.0)) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    for (size_t i = 0; i < n; ++i) {
+        if (!std::isfinite(log2frs[i])) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    }
+    return guarded([&]() {
+        PitchSet pitches(n);
+        for (size_t i = 0; i < n; ++i) pitches[i].log2fr = log2frs[i];
+        *out = new scalatrix_pitchset_index{PitchSetIndex(pitches, equave_log2fr)};
+    });
+}
+
+scalatrix_status scalatrix_pitchset_index_load(const char* path, scalatrix_pitchset_index** out) {
+    if (!out) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    *out = nullptr;
+    if (!path) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    return guarded([&]() { *out = new scalatrix_pitchset_index{PitchSetIndex::load(path)}; });
+}
+
+void scalatrix_pitchset_index_destroy(scalatrix_pitchset_index* index) {
+    delete index;
+}
+
+scalatrix_status scalatrix_pitchset_index_size(const scalatrix_pitchset_index* index, size_t* out) {
+    if (!index || !out) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    *out = index->index.size();
+    return SCALATRIX_OK;
+}
+
+scalatrix_status scalatrix_pitchset_index_get_log2frs(const scalatrix_pitchset_index* index, double* out,
+                                                      size_t capacity) {
+    if (!index || (capacity > 0 && !out)) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    const PitchSetIndex& idx = index->index;
+    if (idx.size() > capacity) return SCALATRIX_ERROR_BUFFER_TOO_SMALL;
+    std::copy(idx.log2frs(), idx.log2frs() + idx.size(), out);
+    return SCALATRIX_OK;
+}
+
+scalatrix_status scalatrix_pitchset_index_nearest(const scalatrix_pitchset_index* index, const double* log2frs,
+                                                  size_t n, uint32_t* out) {
+    if (!index || index->index.empty() || (n > 0 && (!log2frs || !out))) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    index->index.nearest(log2frs, n, out);
+    return SCALATRIX_OK;
+}
+
+// Batch
+
+void scalatrix_set_concurrency_limit(unsigned limit) {
+    setConcurrencyLimit(limit);
+}
+
+unsigned scalatrix_concurrency_limit(void) {
+    return concurrencyLimit();
+}
+
+scalatrix_status scalatrix_generate_mos_pitches(const scalatrix_mos_params* params, size_t n, double base_freq,
+                                                int n_nodes, int root, unsigned n_threads, double* pitches) {
+    if ((n > 0 && (!params || !pitches)) || !validFreq(base_freq) || !validKeyboard(n_nodes, root)) {
+        return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    }
+    for (size_t s = 0; s < n; ++s) {
+        if (!validParams(&params[s])) return SCALATRIX_ERROR_INVALID_ARGUMENT;
+    }
+    return guarded([&]() {
+        std::vector<MOSParams> list(n);
+        for (size_t s = 0; s < n; ++s) {
+            list[s] = {params[s].a, params[s].b, params[s].mode, params[s].equave, params[s].generator};
+        }
+        ScaleArrays arrays = generateMOSScales(list, base_freq, n_nodes, root, n_threads);
+        std::copy(arrays.pitches.begin(), arrays.pitches.end(), pitches);
+    });
+}
+
+} // extern "C"
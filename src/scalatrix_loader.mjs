@@ -0,0 +1,61 @@
+// Loads the fastest scalatrix Wasm module the browser supports. All variants are built
+// from the same bindings (see BUILD_WASM_VARIANTS in CMakeLists.txt), so callers use the
+// returned module the same way whichever one is picked.
+
+// Smallest module using a SIMD128 instruction, from the wasm-feature-detect probes
+const SIMD_PROBE = new Uint8Array([
+    0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1, 8, 0, 65, 0, 253, 15, 253, 98, 11,
+]);
+
+export function supportsSimd() {
+    try {
+        return WebAssembly.validate(SIMD_PROBE);
+    } catch (e) {
+        return false;
+    }
+}
+
+// pthreads need SharedArrayBuffer, which browsers only enable on cross-origin isolated pages
+export function supportsThreads() {
+    return typeof SharedArrayBuffer !== 'undefined' && globalThis.crossOriginIsolated === true;
+}
+
+// Module names in order of preference
+export function scalatrixVariants() {
+    const variants = [];
+    if (supportsSimd()) {
+        if (supportsThreads()) variants.push('scalatrix_simd_threads');
+        variants.push('scalatrix_simd');
+    }
+    variants.push('scalatrix');
+    return variants;
+}
+
+/**
+ * Instantiates the first variant that loads, falling back to the baseline module when a
+ * variant was not built.
+ *
+ * @param options.baseUrl Directory holding the modules, defaults to the loader's own
+ * @param options.variant Forces one module, e.g. 'scalatrix'
+ * @param options.core Prefers scalatrix_core (size profile builds), which has no label or
+ *     pitch set bindings. Load the full module later when those are needed; objects
+ *     cannot be passed between the two module instances.
+ * @param options.moduleArgs Passed to the Emscripten module factory
+ */
+export default async function loadScalatrix(options = {}) {
+    const baseUrl = options.baseUrl ?? new URL('.', import.meta.url).href;
+    let variants = options.variant ? [options.variant] : scalatrixVariants();
+    if (options.core && !options.variant) variants = ['scalatrix_core', ...variants];
+    let lastError;
+    for (const variant of variants) {
+        try {
+            const { default: factory } = await import(new URL(`${variant}.js`, baseUrl).href);
+            const module = await factory(options.moduleArgs ?? {});
+            module.scalatrixVariant = variant;
+            return module;
+        } catch (e) {
+            lastError = e;
+        }
+    }
+    throw lastError;
+}
@@ -1,11 +1,19 @@
 #include "scalatrix/scale.hpp"
 #include "scalatrix/lattice.hpp"
+#include "scalatrix/parallel.hpp"
+#include <algorithm>
 #include <iostream>
 #include <cassert>
 #include <cmath>
 
 namespace scalatrix {
 
+static long long floorDiv(long long num, long long den) {
+    long long q = num / den;
+    if ((num % den != 0) && ((num < 0) != (den < 0))) q--;
+    return q;
+}
+
 void Scale::initNodes(int N){
     nodes_.clear();
     nodes_.reserve(N);
@@ -101,6 +109,112 @@ void Scale::recalcWithAffine(const AffineTransform& A, int N, int root_node_idx)
     }
 }
 
+/*static*/
+Scale Scale::fromRationalAffine(const RationalAffineTransform& A, const double base_freq, int N, int root_node_idx) {
+    Scale scale(base_freq, N, root_node_idx);
+    scale.recalcWithRationalAffine(A, N, root_node_idx);
+    return scale;
+}
+
+/**
+ * Generates the strip nodes from one exactly computed period
+ *
+ * No step selection is needed: node i is a table lookup plus a multiple of the
+ * period vector, so the loop has no data-dependent branches.
+ */
+void Scale::recalcWithRationalAffine(const RationalAffineTransform& A, int N, int root_node_idx) {
+    StripPeriod strip = findStripPeriod(A);
+    long long m = (long long)strip.nodes.size();
+
+    nodes_.resize(N);
+    root_idx_ = root_node_idx;
+    for (int i = 0; i < N; ++i) {
+        long long idx = strip.root + (long long)(i - root_node_idx);
+        long long q = floorDiv(idx, m);
+        Node& node = nodes_[i];
+        node = Node();
+        node.natural_coord = strip.nodes[idx - q * m] + strip.period * (int)q;
+        node.tuning_coord = A.applyToDouble(node.natural_coord);
+        node.pitch = base_freq_ * std::exp2(node.tuning_coord.x);
+    }
+    if (0 <= root_node_idx && root_node_idx < N) {
+        nodes_[root_node_idx].pitch = base_freq_;
+    }
+}
+
+/*static*/
+Scale Scale::fromPeriodicityBlock(const AffineTransform& A, const Vector2i& u1, const Vector2i& u2,
+                                  double base_freq, Vector2d offset) {
+    Scale scale(base_freq, 0, 0);
+    scale.recalcWithPeriodicityBlock(A, u1, u2, offset);
+    return scale;
+}
+
+/*static*/
+std::vector<Scale> Scale::fromPeriodicityBlocks(const AffineTransform& A,
+                                                const std::vector<std::pair<Vector2i, Vector2i>>& unison_vectors,
+                                                double base_freq, Vector2d offset, unsigned n_threads) {
+    std::vector<Scale> scales(unison_vectors.size(), Scale(base_freq, 0, 0));
+    parallelFor(0, unison_vectors.size(), [&](size_t i) {
+        scales[i].recalcWithPeriodicityBlock(A, unison_vectors[i].first, unison_vectors[i].second, offset);
+    }, n_threads);
+    return scales;
+}
+
+/**
+ * Enumerates the periodicity block spanned by u1, u2
+ *
+ * The points 0 <= x < h1.x, 0 <= y < h2.y of the Hermite basis are one representative
+ * of every residue class modulo the unison vectors. Each is moved into the parallelogram
+ * by subtracting the integer parts of its (s, t) coefficients, which are exact rationals
+ * with denominator det(u1, u2).
+ */
+void Scale::recalcWithPeriodicityBlock(const AffineTransform& A, const Vector2i& u1, const Vector2i& u2,
+                                       Vector2d offset) {
+    long long det = (long long)u1.x * u2.y - (long long)u1.y * u2.x;
+    assert(det != 0);
+    auto [h1, h2] = hermiteBasis(u1, u2);
+
+    // exact integer offsets avoid rounding at the parallelogram edges
+    bool integer_offset = offset.x == std::floor(offset.x) && offset.y == std::floor(offset.y);
+
+    nodes_.clear();
+    nodes_.reserve((size_t)std::abs(det));
+    for (int y = 0; y < h2.y; ++y) {
+        for (int x = 0; x < h1.x; ++x) {
+            // r = (s_num * u1 + t_num * u2) / det
+            long long s_num = (long long)x * u2.y - (long long)y * u2.x;
+            long long t_num = (long long)u1.x * y - (long long)u1.y * x;
+            long long fs, ft;
+            if (integer_offset) {
+                fs = floorDiv(s_num - (long long)offset.x * det, det);
+                ft = floorDiv(t_num - (long long)offset.y * det, det);
+            } else {
+                fs = (long long)std::floor((double)s_num / det - offset.x);
+                ft = (long long)std::floor((double)t_num / det - offset.y);
+            }
+            Node node;
+            node.natural_coord = Vector2i((int)(x - fs * u1.x - ft * u2.x), (int)(y - fs * u1.y - ft * u2.y));
+            node.tuning_coord = A * node.natural_coord;
+            node.pitch = base_freq_ * std::exp2(node.tuning_coord.x);
+            nodes_.push_back(node);
+        }
+    }
+
+    std::sort(nodes_.begin(), nodes_.end(), [](const Node& a, const Node& b) {
+        if (a.tuning_coord.x != b.tuning_coord.x) return a.tuning_coord.x < b.tuning_coord.x;
+        return a.natural_coord < b.natural_coord;
+    });
+
+    root_idx_ = 0;
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        if (nodes_[i].natural_coord == Vector2i(0, 0)) {
+            root_idx_ = (int)i;
+            break;
+        }
+    }
+}
+
 void Scale::retuneWithAffine(const AffineTransform& A) {
     for (int n = 0; n < nodes_.size(); ++n) {
         Node& node = nodes_[n];
@@ -136,27 +250,29 @@ void Scale::print(int first, int num) const {
 }
 
 void Scale::temperToPitchSet(PitchSet& pitchset){
-    // find the closest pitch in pitchset to each node in base_scale
-    for (auto& node : nodes_) {
-        double node_pitch_log2fr = log2(node.pitch/base_freq_);
-        double closest_pitch_log2fr = 0.0;
-        double min_dist = 1e6;
-        PitchSetPitch closest_pitch;
-        for (auto& pitch : pitchset) {
-            double dist = std::abs(pitch.log2fr - node_pitch_log2fr);
-            if (dist < min_dist) {
-                min_dist = dist;
-                closest_pitch_log2fr = pitch.log2fr;
-                closest_pitch = pitch;
-            }
-        }
-        //node.tuning_coord.x = closest_pitch_log2fr;
-        node.pitch = base_freq_ * exp2(closest_pitch_log2fr);
+    if (pitchset.empty()) return;
+    temperToPitchSet(PitchSetIndex(pitchset));
+}
+
+void Scale::temperToPitchSet(const PitchSetIndex& index){
+    if (index.empty()) return;
+    // find the closest pitch in the index to each node in base_scale, searching all nodes
+    // at once with the branchless batch search
+    std::vector<double> log2frs(nodes_.size());
+    std::vector<uint32_t> closest(nodes_.size());
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        log2frs[i] = log2(nodes_[i].pitch/base_freq_);
+    }
+    index.nearest(log2frs.data(), log2frs.size(), closest.data());
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        Node& node = nodes_[i];
+        PitchSetPitch closest_pitch = index.pitch(closest[i]);
+        node.pitch = base_freq_ * exp2(closest_pitch.log2fr);
         node.isTempered = true;
         node.temperedPitch = closest_pitch;
         node.closestPitch = closest_pitch;
     }
-};
+}
 
 
 std::vector<Node>& Scale::getNodes(){
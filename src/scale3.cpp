@@ -0,0 +1,76 @@
+#include "scalatrix/scale3.hpp"
+#include <cassert>
+#include <cmath>
+
+namespace scalatrix {
+
+Scale3::Scale3(double base_freq, int N, int root_node_idx)
+    : nodes_(N), base_freq_(base_freq), root_idx_(root_node_idx) {}
+
+/*static*/
+Scale3 Scale3::fromAffine(const AffineTransform3& A, double base_freq, int N, int root_node_idx) {
+    Scale3 scale(base_freq, N, root_node_idx);
+    scale.recalcWithAffine(A, N, root_node_idx);
+    return scale;
+}
+
+static bool inPrism(const Vector3d& w) {
+    return 0 <= w.y && w.y < 1 && 0 <= w.z && w.z < 1;
+}
+
+void Scale3::recalcWithAffine(const AffineTransform3& A, int N, int root_node_idx) {
+    assert(0 <= root_node_idx && root_node_idx < N);
+    nodes_.assign(N, Node3());
+    root_idx_ = root_node_idx;
+
+    AffineTransform3 M = A;
+    M.tx = M.ty = M.tz = 0;
+    // the prism has unit cross-section, so nodes are on average |det M| apart in x
+    double max_step = 4.0 * std::abs(M.det());
+    assert(max_step > 0);
+    std::vector<Vector3i> steps = findStepsWithinPrism(M, max_step);
+
+    Node3 root(Vector3i(0, 0, 0), A * Vector3i(0, 0, 0), base_freq_);
+    assert(inPrism(root.tuning_coord));
+    nodes_[root_node_idx] = root;
+
+    // Walks dir = +1 (forward) or -1 (backward) from the root. If no known step stays
+    // inside the prism the gap is larger than max_step, so the step set is extended.
+    auto walk = [&](int dir, int count) {
+        Node3 last = root;
+        for (int n = 1; n <= count; ++n) {
+            bool found = false;
+            while (!found) {
+                for (const auto& s : steps) {
+                    Vector3i v = dir > 0 ? last.natural_coord + s : last.natural_coord - s;
+                    Vector3d w = A * v;
+                    if (inPrism(w)) {
+                        last.natural_coord = v;
+                        last.tuning_coord = w;
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found) {
+                    max_step *= 2;
+                    assert(max_step < 1e9);
+                    steps = findStepsWithinPrism(M, max_step);
+                }
+            }
+            last.pitch = base_freq_ * std::exp2(last.tuning_coord.x);
+            nodes_[root_node_idx + dir * n] = last;
+        }
+    };
+
+    walk(+1, N - root_node_idx - 1);
+    walk(-1, root_node_idx);
+}
+
+void Scale3::retuneWithAffine(const AffineTransform3& A) {
+    for (auto& node : nodes_) {
+        node.tuning_coord = A * node.natural_coord;
+        node.pitch = base_freq_ * std::exp2(node.tuning_coord.x);
+    }
+}
+
+} // namespace scalatrix
@@ -0,0 +1,109 @@
+#include "scalatrix/scale_arrays.hpp"
+#include "scalatrix/mos.hpp"
+#include "scalatrix/parallel.hpp"
+#include <cassert>
+#include <cmath>
+
+namespace scalatrix {
+
+namespace {
+
+template <typename F>
+ScaleArrays generateRows(const std::vector<MOSParams>& params, double base_freq, int n_nodes, int root,
+                         unsigned n_threads, F&& finish) {
+    assert(n_nodes >= 0);
+    ScaleArrays arrays;
+    arrays.resize(params.size(), (size_t)n_nodes);
+    parallelFor(0, params.size(), [&](size_t s) {
+        MOS mos = MOS::fromParams(params[s].a, params[s].b, params[s].m, params[s].e, params[s].r);
+        Scale scale = mos.generateScaleFromMOS(base_freq, n_nodes, root);
+        finish(scale);
+        arrays.setScale(s, scale);
+    }, n_threads);
+    return arrays;
+}
+
+} // namespace
+
+void ScaleArrays::resize(size_t scales, size_t nodes) {
+    n_scales = scales;
+    n_nodes = nodes;
+    natural_coords.assign(scales * nodes * 2, 0);
+    tuning_coords.assign(scales * nodes * 2, 0.0);
+    pitches.assign(scales * nodes, 0.0);
+    tempered.assign(scales * nodes, 0);
+    tempered_log2frs.assign(scales * nodes, 0.0);
+}
+
+void ScaleArrays::setScale(size_t s, const Scale& scale) {
+    const std::vector<Node>& nodes = scale.getNodes();
+    assert(s < n_scales);
+    assert(nodes.size() == n_nodes);
+    size_t first = s * n_nodes;
+    for (size_t i = 0; i < n_nodes; ++i) {
+        const Node& node = nodes[i];
+        size_t k = first + i;
+        natural_coords[2 * k] = node.natural_coord.x;
+        natural_coords[2 * k + 1] = node.natural_coord.y;
+        tuning_coords[2 * k] = node.tuning_coord.x;
+        tuning_coords[2 * k + 1] = node.tuning_coord.y;
+        pitches[k] = node.pitch;
+        tempered[k] = node.isTempered ? 1 : 0;
+        tempered_log2frs[k] = node.isTempered ? node.temperedPitch.log2fr : 0.0;
+    }
+}
+
+ScaleArrays generateMOSScales(const std::vector<MOSParams>& params, double base_freq, int n_nodes, int root,
+                              unsigned n_threads) {
+    return generateRows(params, base_freq, n_nodes, root, n_threads, [](Scale&) {});
+}
+
+ScaleArrays temperMOSScales(const std::vector<MOSParams>& params, const PitchSetIndex& index, double base_freq,
+                            int n_nodes, int root, unsigned n_threads) {
+    return generateRows(params, base_freq, n_nodes, root, n_threads,
+                        [&index](Scale& scale) { scale.temperToPitchSet(index); });
+}
+
+void fillScaleArrays(const Scale& scale, ScaleArrays& out) {
+    out.resize(1, scale.getNodes().size());
+    out.setScale(0, scale);
+}
+
+void fillMOSScaleArrays(MOS& mos, double base_freq, int n_nodes, int root, ScaleArrays& out) {
+    fillScaleArrays(mos.generateScaleFromMOS(base_freq, n_nodes, root), out);
+}
+
+void fillLatticeArrays(const MOS& mos, Vector2i min, Vector2i max, double base_freq, ScaleArrays& out) {
+    assert(min.x <= max.x && min.y <= max.y);
+    size_t width = (size_t)(max.x - min.x + 1);
+    size_t height = (size_t)(max.y - min.y + 1);
+    out.resize(1, width * height);
+    // one row at a time through the batch transform, which has a SIMD128 kernel
+    std::vector<Vector2i> row(width);
+    std::vector<Vector2d> tuning(width);
+    size_t k = 0;
+    for (int y = min.y; y <= max.y; ++y) {
+        for (size_t i = 0; i < width; ++i) row[i] = {min.x + (int)i, y};
+        mos.impliedAffine.apply(row.data(), width, tuning.data());
+        for (size_t i = 0; i < width; ++i, ++k) {
+            out.natural_coords[2 * k] = row[i].x;
+            out.natural_coords[2 * k + 1] = y;
+            out.tuning_coords[2 * k] = tuning[i].x;
+            out.tuning_coords[2 * k + 1] = tuning[i].y;
+            out.pitches[k] = base_freq * std::exp2(tuning[i].x);
+        }
+    }
+}
+
+ScaleArrays temperScales(const Scale& scale, const std::vector<PitchSetIndex>& indices, unsigned n_threads) {
+    ScaleArrays arrays;
+    arrays.resize(indices.size(), scale.getNodes().size());
+    parallelFor(0, indices.size(), [&](size_t s) {
+        Scale tempered = scale;
+        tempered.temperToPitchSet(indices[s]);
+        arrays.setScale(s, tempered);
+    }, n_threads);
+    return arrays;
+}
+
+} // namespace scalatrix
@@ -0,0 +1,80 @@
+#include "scalatrix/tuning_table.hpp"
+#include <cassert>
+#include <new>
+
+namespace scalatrix {
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "sequence must be a plain 32-bit word");
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "sequence must be lock-free");
+static_assert(sizeof(std::atomic<double>) == sizeof(double), "values must be plain 64-bit doubles");
+static_assert(std::atomic<double>::is_always_lock_free, "values must be lock-free");
+
+TuningTable::TuningTable(size_t n_keys, double sample_rate)
+    : n_keys_(n_keys), storage_(new uint64_t[2 + 2 * n_keys]()) {
+    assert(sample_rate > 0.0);
+    char* base = reinterpret_cast<char*>(storage_.get());
+    sequence_ = new (base) std::atomic<uint32_t>(0);
+    new (base + 4) uint32_t((uint32_t)n_keys);
+    sample_rate_ = new (base + 8) std::atomic<double>(sample_rate);
+    frequencies_ = reinterpret_cast<std::atomic<double>*>(base + HEADER_BYTES);
+    phase_increments_ = frequencies_ + n_keys;
+    for (size_t i = 0; i < 2 * n_keys; ++i) {
+        new (frequencies_ + i) std::atomic<double>(0.0);
+    }
+}
+
+// Single writer: the odd sequence tells readers to retry, the fences order the values
+// between the two sequence stores
+template <typename F>
+void TuningTable::write(F&& update) {
+    uint32_t seq = sequence_->load(std::memory_order_relaxed);
+    sequence_->store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    update();
+    const double inv_rate = 1.0 / sample_rate_->load(std::memory_order_relaxed);
+    for (size_t i = 0; i < n_keys_; ++i) {
+        phase_increments_[i].store(frequencies_[i].load(std::memory_order_relaxed) * inv_rate,
+                                   std::memory_order_relaxed);
+    }
+    sequence_->store(seq + 2, std::memory_order_release);
+}
+
+void TuningTable::publish(const Scale& scale) {
+    const std::vector<Node>& nodes = scale.getNodes();
+    write([&]() {
+        for (size_t i = 0; i < n_keys_; ++i) {
+            frequencies_[i].store(i < nodes.size() ? nodes[i].pitch : 0.0, std::memory_order_relaxed);
+        }
+    });
+}
+
+void TuningTable::publish(const double* frequencies, size_t n) {
+    write([&]() {
+        for (size_t i = 0; i < n_keys_; ++i) {
+            frequencies_[i].store(i < n ? frequencies[i] : 0.0, std::memory_order_relaxed);
+        }
+    });
+}
+
+void TuningTable::setSampleRate(double sample_rate) {
+    assert(sample_rate > 0.0);
+    write([&]() { sample_rate_->store(sample_rate, std::memory_order_relaxed); });
+}
+
+bool TuningTable::tryRead(double* frequencies, double* phase_increments) const {
+    uint32_t before = sequence_->load(std::memory_order_acquire);
+    if (before & 1) return false;
+    for (size_t i = 0; i < n_keys_; ++i) {
+        if (frequencies) frequencies[i] = frequencies_[i].load(std::memory_order_relaxed);
+        if (phase_increments) phase_increments[i] = phase_increments_[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return sequence_->load(std::memory_order_relaxed) == before;
+}
+
+void TuningTable::read(double* frequencies, double* phase_increments) const {
+    while (!tryRead(frequencies, phase_increments)) {
+    }
+}
+
+} // namespace scalatrix
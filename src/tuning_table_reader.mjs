@@ -0,0 +1,68 @@
+// Lock-free reader for a scalatrix TuningTable (see include/scalatrix/tuning_table.hpp),
+// safe to use from an AudioWorkletProcessor: no allocations after construction and no
+// calls into the Wasm module.
+//
+// Layout: uint32 sequence, uint32 key count, float64 sample rate, float64 frequency[n],
+// float64 phase_increment[n]. The sequence is odd while the writer is publishing.
+
+export const HEADER_BYTES = 16;
+
+export function tuningTableByteLength(nKeys) {
+    return HEADER_BYTES + 16 * nKeys;
+}
+
+export class TuningTableReader {
+    /**
+     * @param buffer SharedArrayBuffer holding the table: the Wasm memory of a pthreads
+     *     build, or a buffer filled with mirrorTuningTable
+     * @param byteOffset Offset of the table, 8-byte aligned
+     */
+    constructor(buffer, byteOffset = 0) {
+        this.header = new Int32Array(buffer, byteOffset, 2);
+        this.size = this.header[1];
+        this.sampleRate = new Float64Array(buffer, byteOffset + 8, 1);
+        this.frequencies = new Float64Array(buffer, byteOffset + HEADER_BYTES, this.size);
+        this.phaseIncrements = new Float64Array(buffer, byteOffset + HEADER_BYTES + 8 * this.size, this.size);
+        this.lastSequence = -1;
+    }
+
+    sequence() {
+        return Atomics.load(this.header, 0);
+    }
+
+    // True when a publish has completed since the last successful read
+    changed() {
+        const seq = this.sequence();
+        return (seq & 1) === 0 && seq !== this.lastSequence;
+    }
+
+    /**
+     * Copies a consistent snapshot into the given Float64Arrays, either may be null.
+     * Returns false if a publish was in progress; keep the previous values and retry
+     * on the next render quantum.
+     */
+    tryRead(frequencies, phaseIncrements) {
+        const before = Atomics.load(this.header, 0);
+        if (before & 1) return false;
+        if (frequencies) frequencies.set(this.frequencies);
+        if (phaseIncrements) phaseIncrements.set(this.phaseIncrements);
+        if (Atomics.load(this.header, 0) !== before) return false;
+        this.lastSequence = before;
+        return true;
+    }
+}
+
+/**
+ * Copies a table from the Wasm heap into a SharedArrayBuffer for builds without pthreads,
+ * keeping the seqlock protocol on the target. Call it after each publish from the thread
+ * that publishes.
+ *
+ * @param source Uint8Array returned by TuningTable.bytes()
+ */
+export function mirrorTuningTable(source, target, byteOffset = 0) {
+    const header = new Int32Array(target, byteOffset, 1);
+    const seq = Atomics.load(header, 0) & ~1;
+    Atomics.store(header, 0, seq + 1);
+    new Uint8Array(target, byteOffset + 4, source.length - 4).set(source.subarray(4));
+    Atomics.store(header, 0, seq + 2);
+}
@@ -0,0 +1,69 @@
+// Build report for the Wasm modules: download size (raw and gzip) and instantiation time.
+//
+//   node wasm_report.mjs <build dir> [runs]
+//
+// Every scalatrix*.js module in the directory is measured; its .wasm is counted when it
+// is a separate file (size profile) rather than embedded (SINGLE_FILE). Instantiation
+// time is the median over the runs of the module factory, which compiles and
+// instantiates the Wasm binary. Results are printed and written to wasm_report.json.
+
+import { readdirSync, readFileSync, statSync, writeFileSync, existsSync } from 'node:fs';
+import { join, resolve } from 'node:path';
+import { pathToFileURL } from 'node:url';
+import { gzipSync } from 'node:zlib';
+import { performance } from 'node:perf_hooks';
+
+const dir = resolve(process.argv[2] ?? '.');
+const runs = Number(process.argv[3] ?? 5);
+
+function sizes(path) {
+    if (!existsSync(path)) return { bytes: 0, gzip_bytes: 0 };
+    const data = readFileSync(path);
+    return { bytes: statSync(path).size, gzip_bytes: gzipSync(data, { level: 9 }).length };
+}
+
+function median(values) {
+    const sorted = [...values].sort((a, b) => a - b);
+    return sorted[Math.floor(sorted.length / 2)];
+}
+
+async function instantiationTimes(path) {
+    const { default: factory } = await import(pathToFileURL(path).href);
+    const times = [];
+    for (let i = 0; i < runs; ++i) {
+        const start = performance.now();
+        await factory();
+        times.push(performance.now() - start);
+    }
+    return times;
+}
+
+const modules = readdirSync(dir)
+    .filter((name) => /^scalatrix.*\.js$/.test(name))
+    .sort();
+
+const report = { generated: new Date().toISOString(), runs, modules: [] };
+for (const name of modules) {
+    const base = name.slice(0, -3);
+    const js = sizes(join(dir, name));
+    const wasm = sizes(join(dir, `${base}.wasm`));
+    const entry = {
+        module: base,
+        js_bytes: js.bytes,
+        wasm_bytes: wasm.bytes,
+        total_gzip_bytes: js.gzip_bytes + wasm.gzip_bytes,
+        single_file: wasm.bytes === 0,
+    };
+    try {
+        const times = await instantiationTimes(join(dir, name));
+        entry.instantiate_ms_median = Number(median(times).toFixed(2));
+        entry.instantiate_ms_first = Number(times[0].toFixed(2));
+    } catch (e) {
+        // pthreads modules need a worker environment and are only sized
+        entry.instantiate_error = String(e.message ?? e);
+    }
+    report.modules.push(entry);
+}
+
+console.table(report.modules);
+writeFileSync(join(dir, 'wasm_report.json'), JSON.stringify(report, null, 2) + '\n');
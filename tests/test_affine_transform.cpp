@@ -2,6 +2,8 @@
 #include "catch2/catch_test_macros.hpp"
 #include "catch2/matchers/catch_matchers_floating_point.hpp"
 #include "scalatrix/params.hpp"
+#include "scalatrix/affine_transform.hpp"
+#include <vector>
 #include <cmath>
 
 using namespace scalatrix;
@@ -105,4 +107,30 @@ TEST_CASE("affineFromThreeDots shear transformation", "[affine]") {
     REQUIRE_THAT(result.d, WithinAbs(1.0, 1e-10));
     REQUIRE_THAT(result.tx, WithinAbs(0.0, 1e-10));
     REQUIRE_THAT(result.ty, WithinAbs(0.0, 1e-10));
-}
\ No newline at end of file
+}
+
+TEST_CASE("IntegerAffineTransform::linearFromTwoDots", "[affine]") {
+    // evaluated at compile time
+    constexpr IntegerAffineTransform M = IntegerAffineTransform::linearFromTwoDots({1, 0}, {1, 1}, {3, 1}, {5, 2});
+    static_assert(M.a == 3 && M.b == 2 && M.c == 1 && M.d == 1, "maps (1, 0) to (3, 1) and (1, 1) to (5, 2)");
+    static_assert(M.tx == 0 && M.ty == 0, "linear");
+
+    REQUIRE(M.apply({1, 0}) == Vector2i(3, 1));
+    REQUIRE(M.apply({1, 1}) == Vector2i(5, 2));
+
+    SECTION("Batch form matches single calls") {
+        std::vector<Vector2i> b1 = {{3, 1}, {2, 1}, {1, 0}, {-1, 2}};
+        std::vector<Vector2i> b2 = {{5, 2}, {7, 5}, {1, 1}, {1, 3}};
+        std::vector<IntegerAffineTransform> out(b1.size());
+        IntegerAffineTransform::linearFromTwoDots({1, 0}, {1, 1}, b1.data(), b2.data(), b1.size(), out.data());
+        for (size_t i = 0; i < b1.size(); ++i) {
+            IntegerAffineTransform single = IntegerAffineTransform::linearFromTwoDots({1, 0}, {1, 1}, b1[i], b2[i]);
+            REQUIRE(out[i].a == single.a);
+            REQUIRE(out[i].b == single.b);
+            REQUIRE(out[i].c == single.c);
+            REQUIRE(out[i].d == single.d);
+            REQUIRE(out[i].apply({1, 0}) == b1[i]);
+            REQUIRE(out[i].apply({1, 1}) == b2[i]);
+        }
+    }
+}
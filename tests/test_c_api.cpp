@@ -0,0 +1,248 @@
+#include "catch2/catch_test_macros.hpp"
+#include "scalatrix/scalatrix_c.h"
+#include "scalatrix/mos.hpp"
+#include "scalatrix/pitchset_index.hpp"
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace scalatrix;
+
+// Counts heap allocations so the tests can check that the retune path makes none. Every
+// replaceable form of new and delete is replaced, so each delete frees what its new allocated.
+static std::atomic<size_t> allocation_count{0};
+
+static void* countedAlloc(size_t size, size_t alignment) noexcept {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (alignment <= alignof(std::max_align_t)) return std::malloc(size ? size : 1);
+    // over-aligned: keep the malloc pointer just below the aligned block
+    void* raw = std::malloc(size + alignment + sizeof(void*));
+    if (!raw) return nullptr;
+    uintptr_t aligned = ((uintptr_t)raw + sizeof(void*) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    reinterpret_cast<void**>(aligned)[-1] = raw;
+    return reinterpret_cast<void*>(aligned);
+}
+
+static void countedFree(void* p, size_t alignment) noexcept {
+    if (!p) return;
+    std::free(alignment <= alignof(std::max_align_t) ? p : static_cast<void**>(p)[-1]);
+}
+
+static void* countedAllocOrThrow(size_t size, size_t alignment) {
+    if (void* p = countedAlloc(size, alignment)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size) { return countedAllocOrThrow(size, 0); }
+void* operator new[](size_t size) { return countedAllocOrThrow(size, 0); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size, 0); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size, 0); }
+void* operator new(size_t size, std::align_val_t al) { return countedAllocOrThrow(size, (size_t)al); }
+void* operator new[](size_t size, std::align_val_t al) { return countedAllocOrThrow(size, (size_t)al); }
+void* operator new(size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return countedAlloc(size, (size_t)al); }
+void* operator new[](size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return countedAlloc(size, (size_t)al); }
+
+void operator delete(void* p) noexcept { countedFree(p, 0); }
+void operator delete[](void* p) noexcept { countedFree(p, 0); }
+void operator delete(void* p, size_t) noexcept { countedFree(p, 0); }
+void operator delete[](void* p, size_t) noexcept { countedFree(p, 0); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { countedFree(p, 0); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { countedFree(p, 0); }
+void operator delete(void* p, std::align_val_t al) noexcept { countedFree(p, (size_t)al); }
+void operator delete[](void* p, std::align_val_t al) noexcept { countedFree(p, (size_t)al); }
+void operator delete(void* p, size_t, std::align_val_t al) noexcept { countedFree(p, (size_t)al); }
+void operator delete[](void* p, size_t, std::align_val_t al) noexcept { countedFree(p, (size_t)al); }
+void operator delete(void* p, std::align_val_t al, const std::nothrow_t&) noexcept { countedFree(p, (size_t)al); }
+void operator delete[](void* p, std::align_val_t al, const std::nothrow_t&) noexcept { countedFree(p, (size_t)al); }
+
+TEST_CASE("C API matches the C++ classes", "[c_api]") {
+    scalatrix_mos_params params = {5, 2, 1, 1.0, 0.585};
+    scalatrix_mos* mos = nullptr;
+    REQUIRE(scalatrix_mos_create(&params, &mos) == SCALATRIX_OK);
+    REQUIRE(mos != nullptr);
+    MOS reference = MOS::fromParams(5, 2, 1, 1.0, 0.585);
+
+    int n = 0;
+    REQUIRE(scalatrix_mos_size(mos, &n) == SCALATRIX_OK);
+    REQUIRE(n == 7);
+
+    scalatrix_scale* scale = nullptr;
+    REQUIRE(scalatrix_scale_create_from_mos(mos, 261.6, 24, 7, &scale) == SCALATRIX_OK);
+    Scale expected = reference.generateScaleFromMOS(261.6, 24, 7);
+    size_t size = 0;
+    REQUIRE(scalatrix_scale_size(scale, &size) == SCALATRIX_OK);
+    REQUIRE(size == 24);
+
+    std::vector<double> pitches(24), tuning(48);
+    std::vector<int32_t> natural(48);
+    REQUIRE(scalatrix_scale_get_pitches(scale, pitches.data(), pitches.size()) == SCALATRIX_OK);
+    REQUIRE(scalatrix_scale_get_natural_coords(scale, natural.data(), 24) == SCALATRIX_OK);
+    REQUIRE(scalatrix_scale_get_tuning_coords(scale, tuning.data(), 24) == SCALATRIX_OK);
+    for (size_t i = 0; i < 24; ++i) {
+        const Node& node = expected.getNodes()[i];
+        REQUIRE(pitches[i] == node.pitch);
+        REQUIRE(natural[2 * i] == node.natural_coord.x);
+        REQUIRE(natural[2 * i + 1] == node.natural_coord.y);
+        REQUIRE(tuning[2 * i] == node.tuning_coord.x);
+    }
+
+    SECTION("Retuning follows MOS::retune* without allocating") {
+        int32_t fixed[4] = {0, 0, 5, 2};
+        size_t before = allocation_count.load();
+        scalatrix_status one = scalatrix_mos_retune_one_point(mos, 1, 0, 0.18);
+        scalatrix_status two = scalatrix_mos_retune_two_points(mos, 0, 0, 1, 1, 0.6);
+        scalatrix_status three = scalatrix_mos_retune_three_points(mos, fixed, 1, 0, 0.17);
+        scalatrix_status retune = scalatrix_scale_retune_with_mos(scale, mos, 261.6);
+        scalatrix_status get = scalatrix_scale_get_pitches(scale, pitches.data(), pitches.size());
+        size_t allocations = allocation_count.load() - before;
+
+        REQUIRE(one == SCALATRIX_OK);
+        REQUIRE(two == SCALATRIX_OK);
+        REQUIRE(three == SCALATRIX_OK);
+        REQUIRE(retune == SCALATRIX_OK);
+        REQUIRE(get == SCALATRIX_OK);
+        REQUIRE(allocations == 0);
+
+        reference.retuneOnePoint({1, 0}, 0.18);
+        reference.retuneTwoPoints({0, 0}, {1, 1}, 0.6);
+        reference.retuneThreePoints({0, 0}, {5, 2}, {1, 0}, 0.17);
+        reference.retuneScaleWithMOS(expected, 261.6);
+        for (size_t i = 0; i < 24; ++i) {
+            REQUIRE(pitches[i] == expected.getNodes()[i].pitch);
+        }
+
+        scalatrix_mos_params retuned;
+        REQUIRE(scalatrix_mos_get_params(mos, &retuned) == SCALATRIX_OK);
+        REQUIRE(retuned.generator == reference.generator);
+        REQUIRE(retuned.equave == reference.equave);
+    }
+
+    SECTION("Batch coordinate queries") {
+        std::vector<double> coords = {0, 0, 1, 0, 0.5, 1.5, -3, 2};
+        std::vector<int32_t> nodes = {0, 0, 1, 0, 3, 3, -1, 2};
+        std::vector<double> freqs(4);
+        std::vector<uint8_t> in_scale(4);
+        size_t before = allocation_count.load();
+        scalatrix_status f = scalatrix_mos_coords_to_freqs(mos, coords.data(), 4, 100.0, freqs.data());
+        scalatrix_status m = scalatrix_mos_nodes_in_scale(mos, nodes.data(), 4, in_scale.data());
+        size_t allocations = allocation_count.load() - before;
+        REQUIRE(f == SCALATRIX_OK);
+        REQUIRE(m == SCALATRIX_OK);
+        REQUIRE(allocations == 0);
+        for (size_t i = 0; i < 4; ++i) {
+            REQUIRE(freqs[i] == reference.coordToFreq(coords[2 * i], coords[2 * i + 1], 100.0));
+            REQUIRE((in_scale[i] == 1) == reference.nodeInScale({nodes[2 * i], nodes[2 * i + 1]}));
+        }
+    }
+
+    SECTION("Tempering to a pitch set index") {
+        scalatrix_pitchset_index* index = nullptr;
+        REQUIRE(scalatrix_pitchset_index_create_et(12, 1.0, -2.0, 3.0, &index) == SCALATRIX_OK);
+        PitchSetIndex ref_index(generateETPitchSet(12, 1.0, -2.0, 3.0));
+        size_t index_size = 0;
+        REQUIRE(scalatrix_pitchset_index_size(index, &index_size) == SCALATRIX_OK);
+        REQUIRE(index_size == ref_index.size());
+
+        REQUIRE(scalatrix_scale_temper(scale, index) == SCALATRIX_OK);
+        expected.temperToPitchSet(ref_index);
+        REQUIRE(scalatrix_scale_get_pitches(scale, pitches.data(), pitches.size()) == SCALATRIX_OK);
+        for (size_t i = 0; i < 24; ++i) {
+            REQUIRE(pitches[i] == expected.getNodes()[i].pitch);
+        }
+
+        std::vector<double> queries = {0.08, 0.5, 1.26, -0.99};
+        std::vector<uint32_t> nearest(4), ref_nearest(4);
+        size_t before = allocation_count.load();
+        scalatrix_status status = scalatrix_pitchset_index_nearest(index, queries.data(), 4, nearest.data());
+        size_t allocations = allocation_count.load() - before;
+        REQUIRE(status == SCALATRIX_OK);
+        REQUIRE(allocations == 0);
+        ref_index.nearest(queries.data(), 4, ref_nearest.data());
+        REQUIRE(nearest == ref_nearest);
+        scalatrix_pitchset_index_destroy(index);
+    }
+
+    scalatrix_scale_destroy(scale);
+    scalatrix_mos_destroy(mos);
+}
+
+TEST_CASE("C API reports errors as status codes", "[c_api]") {
+    scalatrix_mos* mos = nullptr;
+    scalatrix_mos_params bad = {0, 2, 0, 1.0, 0.5};
+    REQUIRE(scalatrix_mos_create(&bad, &mos) == SCALATRIX_ERROR_INVALID_ARGUMENT);
+    REQUIRE(mos == nullptr);
+    bad = {5, 2, 1, 1.0, 1.5};
+    REQUIRE(scalatrix_mos_create(&bad, &mos) == SCALATRIX_ERROR_INVALID_ARGUMENT);
+    REQUIRE(scalatrix_mos_create(nullptr, &mos) == SCALATRIX_ERROR_INVALID_ARGUMENT);
+
+    scalatrix_mos_params params = {5, 2, 1, 1.0, 0.585};
+    REQUIRE(scalatrix_mos_create(&params, &mos) == SCALATRIX_OK);
+    REQUIRE(scalatrix_mos_adjust(mos, &bad) == SCALATRIX_ERROR_INVALID_ARGUMENT);
+    // collinear fixed points and coinciding pitches cannot be retuned
+    int32_t collinear[4] = {0, 0, 1, 1};
+    REQUIRE(scalatrix_mos_retune_three_points(mos, collinear, 2, 2, 0.5) == SCALATRIX_ERROR_INVALID_ARGUMENT);
+    REQUIRE(scalatrix_mos_retune_two_points(mos, 1, 0, 1, 0, 0.5) == SCALATRIX_ERROR_INVALID_ARGUMENT);
+
+    scalatrix_scale* scale = nullptr;
+    // the root node must be one of the nodes, or the one just past them
+    REQUIRE(scalatrix_scale_create_from_mos(mos, 261.6, 10, 2000, &scale) == SCALATRIX_ERROR_INVALID_ARGUMENT);
+    REQUIRE(scalatrix_scale_create_from_mos(mos, 261.6, 10, -1, &scale) == SCALATRIX_ERROR_INVALID_ARGUMENT);
+    REQUIRE(scalatrix_scale_create_from_mos(mos, 261.6, -1, 0, &scale) == SCALATRIX_ERROR_INVALID_ARGUMENT);
+    REQUIRE(scale == nullptr);
+    REQUIRE(scalatrix_scale_create_from_mos(mos, 261.6, 12, 0, &scale) == SCALATRIX_OK);
+    std::vector<double> small(11);
+    REQUIRE(scalatrix_scale_get_pitches(scale, small.data(), small.size()) == SCALATRIX_ERROR_BUFFER_TOO_SMALL);
+    REQUIRE(scalatrix_scale_get_pitches(scale, nullptr, 0) == SCALATRIX_ERROR_BUFFER_TOO_SMALL);
+
+    scalatrix_pitchset_index* index = nullptr;
+    REQUIRE(scalatrix_pitchset_index_load("/nonexistent/pitches.bin", &index) == SCALATRIX_ERROR_IO);
+    REQUIRE(index == nullptr);
+    REQUIRE(scalatrix_pitchset_index_create(nullptr, 0, 1.0, &index) == SCALATRIX_OK);
+    double query = 0.5;
+    uint32_t out;
+    REQUIRE(scalatrix_pitchset_index_nearest(index, &query, 1, &out) == SCALATRIX_ERROR_INVALID_ARGUMENT);
+
+    REQUIRE(std::string(scalatrix_status_string(SCALATRIX_ERROR_BUFFER_TOO_SMALL)) == "buffer too small");
+
+    scalatrix_pitchset_index_destroy(index);
+    scalatrix_scale_destroy(scale);
+    scalatrix_mos_destroy(mos);
+    // destroying null handles is a no-op
+    scalatrix_mos_destroy(nullptr);
+    scalatrix_scale_destroy(nullptr);
+}
+
+TEST_CASE("C API batch scale generation", "[c_api]") {
+    std::vector<scalatrix_mos_params> params = {
+        {5, 2, 1, 1.0, 0.585}, {4, 3, 2, 1.0, 0.43}, {2, 5, 3, 1.58, 0.3}};
+    std::vector<double> pitches(3 * 16);
+    REQUIRE(scalatrix_generate_mos_pitches(params.data(), params.size(), 220.0, 16, 3, 2, pitches.data()) ==
+            SCALATRIX_OK);
+    for (size_t s = 0; s < params.size(); ++s) {
+        const scalatrix_mos_params& p = params[s];
+        MOS mos = MOS::fromParams(p.a, p.b, p.mode, p.equave, p.generator);
+        Scale scale = mos.generateScaleFromMOS(220.0, 16, 3);
+        for (size_t i = 0; i < 16; ++i) {
+            REQUIRE(pitches[s * 16 + i] == scale.getNodes()[i].pitch);
+        }
+    }
+    REQUIRE(scalatrix_generate_mos_pitches(params.data(), params.size(), 220.0, 16, 17, 2, pitches.data()) ==
+            SCALATRIX_ERROR_INVALID_ARGUMENT);
+    params[1].b = -1;
+    REQUIRE(scalatrix_generate_mos_pitches(params.data(), params.size(), 220.0, 16, 3, 2, pitches.data()) ==
+            SCALATRIX_ERROR_INVALID_ARGUMENT);
+
+    SECTION("Roots far above the first node") {
+        // more than 128 equaves below the root, where the base scale index used to go negative
+        std::vector<double> deep(1001);
+        REQUIRE(scalatrix_generate_mos_pitches(params.data(), 1, 220.0, 1001, 1000, 1, deep.data()) == SCALATRIX_OK);
+        REQUIRE(deep[1000] == 220.0);
+        REQUIRE(std::abs(deep[993] * 2.0 - 220.0) < 1e-9);
+        REQUIRE(deep[0] > 0.0);
+    }
+}
@@ -0,0 +1,93 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers_floating_point.hpp"
+#include "scalatrix/comma_search.hpp"
+#include <cmath>
+
+using namespace scalatrix;
+using Catch::Matchers::WithinAbs;
+
+static bool containsVector(const std::vector<CommaVector>& commas, Vector2i v) {
+    for (const auto& c : commas) {
+        if (c.v == v || (c.v.x == -v.x && c.v.y == -v.y)) return true;
+    }
+    return false;
+}
+
+TEST_CASE("Lattice basis reduction", "[commas]") {
+    SECTION("Reduced basis spans the same lattice") {
+        auto [r1, r2] = reduceBasis({7, 3}, {5, 2});
+        REQUIRE(std::abs(r1.x * r2.y - r1.y * r2.x) == 1);
+        REQUIRE(r1.x * r1.x + r1.y * r1.y <= r2.x * r2.x + r2.y * r2.y);
+    }
+
+    SECTION("Reduction under a skewed metric") {
+        LatticeMetric metric(1.0, 0.9, 1.0);
+        auto [r1, r2] = reduceBasis({1, 0}, {0, 1}, metric);
+        REQUIRE(std::abs(r1.x * r2.y - r1.y * r2.x) == 1);
+        REQUIRE(metric.norm2(r1) <= metric.norm2(r2));
+        REQUIRE(2 * std::abs(metric.dot(r1, r2)) <= metric.norm2(r1) + 1e-12);
+    }
+}
+
+TEST_CASE("Comma search in 12-EDO diatonic", "[commas]") {
+    MOS mos = MOS::fromParams(5, 2, 1, 1.0, 7.0 / 12);
+
+    SECTION("Diminished second is tempered out") {
+        auto commas = findCommas(mos, 0.01, 4.0, LatticeMetric(), false);
+        Vector2i dim2 = mos.s_vec * 2 - mos.L_vec;
+        REQUIRE(containsVector(commas, dim2));
+        for (const auto& c : commas) {
+            REQUIRE(c.equaves == 0);
+            REQUIRE(std::abs(c.cents) <= 0.01);
+        }
+    }
+
+    SECTION("Equave vector is found as an equave multiple") {
+        auto commas = findCommas(mos, 0.01, 6.0);
+        REQUIRE(containsVector(commas, {mos.a, mos.b}));
+    }
+
+    SECTION("Results are ordered by norm") {
+        auto commas = findCommas(mos, 0.01, 20.0);
+        REQUIRE(!commas.empty());
+        for (size_t i = 1; i < commas.size(); ++i) {
+            REQUIRE(commas[i - 1].norm <= commas[i].norm);
+        }
+    }
+}
+
+TEST_CASE("Comma search agrees with brute force", "[commas]") {
+    MOS mos = MOS::fromParams(5, 2, 1, 1.0, 0.585);
+    double tol = 30.0;
+    double max_norm = 15.0;
+    auto commas = findCommas(mos, tol, max_norm);
+
+    int count = 0;
+    for (int x = -16; x <= 16; ++x) {
+        for (int y = -16; y <= 16; ++y) {
+            if ((x == 0 && y == 0) || x * x + y * y > max_norm * max_norm) continue;
+            double p = mos.impliedAffine.a * x + mos.impliedAffine.b * y;
+            double k = std::round(p / mos.equave);
+            if (std::abs(1200.0 * (p - k * mos.equave)) <= tol) {
+                count++;
+                REQUIRE(containsVector(commas, {x, y}));
+            }
+        }
+    }
+    // every +-pair is reported once
+    REQUIRE(2 * commas.size() == (size_t)count);
+}
+
+TEST_CASE("Parallel comma search matches serial search", "[commas]") {
+    MOS mos = MOS::fromParams(7, 5, 2, 1.0, 0.5849625);
+    LatticeMetric metric = LatticeMetric::fromAffine(mos.impliedAffine);
+    auto serial = findCommas(mos, 5.0, 3.0, metric);
+    auto parallel = findCommasParallel(mos, 5.0, 3.0, metric, true, 4);
+
+    REQUIRE(serial.size() == parallel.size());
+    for (size_t i = 0; i < serial.size(); ++i) {
+        REQUIRE(serial[i].v == parallel[i].v);
+        REQUIRE(serial[i].equaves == parallel[i].equaves);
+        REQUIRE_THAT(serial[i].cents, WithinAbs(parallel[i].cents, 1e-12));
+    }
+}
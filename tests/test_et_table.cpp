@@ -0,0 +1,72 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers_floating_point.hpp"
+#include "scalatrix/et_table.hpp"
+#include "scalatrix/ji.hpp"
+#include <cmath>
+
+using namespace scalatrix;
+using Catch::Matchers::WithinAbs;
+
+static size_t findLabel(const PitchSet& pitchset, const std::string& label) {
+    for (size_t i = 0; i < pitchset.size(); ++i) {
+        if (pitchset[i].label == label) return i;
+    }
+    FAIL("missing label " << label);
+    return 0;
+}
+
+TEST_CASE("ET comparison table", "[et_table]") {
+    PrimeList primes = generateDefaultPrimeList(3);
+    PitchSet targets = generateJIPitchSet(primes, 16);
+    ETComparisonTable table = compareETs(targets, 5, 72, 1.0, primes);
+    REQUIRE(table.rows() == 68);
+    REQUIRE(table.best_steps.size() == 68 * targets.size());
+    REQUIRE(table.patent_vals.size() == 68 * 3);
+
+    SECTION("Best steps agree with searching the generated ET pitch set") {
+        for (unsigned int n = 5; n <= 72; ++n) {
+            PitchSet et = generateETPitchSet(n, 1.0, -1.0, 2.0);
+            for (size_t t = 0; t < targets.size(); ++t) {
+                const PitchSetPitch* best = &et[0];
+                for (auto& p : et) {
+                    if (std::abs(p.log2fr - targets[t].log2fr) < std::abs(best->log2fr - targets[t].log2fr)) best = &p;
+                }
+                REQUIRE(table.bestStep(n, t) == best->num);
+                REQUIRE_THAT(table.error(n, t), WithinAbs(best->log2fr - targets[t].log2fr, 1e-12));
+                REQUIRE(std::abs(table.error(n, t)) <= table.max_errors[n - 5] + 1e-15);
+            }
+        }
+    }
+
+    SECTION("Patent vals and consistency") {
+        size_t row = 12 - 5;
+        REQUIRE(table.patent_vals[row * 3 + 0] == 12);
+        REQUIRE(table.patent_vals[row * 3 + 1] == 19);
+        REQUIRE(table.patent_vals[row * 3 + 2] == 28);
+        for (size_t t = 0; t < targets.size(); ++t) {
+            REQUIRE(table.consistent(12, t));
+        }
+        // 17-EDO is not 5-limit consistent: its patent val maps 6:5 to 5 steps, the nearest is 4
+        size_t minor_third = findLabel(targets, "6:5");
+        REQUIRE(table.mappedStep(17, minor_third) == 5);
+        REQUIRE(table.bestStep(17, minor_third) == 4);
+        REQUIRE_FALSE(table.consistent(17, minor_third));
+    }
+
+    SECTION("Non-ratio targets and tritave ETs") {
+        PitchSet free_text = {{"a", 0.3}, {"b", 1.2}};
+        ETComparisonTable bp = compareETs(free_text, 13, 13, std::log2(3.0), primes);
+        REQUIRE(bp.bestStep(13, 0) == (int)std::lround(0.3 / std::log2(3.0) * 13));
+        REQUIRE(bp.mappedStep(13, 1) == bp.bestStep(13, 1));
+        REQUIRE(bp.patent_vals[1] == 13);
+    }
+
+    SECTION("Independent of the thread count") {
+        ETComparisonTable serial = compareETs(targets, 5, 311, 1.0, primes, 1);
+        ETComparisonTable parallel = compareETs(targets, 5, 311, 1.0, primes, 8);
+        REQUIRE(serial.best_steps == parallel.best_steps);
+        REQUIRE(serial.errors == parallel.errors);
+        REQUIRE(serial.mapped_steps == parallel.mapped_steps);
+        REQUIRE(serial.rms_errors == parallel.rms_errors);
+    }
+}
@@ -0,0 +1,301 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers_floating_point.hpp"
+#include "scalatrix/ji.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <set>
+
+using namespace scalatrix;
+using Catch::Matchers::WithinAbs;
+
+// Brute force over all num x den pairs, as generateJIPitchSet used to do
+static std::vector<JIRatio> referenceRatios(const PrimeList& primes, int max_numorden,
+                                            double min_log2fr, double max_log2fr) {
+    std::vector<std::pair<unsigned int, double>> nums;
+    for (int i = 1; i < max_numorden; i++) {
+        unsigned int r = i;
+        double log2fr = 0.0;
+        for (const auto& p : primes) {
+            while (r % p.number == 0) {
+                r /= p.number;
+                log2fr += p.log2fr;
+            }
+        }
+        if (r == 1) nums.push_back({(unsigned int)i, log2fr});
+    }
+    std::vector<JIRatio> ratios;
+    for (auto& num : nums) {
+        for (auto& den : nums) {
+            if (std::gcd(num.first, den.first) > 1) continue;
+            double log2fr = num.second - den.second;
+            if (log2fr > min_log2fr - 1e-6 && log2fr < max_log2fr + 1e-6) {
+                ratios.push_back({num.first, den.first, log2fr});
+            }
+        }
+    }
+    std::sort(ratios.begin(), ratios.end(), [](const JIRatio& a, const JIRatio& b) {
+        if (a.log2fr != b.log2fr) return a.log2fr < b.log2fr;
+        if (a.den != b.den) return a.den < b.den;
+        return a.num < b.num;
+    });
+    return ratios;
+}
+
+// Same ratios with the same values; a must be sorted. Ties between tempered values that are
+// only equal up to rounding may come out in either order, so compare by (num, den).
+static void requireSameRatios(std::vector<JIRatio> a, std::vector<JIRatio> b) {
+    REQUIRE(a.size() == b.size());
+    for (size_t i = 1; i < a.size(); ++i) {
+        REQUIRE(a[i].log2fr >= a[i - 1].log2fr);
+    }
+    auto byRatio = [](const JIRatio& x, const JIRatio& y) {
+        return x.num < y.num || (x.num == y.num && x.den < y.den);
+    };
+    std::sort(a.begin(), a.end(), byRatio);
+    std::sort(b.begin(), b.end(), byRatio);
+    for (size_t i = 0; i < a.size(); ++i) {
+        REQUIRE(a[i].num == b[i].num);
+        REQUIRE(a[i].den == b[i].den);
+        REQUIRE_THAT(a[i].log2fr, WithinAbs(b[i].log2fr, 1e-12));
+    }
+}
+
+TEST_CASE("JI ratio stream matches brute force", "[ji]") {
+    SECTION("5-limit and 7-limit within an octave") {
+        for (int n_primes : {3, 4}) {
+            PrimeList primes = generateDefaultPrimeList(n_primes);
+            requireSameRatios(generateJIRatios(primes, 100, 0.0, 1.0), referenceRatios(primes, 100, 0.0, 1.0));
+        }
+    }
+
+    SECTION("Wide and negative ranges") {
+        PrimeList primes = generateDefaultPrimeList(5);
+        requireSameRatios(generateJIRatios(primes, 60, -2.0, 3.0), referenceRatios(primes, 60, -2.0, 3.0));
+    }
+
+    SECTION("Tempered primes") {
+        // a tempered 3 that is larger than 4 changes the order of the smooth numbers
+        PrimeList primes = generateDefaultPrimeList(3);
+        primes[1].log2fr = 2.1;
+        primes[2].log2fr = 2.3;
+        requireSameRatios(generateJIRatios(primes, 80, -1.0, 1.0), referenceRatios(primes, 80, -1.0, 1.0));
+    }
+
+    SECTION("Subgroup and pseudo-prime lists") {
+        PrimeList subgroup = {pseudoPrimeFromIndexNumber(0), pseudoPrimeFromIndexNumber(2), pseudoPrimeFromIndexNumber(3)};
+        requireSameRatios(generateJIRatios(subgroup, 200, 0.0, 1.0), referenceRatios(subgroup, 200, 0.0, 1.0));
+
+        PrimeList pseudo = {pseudoPrimeFromIndexNumber(0), {"9", 9, 3.17}};
+        requireSameRatios(generateJIRatios(pseudo, 200, -1.0, 2.0), referenceRatios(pseudo, 200, -1.0, 2.0));
+    }
+}
+
+TEST_CASE("JI pitch set labels and order", "[ji]") {
+    PrimeList primes = generateDefaultPrimeList(3);
+    PitchSet pitchset = generateJIPitchSet(primes, 20);
+
+    REQUIRE(pitchset.front().label == "1:1");
+    REQUIRE(pitchset.back().label == "2:1");
+    std::set<std::string> labels;
+    for (size_t i = 0; i < pitchset.size(); ++i) {
+        if (i > 0) REQUIRE(pitchset[i].log2fr >= pitchset[i - 1].log2fr);
+        REQUIRE(labels.insert(pitchset[i].label).second);
+    }
+    REQUIRE(labels.count("3:2") == 1);
+    REQUIRE(labels.count("16:15") == 1);
+    REQUIRE(labels.count("6:4") == 0);
+}
+
+TEST_CASE("JI ratio stream on large sets", "[ji]") {
+    // 13-limit with numerators and denominators below 50000
+    PrimeList primes = generateDefaultPrimeList(6);
+    JIRatioStream stream(primes, 50000, -4.0, 4.0);
+    JIRatio r, prev{0, 0, -1e9};
+    size_t count = 0;
+    while (stream.next(r)) {
+        REQUIRE(std::gcd(r.num, r.den) == 1);
+        REQUIRE(r.log2fr >= prev.log2fr);
+        prev = r;
+        count++;
+    }
+    REQUIRE(count > 90000);
+}
+
+// All list-smooth coprime ratios with num, den <= limit in range, ranked by complexity
+static std::vector<JIRatio> referenceSimplest(const PrimeList& primes, unsigned int limit, size_t k,
+                                              HarmonicComplexity complexity,
+                                              double min_log2fr, double max_log2fr) {
+    auto all = referenceRatios(primes, limit + 1, min_log2fr, max_log2fr);
+    auto oddPart = [](unsigned long long n) { while (n % 2 == 0) n /= 2; return n; };
+    auto key = [&](const JIRatio& r) -> unsigned long long {
+        if (complexity == TenneyHeight) return (unsigned long long)r.num * r.den;
+        if (complexity == WeilHeight) return std::max(r.num, r.den);
+        return std::max(oddPart(r.num), oddPart(r.den));
+    };
+    std::sort(all.begin(), all.end(), [&](const JIRatio& a, const JIRatio& b) {
+        if (key(a) != key(b)) return key(a) < key(b);
+        unsigned long long ta = (unsigned long long)a.num * a.den, tb = (unsigned long long)b.num * b.den;
+        if (ta != tb) return ta < tb;
+        return a.num < b.num;
+    });
+    all.resize(std::min(all.size(), k));
+    return all;
+}
+
+static void requireSameSequence(const std::vector<JIRatio>& a, const std::vector<JIRatio>& b) {
+    REQUIRE(a.size() == b.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        REQUIRE(a[i].num == b[i].num);
+        REQUIRE(a[i].den == b[i].den);
+        REQUIRE_THAT(a[i].log2fr, WithinAbs(b[i].log2fr, 1e-12));
+    }
+}
+
+TEST_CASE("Simplest ratios by complexity", "[ji]") {
+    PrimeList primes = generateDefaultPrimeList(4);
+
+    SECTION("Tenney height") {
+        auto ratios = generateSimplestRatios(primes, 60, TenneyHeight, 0.0, 1.0);
+        REQUIRE(ratios.size() == 60);
+        REQUIRE((unsigned long long)ratios.back().num * ratios.back().den <= 2000);
+        requireSameSequence(ratios, referenceSimplest(primes, 2000, 60, TenneyHeight, 0.0, 1.0));
+        REQUIRE(ratios[0].num == 1);
+        REQUIRE(ratios[1].num == 2);
+        REQUIRE(ratios[2].num == 3);
+        REQUIRE(ratios[2].den == 2);
+    }
+
+    SECTION("Weil height over two octaves") {
+        auto ratios = generateSimplestRatios(primes, 80, WeilHeight, -1.0, 1.0);
+        REQUIRE(std::max(ratios.back().num, ratios.back().den) <= 2000);
+        requireSameSequence(ratios, referenceSimplest(primes, 2000, 80, WeilHeight, -1.0, 1.0));
+    }
+
+    SECTION("Odd limit") {
+        auto ratios = generateSimplestRatios(primes, 40, OddLimit, 0.0, 1.0);
+        requireSameSequence(ratios, referenceSimplest(primes, 2000, 40, OddLimit, 0.0, 1.0));
+        // the 7-odd-limit diamond within an octave has 14 ratios, 1:1 and 2:1 included
+        size_t n_7_limit = 0;
+        for (auto& r : ratios) {
+            unsigned int n = r.num, d = r.den;
+            while (n % 2 == 0) n /= 2;
+            while (d % 2 == 0) d /= 2;
+            if (std::max(n, d) <= 7) n_7_limit++;
+        }
+        REQUIRE(n_7_limit == 14);
+    }
+
+    SECTION("Tempered primes") {
+        // 12-EDO tempering of the 7-limit, pruning must account for the detuned primes
+        PrimeList tempered = primes;
+        tempered[1].log2fr = 1.0 + 7.0 / 12.0;
+        tempered[2].log2fr = 2.0 + 4.0 / 12.0;
+        tempered[3].log2fr = 2.0 + 10.0 / 12.0;
+        for (HarmonicComplexity c : {TenneyHeight, WeilHeight}) {
+            auto ratios = generateSimplestRatios(tempered, 50, c, -0.5, 0.5);
+            requireSameSequence(ratios, referenceSimplest(tempered, 2000, 50, c, -0.5, 0.5));
+        }
+    }
+
+    SECTION("Subgroups") {
+        PrimeList subgroup = {pseudoPrimeFromIndexNumber(0), pseudoPrimeFromIndexNumber(2), pseudoPrimeFromIndexNumber(3)};
+        auto ratios = generateSimplestRatios(subgroup, 30, TenneyHeight, 0.0, 1.0);
+        requireSameSequence(ratios, referenceSimplest(subgroup, 2000, 30, TenneyHeight, 0.0, 1.0));
+        for (auto& r : ratios) {
+            REQUIRE(r.num % 3 != 0);
+            REQUIRE(r.den % 3 != 0);
+        }
+    }
+
+    SECTION("Large k stays cheap") {
+        PrimeList eleven = generateDefaultPrimeList(5);
+        auto ratios = generateSimplestRatios(eleven, 20000, TenneyHeight, -2.0, 2.0);
+        REQUIRE(ratios.size() == 20000);
+        for (size_t i = 1; i < ratios.size(); ++i) {
+            REQUIRE((unsigned long long)ratios[i].num * ratios[i].den >=
+                    (unsigned long long)ratios[i - 1].num * ratios[i - 1].den);
+        }
+        PitchSet pitchset = generateSimplestPitchSet(eleven, 5, TenneyHeight, 0.0, 1.0);
+        REQUIRE(pitchset[0].label == "1:1");
+        REQUIRE(pitchset[2].label == "3:2");
+    }
+}
+
+static std::vector<std::string> labelsOf(const PitchSet& pitchset) {
+    std::vector<std::string> labels;
+    for (size_t i = 0; i < pitchset.size(); ++i) {
+        if (i > 0) REQUIRE(pitchset[i].log2fr >= pitchset[i - 1].log2fr);
+        labels.push_back(pitchset[i].label);
+    }
+    return labels;
+}
+
+TEST_CASE("Tonality diamonds and harmonic chords", "[ji]") {
+    PrimeList primes = generateDefaultPrimeList(4);
+
+    SECTION("5-odd-limit diamond") {
+        auto labels = labelsOf(generateDiamondPitchSet({1, 3, 5}, primes));
+        REQUIRE(labels == std::vector<std::string>{"1:1", "6:5", "5:4", "4:3", "3:2", "8:5", "5:3", "2:1"});
+        REQUIRE(generateDiamondPitchSet({1, 3, 5}, primes, false).size() == 7);
+    }
+
+    SECTION("Odd-limit diamonds") {
+        PitchSet seven = generateOddLimitDiamondPitchSet(primes, 7);
+        REQUIRE(seven.size() == 14);
+        REQUIRE(seven.back().label == "2:1");
+        // 9 adds 9:8, 16:9, 9:5, 10:9, 9:7, 14:9 to the 7-odd-limit
+        PitchSet nine = generateOddLimitDiamondPitchSet(primes, 9, false);
+        REQUIRE(nine.size() == 19);
+        for (auto& p : nine) {
+            REQUIRE(p.log2fr >= 0.0);
+            REQUIRE(p.log2fr < 1.0);
+        }
+    }
+
+    SECTION("Identities with factors of two are deduplicated") {
+        auto ratios = generateDiamondRatios({1, 2, 3, 4, 6}, primes, false);
+        REQUIRE(ratios.size() == 3);
+        REQUIRE(ratios[0].num == 1);
+        REQUIRE(ratios[1].num == 4);
+        REQUIRE(ratios[1].den == 3);
+        REQUIRE(ratios[2].num == 3);
+        REQUIRE(ratios[2].den == 2);
+    }
+
+    SECTION("Subgroup diamond") {
+        PrimeList subgroup = {pseudoPrimeFromIndexNumber(0), pseudoPrimeFromIndexNumber(1), pseudoPrimeFromIndexNumber(3)};
+        auto labels = labelsOf(generateOddLimitDiamondPitchSet(subgroup, 9, false));
+        REQUIRE(labels.size() == 11);
+        for (auto& l : labels) REQUIRE(l.find('5') == std::string::npos);
+    }
+
+    SECTION("Otonal and utonal chords") {
+        auto otonal = labelsOf(generateOtonalPitchSet({4, 5, 6, 7}, primes));
+        REQUIRE(otonal == std::vector<std::string>{"1:1", "5:4", "3:2", "7:4", "2:1"});
+        auto utonal = labelsOf(generateUtonalPitchSet({1, 3, 5}, primes, false));
+        REQUIRE(utonal == std::vector<std::string>{"1:1", "4:3", "8:5"});
+    }
+
+    SECTION("Tempered octave") {
+        PrimeList tempered = primes;
+        tempered[0].log2fr = 1.01;
+        tempered[1].log2fr = 1.6;
+        auto ratios = generateDiamondRatios({1, 3}, tempered);
+        REQUIRE(ratios.size() == 4);
+        REQUIRE_THAT(ratios[1].log2fr, WithinAbs(2 * 1.01 - 1.6, 1e-12)); // 4:3
+        REQUIRE_THAT(ratios[2].log2fr, WithinAbs(1.6 - 1.01, 1e-12));     // 3:2
+        REQUIRE_THAT(ratios.back().log2fr, WithinAbs(1.01, 1e-12));
+
+        // a tempered octave below a tempered 3:2 sorts in between like any other ratio
+        tempered[0].log2fr = 0.9;
+        tempered[1].log2fr = 1.95;
+        ratios = generateDiamondRatios({1, 3}, tempered);
+        REQUIRE(ratios.size() == 4);
+        REQUIRE(ratios[2].num == 2);
+        REQUIRE(ratios[2].den == 1);
+        REQUIRE(ratios[3].num == 3);
+        REQUIRE(ratios[3].den == 2);
+        for (size_t i = 1; i < ratios.size(); ++i) REQUIRE(ratios[i - 1].log2fr <= ratios[i].log2fr);
+    }
+}
@@ -1,6 +1,8 @@
 #include "catch2/catch_test_macros.hpp"
 #include "scalatrix/label_calculator.hpp"
 #include "scalatrix/mos.hpp"
+#include <cstdio>
+#include <thread>
 
 using namespace scalatrix;
 
@@ -236,4 +238,198 @@ TEST_CASE("LabelCalculator deviationLabel", "[labelcalculator]") {
         std::string result = LabelCalculator::deviationLabel(node, 0.1, false);
         REQUIRE(result == "3:2");
     }
-}
\ No newline at end of file
+
+    SECTION("Deviation rounds like printf") {
+        // %.1f rounds the exact binary value: 12.35 is stored just below the tie, 0.25 is a tie that rounds to even
+        double deviations[] = {12.35, 0.25, -0.25, -12.35, 2.5, 0.05, 0.15, 1234.56, 99.95};
+        for (double cents : deviations) {
+            Node node;
+            node.tuning_coord.x = cents / 1200.0;
+            node.closestPitch = {"1:1", 0.0};
+            double computed = 1200.0 * node.tuning_coord.x;
+            char expected[64];
+            std::snprintf(expected, sizeof(expected), computed > 0 ? "1:1+%.1fct" : "1:1%.1fct", computed);
+            REQUIRE(LabelCalculator::deviationLabel(node, 0.01, false) == expected);
+        }
+
+        Node node;
+        node.closestPitch = {"1:1", 0.0};
+        node.tuning_coord.x = 12.35 / 1200.0;
+        REQUIRE(LabelCalculator::deviationLabel(node, 0.01, false) == "1:1+12.3ct");
+        node.tuning_coord.x = 0.25 / 1200.0;
+        REQUIRE(LabelCalculator::deviationLabel(node, 0.01, false) == "1:1+0.2ct");
+    }
+}
+
+// The per-call string concatenation the single-node functions used to do
+static std::string referenceLabel(const MOS& mos, Vector2i v, LabelStyle style, int middle_C_octave) {
+    int acc_sign = mos.L_vec.x == 1 ? 1 : -1;
+    int neutral_mode = mos.L_vec.x == 1 ? 1 : mos.n0 - 2;
+    int n_generators = v.x * mos.b0 - v.y * mos.a0;
+    int acc = acc_sign * (int)std::floor((n_generators + neutral_mode + 0.5) / mos.n0);
+    std::string result;
+    for (; acc < 0; ++acc) result += "\xe2\x99\xad";
+    for (; acc > 0; --acc) result += "\xe2\x99\xaf";
+    if (style == DigitLabel) return result + std::to_string((v.x + v.y + 128 * mos.n) % mos.n + 1);
+    result += (char)('A' + (v.x + v.y + 2 + 128 * mos.n) % mos.n);
+    if (style == LetterWithOctaveNumberLabel) {
+        result += std::to_string(middle_C_octave + (int)std::floor((.0 + v.x + v.y) / mos.n));
+    }
+    return result;
+}
+
+TEST_CASE("LabelCalculator batch labels", "[labelcalculator]") {
+    std::vector<Vector2i> coords;
+    for (int x = -40; x <= 40; ++x) {
+        for (int y = -25; y <= 25; ++y) coords.push_back({x, y});
+    }
+
+    SECTION("Batch node labels match the single-node functions") {
+        for (MOS mos : {MOS::fromParams(5, 2, 1, 1.0, 0.585), MOS::fromParams(2, 5, 3, 1.0, 0.42),
+                        MOS::fromParams(4, 3, 0, 1.0, 0.2)}) {
+            LabelBuffer buffer;
+            for (LabelStyle style : {DigitLabel, LetterLabel, LetterWithOctaveNumberLabel}) {
+                buffer.clear();
+                LabelCalculator::nodeLabels(mos, coords.data(), coords.size(), style, buffer, 3);
+                REQUIRE(buffer.size() == coords.size());
+                for (size_t i = 0; i < coords.size(); ++i) {
+                    REQUIRE(buffer[i] == referenceLabel(mos, coords[i], style, 3));
+                }
+            }
+            for (size_t i = 0; i < coords.size(); i += 37) {
+                REQUIRE(LabelCalculator::nodeLabelDigit(mos, coords[i]) == referenceLabel(mos, coords[i], DigitLabel, 4));
+                REQUIRE(LabelCalculator::nodeLabelLetterWithOctaveNumber(mos, coords[i], 4) ==
+                        referenceLabel(mos, coords[i], LetterWithOctaveNumberLabel, 4));
+            }
+        }
+    }
+
+    SECTION("Scale labels append after earlier batches") {
+        MOS mos = MOS::fromParams(5, 2, 1, 1.0, 0.585);
+        LabelBuffer buffer;
+        LabelCalculator::nodeLabels(mos, coords.data(), 3, DigitLabel, buffer);
+        LabelCalculator::nodeLabels(mos, mos.base_scale, LetterLabel, buffer);
+        const auto& nodes = mos.base_scale.getNodes();
+        REQUIRE(buffer.size() == 3 + nodes.size());
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            REQUIRE(buffer[3 + i] == LabelCalculator::nodeLabelLetter(mos, nodes[i].natural_coord));
+        }
+    }
+
+    SECTION("Batch deviation labels") {
+        std::vector<Node> nodes(6);
+        double deviations[] = {0.0, -101.955, 138.045, 18.04, -0.06, 1234.56};
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            nodes[i].closestPitch = PitchSetPitch::fromRatio(3, 2, 0.5849625007);
+            nodes[i].tuning_coord.x = 0.5849625007 + deviations[i] / 1200.0;
+        }
+        nodes[1].closestPitch.label = "";
+        LabelBuffer buffer;
+        LabelCalculator::deviationLabels(nodes, buffer, 0.1, false);
+        REQUIRE(buffer.size() == 6);
+        REQUIRE(buffer[0] == "3:2");
+        REQUIRE(buffer[1] == "");
+        REQUIRE(buffer[2] == "3:2+138.0ct");
+        REQUIRE(buffer[3] == "3:2+18.0ct");
+        REQUIRE(buffer[4] == "3:2");
+        REQUIRE(buffer[5] == "3:2+1234.6ct");
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            REQUIRE(buffer[i] == LabelCalculator::deviationLabel(nodes[i], 0.1, false));
+        }
+    }
+}
+
+TEST_CASE("LabelTable cache", "[labelcalculator]") {
+    MOS mos = MOS::fromParams(5, 2, 1, 1.0, 0.585);
+
+    SECTION("Table reads match direct formatting beyond the table range") {
+        LabelTable table(mos, 2);
+        for (int x = -60; x <= 60; x += 3) {
+            for (int y = -30; y <= 30; ++y) {
+                Vector2i v(x, y);
+                REQUIRE(table.label(v, DigitLabel) == referenceLabel(mos, v, DigitLabel, 4));
+                REQUIRE(table.label(v, LetterWithOctaveNumberLabel, 2) ==
+                        referenceLabel(mos, v, LetterWithOctaveNumberLabel, 2));
+            }
+        }
+    }
+
+    SECTION("Shared tables survive retuning but not structure changes") {
+        auto table = LabelTable::shared(mos);
+        REQUIRE(LabelTable::shared(mos) == table);
+        mos.retuneOnePoint({1, 0}, 0.18);
+        REQUIRE(LabelTable::keyOf(mos) == table->key());
+        REQUIRE(LabelTable::shared(mos) == table);
+        MOS other = MOS::fromParams(5, 2, 3, 1.0, 0.585);
+        REQUIRE(LabelTable::shared(other) != table);
+        REQUIRE(LabelTable::shared(other)->label({1, 1}, LetterLabel) == referenceLabel(other, {1, 1}, LetterLabel, 4));
+    }
+
+    SECTION("Concurrent lookups") {
+        std::vector<std::string> results(4);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < results.size(); ++t) {
+            threads.emplace_back([&mos, &results, t]() {
+                LabelBuffer buffer;
+                std::vector<Vector2i> coords;
+                for (int i = -50; i < 50; ++i) coords.push_back({i, (int)t - i / 3});
+                for (int round = 0; round < 20; ++round) {
+                    buffer.clear();
+                    LabelCalculator::nodeLabels(mos, coords.data(), coords.size(), LetterLabel, buffer);
+                }
+                results[t] = std::string(buffer.chars.begin(), buffer.chars.end());
+                std::string expected;
+                for (auto& v : coords) expected += referenceLabel(mos, v, LetterLabel, 4);
+                if (results[t] != expected) results[t] = "mismatch";
+            });
+        }
+        for (auto& t : threads) t.join();
+        for (auto& r : results) REQUIRE(r != "mismatch");
+    }
+}
+
+TEST_CASE("Normalized labels share one diatonic reference", "[label_calculator]") {
+    MOS diatonic = MOS::fromParams(5, 2, 1, 1.0, 0.585);
+    MOS pentatonic = MOS::fromParams(3, 2, 1, 1.0, 0.585);
+    MOS other = MOS::fromParams(4, 3, 2, 1.0, 0.43);
+
+    SECTION("The reference is constructed once") {
+        REQUIRE(&LabelCalculator::diatonicReference() == &LabelCalculator::diatonicReference());
+        REQUIRE(LabelCalculator::diatonicReference().n == 7);
+    }
+
+    SECTION("Batch labels match single calls") {
+        std::vector<Vector2i> coords;
+        for (int x = -6; x <= 6; ++x)
+            for (int y = -4; y <= 4; ++y) coords.push_back({x, y});
+        for (const MOS* mos : {&diatonic, &pentatonic, &other}) {
+            for (bool override_letters : {false, true}) {
+                LabelBuffer buffer;
+                LabelCalculator::noteLabelsNormalized(*mos, coords.data(), coords.size(), buffer, override_letters);
+                REQUIRE(buffer.size() == coords.size());
+                for (size_t i = 0; i < coords.size(); ++i) {
+                    REQUIRE(std::string(buffer[i]) ==
+                            LabelCalculator::noteLabelNormalized(*mos, coords[i], override_letters));
+                }
+            }
+        }
+    }
+
+    SECTION("Concurrent first use") {
+        std::vector<std::string> results(4);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < results.size(); ++t) {
+            threads.emplace_back([&diatonic, &results, t]() {
+                std::string labels;
+                for (int i = -20; i < 20; ++i) labels += LabelCalculator::noteLabelNormalized(diatonic, {i, (int)t});
+                results[t] = labels;
+            });
+        }
+        for (auto& t : threads) t.join();
+        for (size_t t = 0; t < results.size(); ++t) {
+            std::string expected;
+            for (int i = -20; i < 20; ++i) expected += LabelCalculator::noteLabelNormalized(diatonic, {i, (int)t});
+            REQUIRE(results[t] == expected);
+        }
+    }
+}
@@ -2,6 +2,10 @@
 #include "catch2/matchers/catch_matchers_floating_point.hpp"
 #include "scalatrix/mos.hpp"
 #include <cmath>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
 
 using namespace scalatrix;
 using Catch::Matchers::WithinAbs;
@@ -140,6 +144,21 @@ TEST_CASE("MOS retuning operations", "[mos]") {
         auto origin = mos.impliedAffine.apply({0, 0});
         REQUIRE(std::abs(origin.x) < 1.0); // Should be within reasonable bounds
     }
+
+    SECTION("Retuned scales match freshly generated ones") {
+        // odd sizes and roots exercise both the paired and the single-node steps
+        mos.retuneOnePoint({1, 0}, 0.2);
+        for (int root : {0, 5, 37}) {
+            Scale retuned = mos.generateScaleFromMOS(261.63, 37, root);
+            mos.retuneTwoPoints({0, 0}, {mos.a, mos.b}, 1.01);
+            mos.retuneScaleWithMOS(retuned, 261.63);
+            Scale fresh = mos.generateScaleFromMOS(261.63, 37, root);
+            for (size_t i = 0; i < fresh.getNodes().size(); ++i) {
+                REQUIRE(retuned.getNodes()[i].tuning_coord.x == fresh.getNodes()[i].tuning_coord.x);
+                REQUIRE(retuned.getNodes()[i].pitch == fresh.getNodes()[i].pitch);
+            }
+        }
+    }
 }
 
 TEST_CASE("MOS node coordinate mapping", "[mos]") {
@@ -225,4 +244,90 @@ TEST_CASE("MOS step sizes", "[mos]") {
     SECTION("Chroma is the difference") {
         REQUIRE_THAT(mos.chroma_fr, WithinAbs(std::abs(mos.L_fr - mos.s_fr), 1e-10));
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("MOS batch coordinate queries", "[mos]") {
+    MOS mos = MOS::fromParams(5, 2, 1, 1.0, 0.585);
+    std::vector<Vector2i> coords;
+    std::vector<Vector2d> tuning;
+    for (int x = -8; x <= 8; ++x) {
+        for (int y = -3; y <= 3; ++y) {
+            coords.push_back({x, y});
+            tuning.push_back(Vector2d(x + 0.25, y));
+        }
+    }
+
+    SECTION("Affine transforms") {
+        std::vector<Vector2d> from_int(coords.size()), from_double(tuning.size());
+        mos.impliedAffine.apply(coords.data(), coords.size(), from_int.data());
+        mos.impliedAffine.apply(tuning.data(), tuning.size(), from_double.data());
+        for (size_t i = 0; i < coords.size(); ++i) {
+            Vector2d expected = mos.impliedAffine * coords[i];
+            REQUIRE(from_int[i].x == expected.x);
+            REQUIRE(from_int[i].y == expected.y);
+            expected = mos.impliedAffine.apply(tuning[i]);
+            REQUIRE(from_double[i].x == expected.x);
+            REQUIRE(from_double[i].y == expected.y);
+        }
+
+        // in place
+        std::vector<Vector2d> in_place = tuning;
+        mos.impliedAffine.apply(in_place.data(), in_place.size(), in_place.data());
+        REQUIRE(in_place[3].x == from_double[3].x);
+    }
+
+    SECTION("Frequencies and scale membership") {
+        std::vector<double> freqs(tuning.size());
+        mos.coordsToFreqs(tuning.data(), tuning.size(), 261.6, freqs.data());
+        std::unique_ptr<bool[]> in_scale(new bool[coords.size()]);
+        mos.nodesInScale(coords.data(), coords.size(), in_scale.get());
+        size_t members = 0;
+        for (size_t i = 0; i < coords.size(); ++i) {
+            REQUIRE(freqs[i] == mos.coordToFreq(tuning[i].x, tuning[i].y, 261.6));
+            REQUIRE(in_scale[i] == mos.nodeInScale(coords[i]));
+            members += in_scale[i];
+        }
+        REQUIRE(members > 0);
+        REQUIRE(members < coords.size());
+    }
+}
+
+TEST_CASE("MOS construction is reentrant", "[mos]") {
+    struct Params { int a, b, m; double e, g; };
+    std::vector<Params> params = {
+        {5, 2, 1, 1.0, 0.585}, {2, 5, 3, 1.0, 0.42}, {4, 3, 2, 1.0, 0.43}, {7, 5, 3, 1.0, 0.583},
+        {3, 8, 4, 1.0, 0.27}, {10, 2, 1, 1.0, 0.59}, {5, 3, 2, 1.585, 0.38}, {1, 1, 0, 1.0, 0.5}};
+    std::vector<MOS> expected;
+    for (const Params& p : params) expected.push_back(MOS::fromParams(p.a, p.b, p.m, p.e, p.g));
+
+    // every thread builds every MOS many times, starting at a different one, so threads
+    // construct different structures at the same moment
+    const int n_threads = 8, rounds = 300;
+    std::atomic<int> mismatches{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            while (!go.load()) std::this_thread::yield();
+            for (int r = 0; r < rounds; ++r) {
+                size_t k = (size_t)(t + r) % params.size();
+                const Params& p = params[k];
+                MOS mos = MOS::fromParams(p.a, p.b, p.m, p.e, p.g);
+                // adjustParams reuses an existing object
+                mos.adjustParams(p.a, p.b, p.m, p.e, p.g);
+                const MOS& ref = expected[k];
+                bool same = mos.mosTransform.a == ref.mosTransform.a && mos.mosTransform.b == ref.mosTransform.b &&
+                            mos.mosTransform.c == ref.mosTransform.c && mos.mosTransform.d == ref.mosTransform.d &&
+                            mos.v_gen == ref.v_gen && mos.L_vec == ref.L_vec && mos.s_vec == ref.s_vec &&
+                            mos.base_scale.getNodes().size() == ref.base_scale.getNodes().size();
+                for (size_t i = 0; same && i < ref.base_scale.getNodes().size(); ++i) {
+                    same = mos.base_scale.getNodes()[i].natural_coord == ref.base_scale.getNodes()[i].natural_coord;
+                }
+                if (!same) mismatches.fetch_add(1);
+            }
+        });
+    }
+    go = true;
+    for (auto& th : threads) th.join();
+    REQUIRE(mismatches.load() == 0);
+}
@@ -0,0 +1,145 @@
+#include "catch2/catch_test_macros.hpp"
+#include "scalatrix/parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace scalatrix;
+
+TEST_CASE("parallelFor runs every index exactly once", "[parallel]") {
+    for (unsigned n_threads : {1u, 2u, 3u, 8u, 0u}) {
+        for (size_t count : {0u, 1u, 5u, 1000u, 100003u}) {
+            std::vector<std::atomic<int>> hits(count);
+            parallelFor(0, count, [&](size_t i) { hits[i].fetch_add(1); }, n_threads);
+            for (size_t i = 0; i < count; ++i) {
+                REQUIRE(hits[i].load() == 1);
+            }
+        }
+    }
+
+    SECTION("Offset ranges") {
+        std::vector<int> out(50, 0);
+        parallelFor(10, 40, [&](size_t i) { out[i] = (int)i; }, 4);
+        for (size_t i = 0; i < 50; ++i) {
+            REQUIRE(out[i] == (i >= 10 && i < 40 ? (int)i : 0));
+        }
+    }
+}
+
+TEST_CASE("parallelFor balances uneven work deterministically", "[parallel]") {
+    // the cost grows with the index, so the last block would dominate without stealing
+    auto work = [](size_t i) {
+        double x = 0.0;
+        for (size_t k = 0; k < i * 4; ++k) x += std::sin((double)k + i);
+        return x;
+    };
+    std::vector<double> serial(2000), parallel(2000);
+    parallelFor(0, serial.size(), [&](size_t i) { serial[i] = work(i); }, 1);
+
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    parallelFor(0, parallel.size(), [&](size_t i) {
+        parallel[i] = work(i);
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.insert(std::this_thread::get_id());
+    }, 4);
+    REQUIRE(parallel == serial);
+    REQUIRE(threads.size() >= 1);
+    REQUIRE(threads.size() <= 4);
+}
+
+TEST_CASE("parallelFor rethrows the lowest failing index", "[parallel]") {
+    for (unsigned n_threads : {1u, 4u}) {
+        std::atomic<size_t> calls{0};
+        try {
+            parallelFor(0, 1000, [&](size_t i) {
+                calls.fetch_add(1);
+                if (i == 700 || i == 123 || i == 999) throw std::runtime_error(std::to_string(i));
+            }, n_threads);
+            FAIL("no exception");
+        } catch (const std::runtime_error& e) {
+            REQUIRE(std::string(e.what()) == "123");
+        }
+        REQUIRE(calls.load() > 123);
+    }
+}
+
+TEST_CASE("parallelFor is safe to nest and to call concurrently", "[parallel]") {
+    SECTION("Nested calls run inline") {
+        std::vector<std::atomic<int>> hits(64 * 64);
+        parallelFor(0, 64, [&](size_t i) {
+            parallelFor(0, 64, [&](size_t j) { hits[i * 64 + j].fetch_add(1); }, 4);
+        }, 4);
+        for (auto& h : hits) REQUIRE(h.load() == 1);
+    }
+
+    SECTION("Independent callers share the pool") {
+        const size_t n_callers = 6, count = 20000;
+        std::vector<std::vector<size_t>> results(n_callers, std::vector<size_t>(count));
+        std::vector<std::thread> callers;
+        for (size_t c = 0; c < n_callers; ++c) {
+            callers.emplace_back([&, c]() {
+                for (int round = 0; round < 20; ++round) {
+                    parallelFor(0, count, [&](size_t i) { results[c][i] = i * (c + 1) + round; }, 3);
+                }
+            });
+        }
+        for (auto& t : callers) t.join();
+        for (size_t c = 0; c < n_callers; ++c) {
+            for (size_t i = 0; i < count; ++i) {
+                REQUIRE(results[c][i] == i * (c + 1) + 19);
+            }
+        }
+    }
+}
+
+TEST_CASE("parallelFor never uses more threads than cores", "[parallel]") {
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    std::vector<int> out(100000, 0);
+    parallelFor(0, out.size(), [&](size_t i) {
+        out[i] = 1;
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.insert(std::this_thread::get_id());
+    }, 10000);
+    REQUIRE(threads.size() <= cores);
+    for (int v : out) REQUIRE(v == 1);
+}
+
+TEST_CASE("Concurrency limit", "[parallel]") {
+    REQUIRE(concurrencyLimit() == 0);
+    setConcurrencyLimit(1);
+    REQUIRE(defaultConcurrency() == 1);
+
+    // single-threaded mode runs everything on the caller, in order
+    std::vector<size_t> order;
+    std::atomic<bool> other_thread{false};
+    const std::thread::id caller = std::this_thread::get_id();
+    parallelFor(0, 100, [&](size_t i) {
+        if (std::this_thread::get_id() != caller) other_thread = true;
+        order.push_back(i);
+    }, 8);
+    REQUIRE_FALSE(other_thread.load());
+    for (size_t i = 0; i < order.size(); ++i) REQUIRE(order[i] == i);
+    REQUIRE(order.size() == 100);
+
+    setConcurrencyLimit(2);
+    REQUIRE(defaultConcurrency() <= 2);
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    parallelFor(0, 10000, [&](size_t) {
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.insert(std::this_thread::get_id());
+    }, 8);
+    REQUIRE(threads.size() <= 2);
+
+    setConcurrencyLimit(0);
+    REQUIRE(concurrencyLimit() == 0);
+}
@@ -2,6 +2,7 @@
 #include "catch2/matchers/catch_matchers_floating_point.hpp"
 #include "scalatrix/pitchset.hpp"
 #include <cmath>
+#include <limits>
 
 using namespace scalatrix;
 using Catch::Matchers::WithinAbs;
@@ -529,4 +530,106 @@ TEST_CASE("Pitch set integration", "[pitchset]") {
             REQUIRE_THAT(interval, WithinAbs(1.0/12, 1e-10));
         }
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Structured pitch values", "[pitchset]") {
+    SECTION("Generators record the exact value") {
+        auto et = generateETPitchSet(12, 1.0);
+        REQUIRE(et[7].kind == EDOPitch);
+        REQUIRE(et[7].num == 7);
+        REQUIRE(et[7].den == 12);
+
+        auto harmonics = generateHarmonicSeriesPitchSet(generateDefaultPrimeList(3), 8);
+        REQUIRE(harmonics[4].label == "3:2");
+        REQUIRE(harmonics[4].kind == RatioPitch);
+        REQUIRE(harmonics[4].num == 3);
+        REQUIRE(harmonics[4].den == 2);
+    }
+
+    SECTION("Labels are parsed once when the value is missing") {
+        PitchSetPitch p = PitchSetPitch::fromLabel("6:4", std::log2(1.5));
+        REQUIRE(p.kind == RatioPitch);
+        REQUIRE(p.label == "6:4");
+        REQUIRE(p.sameValue(PitchSetPitch::fromRatio(3, 2, std::log2(1.5))));
+        REQUIRE(PitchSetPitch::fromLabel("7\\12", 7.0 / 12).sameValue(PitchSetPitch::fromEDOSteps(14, 24, 7.0 / 12)));
+        REQUIRE(PitchSetPitch::fromLabel("A4", 0.0).kind == UnknownPitch);
+        REQUIRE(PitchSetPitch::fromLabel("3:x", 0.0).kind == UnknownPitch);
+    }
+
+    SECTION("Labels hold the full range of the value") {
+        PitchSetPitch fifth = PitchSetPitch::fromReducedRatio(3, 2, std::log2(1.5));
+        REQUIRE(fifth.label == "3:2");
+        REQUIRE(fifth.sameValue(PitchSetPitch::fromRatio(6, 4, std::log2(1.5))));
+        long long lo = std::numeric_limits<long long>::min(), hi = std::numeric_limits<long long>::max();
+        REQUIRE(PitchSetPitch::fromEDOSteps(lo, hi, 0.0).label == "-9223372036854775808\\9223372036854775807");
+        REQUIRE(PitchSetPitch::fromReducedRatio(hi, hi - 1, 0.0).label == "9223372036854775807:9223372036854775806");
+    }
+
+    SECTION("Tempered commas keep their identity") {
+        // 81:80 tempered out in meantone lands on the unison but is a different ratio
+        PitchSetPitch unison = PitchSetPitch::fromRatio(1, 1, 0.0);
+        PitchSetPitch comma = PitchSetPitch::fromRatio(81, 80, 0.0);
+        REQUIRE_FALSE(unison.sameValue(comma));
+        REQUIRE(pitchSetUnion({unison}, {comma}).size() == 2);
+    }
+}
+
+TEST_CASE("Pitch set algebra", "[pitchset]") {
+    PitchSet ji = generateJIPitchSet(generateDefaultPrimeList(3), 10);
+    PitchSet et = generateETPitchSet(12, 1.0);
+
+    SECTION("Union merges and deduplicates") {
+        PitchSet u = pitchSetUnion(ji, et);
+        for (size_t i = 1; i < u.size(); ++i) REQUIRE(u[i].log2fr >= u[i - 1].log2fr);
+        // 1:1 / 0\12 and 2:1 / 12\12 coincide exactly, everything else is distinct
+        REQUIRE(u.size() == ji.size() + et.size() - 2);
+        REQUIRE(u.front().label == "1:1");
+
+        PitchSet self = pitchSetUnion(ji, ji);
+        REQUIRE(self.size() == ji.size());
+    }
+
+    SECTION("Intersection within a tolerance") {
+        REQUIRE(pitchSetIntersection(ji, et).size() == 2);
+        // 4:3 and 3:2 are within 2 cents of 12-EDO, 5:4 and 6:5 are not
+        PitchSet close = pitchSetIntersection(ji, et, 2.5);
+        std::vector<std::string> labels;
+        for (auto& p : close) labels.push_back(p.label);
+        REQUIRE(labels == std::vector<std::string>{"1:1", "4:3", "3:2", "2:1"});
+        REQUIRE(pitchSetIntersection(ji, et, 20.0).size() > close.size());
+    }
+
+    SECTION("Transposition") {
+        PitchSet up = transposePitchSet(ji, PitchSetPitch::fromRatio(3, 2, std::log2(1.5)));
+        REQUIRE(up.size() == ji.size());
+        REQUIRE(up.front().label == "3:2");
+        REQUIRE(up.back().label == "3:1");
+        for (size_t i = 0; i < up.size(); ++i) {
+            REQUIRE_THAT(up[i].log2fr, WithinAbs(ji[i].log2fr + std::log2(1.5), 1e-12));
+        }
+        PitchSet et_up = transposePitchSet(et, {"5\\12", 5.0 / 12});
+        REQUIRE(et_up[7].label == "12\\12");
+    }
+
+    SECTION("Stacking matches all pairs") {
+        PitchSet a = generateJIPitchSet(generateDefaultPrimeList(3), 8);
+        PitchSet sum = stackPitchSets(a, a, 0.0, 1.0);
+        PitchSet expected;
+        for (auto& x : a) {
+            for (auto& y : a) {
+                PitchSetPitch p = x + y;
+                if (p.log2fr > 1.0) continue;
+                bool seen = false;
+                for (auto& e : expected) seen = seen || e.sameValue(p);
+                if (!seen) expected.push_back(p);
+            }
+        }
+        REQUIRE(sum.size() == expected.size());
+        for (size_t i = 1; i < sum.size(); ++i) REQUIRE(sum[i].log2fr >= sum[i - 1].log2fr);
+        for (auto& e : expected) {
+            size_t n = 0;
+            for (auto& p : sum) n += p.sameValue(e) && p.label == e.label;
+            REQUIRE(n == 1);
+        }
+    }
+}
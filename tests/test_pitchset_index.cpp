@@ -0,0 +1,233 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers_floating_point.hpp"
+#include "scalatrix/pitchset_index.hpp"
+#include "scalatrix/scale.hpp"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <thread>
+
+using namespace scalatrix;
+using Catch::Matchers::WithinAbs;
+
+// First pitch in sorted order at minimum distance, as the linear search in temperToPitchSet did
+static size_t linearNearest(const PitchSetIndex& index, double log2fr) {
+    size_t best = 0;
+    for (size_t i = 1; i < index.size(); ++i) {
+        if (std::abs(index.pitch(i).log2fr - log2fr) < std::abs(index.pitch(best).log2fr - log2fr)) best = i;
+    }
+    return best;
+}
+
+TEST_CASE("PitchSetIndex queries", "[pitchset_index]") {
+    PitchSet pitchset = generateJIPitchSet(generateDefaultPrimeList(4), 40, -2.0, 2.0);
+    PitchSetIndex index(pitchset);
+    REQUIRE(index.size() == pitchset.size());
+    for (size_t i = 1; i < index.size(); ++i) {
+        REQUIRE(index.log2fr(i) >= index.log2fr(i - 1));
+    }
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> dist(-2.5, 2.5);
+    std::vector<double> queries(1000);
+    for (auto& q : queries) q = dist(rng);
+
+    SECTION("Nearest agrees with linear search") {
+        for (double q : queries) {
+            REQUIRE(index.nearest(q) == linearNearest(index, q));
+        }
+        REQUIRE(index.nearest(-100.0) == 0);
+        REQUIRE(index.nearest(100.0) == index.size() - 1);
+    }
+
+    SECTION("Batch queries agree with single queries") {
+        std::vector<uint32_t> lb(queries.size()), nearest(queries.size());
+        index.lowerBound(queries.data(), queries.size(), lb.data());
+        index.nearest(queries.data(), queries.size(), nearest.data());
+        for (size_t i = 0; i < queries.size(); ++i) {
+            REQUIRE(lb[i] == index.lowerBound(queries[i]));
+            REQUIRE(nearest[i] == index.nearest(queries[i]));
+        }
+        // exact hits land on the pitch itself
+        index.lowerBound(index.log2frs(), index.size(), lb.data());
+        for (size_t i = 0; i < index.size(); ++i) {
+            REQUIRE(index.log2fr(lb[i]) == index.log2fr(i));
+        }
+    }
+
+    SECTION("k nearest and range") {
+        for (double q : {-1.3, 0.0, 0.58, 2.4}) {
+            auto k = index.kNearest(q, 6);
+            REQUIRE(k.size() == 6);
+            REQUIRE(k[0] == index.nearest(q));
+            double kth = std::abs(index.pitch(k.back()).log2fr - q);
+            for (size_t i = 1; i < k.size(); ++i) {
+                REQUIRE(std::abs(index.pitch(k[i]).log2fr - q) >= std::abs(index.pitch(k[i - 1]).log2fr - q));
+            }
+            size_t closer = 0;
+            for (size_t i = 0; i < index.size(); ++i) {
+                if (std::abs(index.pitch(i).log2fr - q) < kth) closer++;
+            }
+            REQUIRE(closer <= 5);
+        }
+        REQUIRE(index.kNearest(0.0, index.size() + 10).size() == index.size());
+
+        auto r = index.range(0.0, 1.0);
+        size_t count = 0;
+        for (auto& p : pitchset) {
+            if (p.log2fr >= 0.0 && p.log2fr <= 1.0) count++;
+        }
+        REQUIRE(r.second - r.first == count);
+        REQUIRE(index.pitch(r.first).label == "1:1");
+        REQUIRE(index.pitch(r.second - 1).label == "2:1");
+        auto empty = index.range(0.3, 0.2);
+        REQUIRE(empty.first == empty.second);
+    }
+}
+
+TEST_CASE("PitchSetIndex equave-reduced lookup", "[pitchset_index]") {
+    PitchSet pitchset = generateJIPitchSet(generateDefaultPrimeList(3), 10, 0.0, 0.999);
+    PitchSetIndex index(pitchset);
+    double matched;
+
+    // 3:2 two octaves up
+    size_t i = index.nearestReduced(2.0 + std::log2(1.5) + 0.001, matched);
+    REQUIRE(index.pitch(i).label == "3:2");
+    REQUIRE_THAT(matched, WithinAbs(2.0 + std::log2(1.5), 1e-12));
+
+    // just below an octave wraps to 1:1 of the next one
+    i = index.nearestReduced(-1.0 - 0.001, matched);
+    REQUIRE(index.pitch(i).label == "1:1");
+    REQUIRE_THAT(matched, WithinAbs(-1.0, 1e-12));
+
+    // non-octave equave: 5:1 is 5:3 a tritave up
+    PitchSet bp = {{"1:1", 0.0}, {"9:7", std::log2(9.0 / 7.0)}, {"5:3", std::log2(5.0 / 3.0)}};
+    PitchSetIndex tritave(bp, std::log2(3.0));
+    i = tritave.nearestReduced(std::log2(5.0), matched);
+    REQUIRE(tritave.pitch(i).label == "5:3");
+    REQUIRE_THAT(matched, WithinAbs(std::log2(5.0), 1e-12));
+}
+
+TEST_CASE("PitchSetIndex shared across threads", "[pitchset_index]") {
+    PitchSetIndex index(generateJIPitchSet(generateDefaultPrimeList(5), 200, -1.0, 1.0));
+    std::vector<size_t> mismatches(4, 0);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < mismatches.size(); ++t) {
+        threads.emplace_back([&index, &mismatches, t]() {
+            std::mt19937 rng(t);
+            std::uniform_real_distribution<double> dist(-1.0, 1.0);
+            for (int n = 0; n < 2000; ++n) {
+                double q = dist(rng);
+                size_t i = index.nearest(q);
+                if (i > 0 && std::abs(index.pitch(i - 1).log2fr - q) < std::abs(index.pitch(i).log2fr - q)) mismatches[t]++;
+                if (i + 1 < index.size() && std::abs(index.pitch(i + 1).log2fr - q) < std::abs(index.pitch(i).log2fr - q)) mismatches[t]++;
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    for (size_t m : mismatches) REQUIRE(m == 0);
+}
+
+TEST_CASE("Scale tempers through a shared index", "[pitchset_index]") {
+    PitchSet pitchset = generateETPitchSet(12, 1.0, -2.0, 2.0);
+    PitchSetIndex index(pitchset);
+    AffineTransform A(1.0 / 7.0, 0.0, 0.0, 1.0, 0.0, 0.0);
+    Scale untempered = Scale::fromAffine(A, 261.63, 64, 32);
+    Scale a = untempered;
+    Scale b = untempered;
+    a.temperToPitchSet(pitchset);
+    b.temperToPitchSet(index);
+    for (size_t i = 0; i < untempered.getNodes().size(); ++i) {
+        double log2fr = std::log2(untempered.getNodes()[i].pitch / 261.63);
+        PitchSetPitch expected = index.pitch(linearNearest(index, log2fr));
+        REQUIRE(a.getNodes()[i].temperedPitch.label == expected.label);
+        REQUIRE(b.getNodes()[i].temperedPitch.label == expected.label);
+        REQUIRE(a.getNodes()[i].pitch == b.getNodes()[i].pitch);
+    }
+}
+
+TEST_CASE("PitchSetIndex binary files", "[pitchset_index]") {
+    PitchSet ji = generateJIPitchSet(generateDefaultPrimeList(4), 30, -1.0, 2.0);
+    PitchSet pitchset = pitchSetUnion(ji, generateETPitchSet(31, 1.0, -1.0, 2.0));
+    pitchset.push_back({"free text", 0.123});
+    PitchSetIndex index(pitchset);
+    std::string path = "test_pitchset_index.scxp";
+    index.save(path);
+
+    SECTION("Mapped index answers like the original") {
+        PitchSetIndex mapped = PitchSetIndex::load(path);
+        REQUIRE(mapped.size() == index.size());
+        REQUIRE(mapped.equave() == index.equave());
+        for (size_t i = 0; i < index.size(); ++i) {
+            REQUIRE(mapped.log2fr(i) == index.log2fr(i));
+            REQUIRE(mapped.label(i) == index.label(i));
+            REQUIRE(mapped.kind(i) == index.kind(i));
+            REQUIRE(mapped.num(i) == index.num(i));
+            REQUIRE(mapped.den(i) == index.den(i));
+        }
+        double m1, m2;
+        for (double q : {-0.77, 0.0, 0.123, 0.5849, 1.9, 3.3}) {
+            REQUIRE(mapped.nearest(q) == index.nearest(q));
+            REQUIRE(mapped.kNearest(q, 5) == index.kNearest(q, 5));
+            REQUIRE(mapped.nearestReduced(q, m1) == index.nearestReduced(q, m2));
+            REQUIRE(m1 == m2);
+        }
+        // the mapping stays alive through copies
+        PitchSetIndex copy = mapped;
+        mapped = index;
+        REQUIRE(copy.label(copy.nearest(std::log2(1.5))) == "3:2");
+    }
+
+    SECTION("Pitch set round trip keeps exact values") {
+        PitchSet read = readPitchSetFile(path);
+        REQUIRE(read.size() == pitchset.size());
+        size_t fifth = index.nearest(std::log2(1.5));
+        REQUIRE(read[fifth].kind == RatioPitch);
+        REQUIRE(read[fifth].sameValue(PitchSetPitch::fromRatio(3, 2, 0.0)));
+        REQUIRE(index.label(index.nearest(0.123)) == "free text");
+    }
+
+    SECTION("Invalid files are rejected") {
+        REQUIRE_THROWS_AS(PitchSetIndex::load("does_not_exist.scxp"), std::runtime_error);
+        {
+            std::ofstream out("test_pitchset_index_bad.scxp", std::ios::binary);
+            out << std::string(200, 'x');
+        }
+        REQUIRE_THROWS_AS(PitchSetIndex::load("test_pitchset_index_bad.scxp"), std::runtime_error);
+        std::remove("test_pitchset_index_bad.scxp");
+    }
+
+    SECTION("Corrupt columns are rejected") {
+        std::string bytes;
+        {
+            std::ifstream in(path, std::ios::binary);
+            bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        // column offsets as in the file layout: 64 byte header, four 8 byte columns, then reduced_order
+        size_t n = index.size();
+        size_t reduced_order = 64 + 32 * n;
+        size_t kind = ((((reduced_order + 4 * n) + 7) & ~size_t(7)) + 4 * (n + 1) + 7) & ~size_t(7);
+        auto loadPatched = [&](size_t offset, const std::string& patch) {
+            std::string corrupt = bytes;
+            corrupt.replace(offset, patch.size(), patch);
+            {
+                std::ofstream out("test_pitchset_index_bad.scxp", std::ios::binary);
+                out << corrupt;
+            }
+            PitchSetIndex loaded = PitchSetIndex::load("test_pitchset_index_bad.scxp");
+            std::remove("test_pitchset_index_bad.scxp");
+            return loaded;
+        };
+        REQUIRE(loadPatched(0, bytes.substr(0, 8)).size() == n);
+        REQUIRE(bytes[kind + 1] == (char)index.kind(1));
+        REQUIRE_THROWS_AS(loadPatched(reduced_order + 4, std::string(4, '\xff')), std::runtime_error);
+        REQUIRE_THROWS_AS(loadPatched(kind + 1, std::string(1, '\x07')), std::runtime_error);
+        // a header count that does not match the file size
+        REQUIRE_THROWS_AS(loadPatched(16, std::string("\xff\xff\xff\x0f\0\0\0\0", 8)), std::runtime_error);
+        std::remove("test_pitchset_index_bad.scxp");
+    }
+
+    std::remove(path.c_str());
+}
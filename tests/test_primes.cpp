@@ -0,0 +1,116 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers_floating_point.hpp"
+#include "scalatrix/primes.hpp"
+#include <cmath>
+
+using namespace scalatrix;
+using Catch::Matchers::WithinAbs;
+
+static bool isPrimeByTrialDivision(unsigned int n) {
+    if (n < 2) return false;
+    for (unsigned int d = 2; d * d <= n; ++d) {
+        if (n % d == 0) return false;
+    }
+    return true;
+}
+
+TEST_CASE("Prime sieve", "[primes]") {
+    PrimeSieve sieve(10000);
+
+    SECTION("Smallest factors agree with trial division") {
+        for (unsigned int n = 2; n <= 10000; ++n) {
+            unsigned int p = sieve.smallestFactor(n);
+            REQUIRE(n % p == 0);
+            REQUIRE(isPrimeByTrialDivision(p));
+            for (unsigned int d = 2; d < p; ++d) {
+                REQUIRE(n % d != 0);
+            }
+        }
+    }
+
+    SECTION("Prime count") {
+        REQUIRE(sieve.primes().size() == 1229);
+        REQUIRE(sieve.primes().front() == 2);
+        REQUIRE(sieve.primes().back() == 9973);
+    }
+
+    SECTION("Shared sieve grows and is reused") {
+        auto small = PrimeSieve::shared(100);
+        REQUIRE(small->limit() >= 100);
+        auto large = PrimeSieve::shared(small->limit() + 1);
+        REQUIRE(large->limit() >= 2 * small->limit());
+        REQUIRE(PrimeSieve::shared(100) == large);
+    }
+}
+
+TEST_CASE("Prime list factorisation", "[primes]") {
+    PrimeList primes = generateDefaultPrimeList(4); // 2, 3, 5, 7
+
+    SECTION("Monzos over the list") {
+        PrimeListFactorizer f(primes, 1000);
+        std::vector<int> monzo;
+        REQUIRE(f.monzo(360, monzo));
+        REQUIRE(monzo == std::vector<int>{3, 2, 1, 0});
+        REQUIRE(f.monzo(1, monzo));
+        REQUIRE(monzo == std::vector<int>{0, 0, 0, 0});
+        REQUIRE_FALSE(f.monzo(22, monzo));
+    }
+
+    SECTION("Smooth numbers match trial division") {
+        auto smooth = smoothNumbers(primes, 5000);
+        size_t k = 0;
+        for (unsigned int n = 1; n <= 5000; ++n) {
+            unsigned int r = n;
+            for (unsigned int p : {2u, 3u, 5u, 7u}) {
+                while (r % p == 0) r /= p;
+            }
+            if (r != 1) continue;
+            REQUIRE(k < smooth.size());
+            REQUIRE(smooth[k].number == n);
+            REQUIRE_THAT(smooth[k].log2fr, WithinAbs(std::log2((double)n), 1e-9));
+            k++;
+        }
+        REQUIRE(k == smooth.size());
+    }
+
+    SECTION("Tempered prime tunings are summed") {
+        PrimeList tempered = primes;
+        tempered[1].log2fr = 1.58;
+        double l;
+        PrimeListFactorizer f(tempered, 100);
+        REQUIRE(f.log2fr(18, l));
+        REQUIRE_THAT(l, WithinAbs(1.0 + 2 * 1.58, 1e-12));
+        REQUIRE_FALSE(f.log2fr(11, l));
+        REQUIRE(f.log2fr(22, l, true));
+        REQUIRE_THAT(l, WithinAbs(1.0 + std::log2(11.0), 1e-12));
+    }
+
+    SECTION("Subgroups and pseudo-primes") {
+        PrimeList subgroup = {pseudoPrimeFromIndexNumber(0), pseudoPrimeFromIndexNumber(3)}; // 2.7
+        PrimeListFactorizer f(subgroup, 100);
+        REQUIRE(f.hasPrimeBasis());
+        std::vector<int> monzo;
+        REQUIRE(f.monzo(28, monzo));
+        REQUIRE(monzo == std::vector<int>{2, 1});
+        REQUIRE_FALSE(f.monzo(6, monzo));
+
+        // 9 as a pseudo-prime keeps the list-order trial division semantics
+        PrimeList pseudo = {pseudoPrimeFromIndexNumber(0), {"9", 9, 3.17}};
+        PrimeListFactorizer g(pseudo, 100);
+        REQUIRE_FALSE(g.hasPrimeBasis());
+        REQUIRE(g.monzo(36, monzo));
+        REQUIRE(monzo == std::vector<int>{2, 1});
+        REQUIRE_FALSE(g.monzo(3, monzo));
+    }
+}
+
+TEST_CASE("Prime lists beyond 25 primes", "[primes]") {
+    REQUIRE(pseudoPrimeFromIndexNumber(24).number == 97);
+    REQUIRE(pseudoPrimeFromIndexNumber(25).number == 101);
+    REQUIRE(pseudoPrimeFromIndexNumber(999).number == 7919);
+
+    PrimeList primes = generateDefaultPrimeList(40);
+    REQUIRE(primes.size() == 40);
+    REQUIRE(primes[39].number == 173);
+    REQUIRE(primes[39].label == "173");
+}
@@ -0,0 +1,179 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers_floating_point.hpp"
+#include "scalatrix/rational.hpp"
+#include "scalatrix/lattice.hpp"
+#include "scalatrix/scale.hpp"
+#include "scalatrix/mos.hpp"
+#include <cmath>
+
+using namespace scalatrix;
+using Catch::Matchers::WithinAbs;
+
+TEST_CASE("Rational arithmetic", "[rational]") {
+    SECTION("Normalization") {
+        Rational r(6, -8);
+        REQUIRE(r.num == -3);
+        REQUIRE(r.den == 4);
+        REQUIRE(Rational(0, 5) == Rational(0));
+    }
+
+    SECTION("Operations are exact") {
+        Rational a(1, 3), b(1, 6);
+        REQUIRE(a + b == Rational(1, 2));
+        REQUIRE(a - b == Rational(1, 6));
+        REQUIRE(a * b == Rational(1, 18));
+        REQUIRE(a / b == Rational(2));
+        REQUIRE(b < a);
+        REQUIRE(-a < b);
+    }
+
+    SECTION("Floor rounds towards negative infinity") {
+        REQUIRE(Rational(7, 2).floor() == 3);
+        REQUIRE(Rational(-7, 2).floor() == -4);
+        REQUIRE(Rational(-4, 2).floor() == -2);
+    }
+
+    SECTION("Approximation of doubles") {
+        REQUIRE(Rational::approximate(0.6) == Rational(3, 5));
+        REQUIRE(Rational::approximate(-7.0 / 12.0) == Rational(-7, 12));
+        Rational pi = Rational::approximate(M_PI, 1000);
+        REQUIRE(pi == Rational(355, 113));
+    }
+}
+
+TEST_CASE("RationalAffineTransform", "[rational]") {
+    RationalAffineTransform A({2, 5}, {1, 5}, {1, 7}, {-2, 7}, 0, {1, 14});
+
+    SECTION("Inverse round-trips exactly") {
+        RationalAffineTransform I = A * A.inverse();
+        REQUIRE(I.a == Rational(1));
+        REQUIRE(I.b == Rational(0));
+        REQUIRE(I.c == Rational(0));
+        REQUIRE(I.d == Rational(1));
+        REQUIRE(I.tx == Rational(0));
+        REQUIRE(I.ty == Rational(0));
+    }
+
+    SECTION("toAffine agrees with exact application") {
+        AffineTransform B = A.toAffine();
+        Vector2d exact = A.applyToDouble({3, -4});
+        Vector2d approx = B * Vector2i(3, -4);
+        REQUIRE_THAT(approx.x, WithinAbs(exact.x, 1e-12));
+        REQUIRE_THAT(approx.y, WithinAbs(exact.y, 1e-12));
+    }
+}
+
+TEST_CASE("Exact strip computation", "[rational]") {
+    // diatonic in 12-EDO: generator 7/12, strip rows y = (2 * 1 + 1) / 14 + k / 7
+    MOS mos = MOS::fromRational(5, 2, 1, 1, {7, 12});
+    const RationalAffineTransform& A = mos.exactAffine;
+
+    SECTION("One period contains one node per scale degree") {
+        StripPeriod strip = findStripPeriod(A);
+        REQUIRE(strip.period == Vector2i(5, 2));
+        REQUIRE(strip.nodes.size() == 7);
+        REQUIRE(strip.nodes[strip.root] == Vector2i(0, 0));
+        for (auto& v : strip.nodes) {
+            Vector2r t = A * v;
+            REQUIRE(Rational(0) <= t.y);
+            REQUIRE(t.y < Rational(1));
+            REQUIRE(Rational(0) <= t.x);
+            REQUIRE(t.x < Rational(1));
+        }
+    }
+
+    SECTION("Matches the floating point walk") {
+        Scale exact = Scale::fromRationalAffine(A, 1.0, 128, 60);
+        Scale approx = Scale::fromAffine(A.toAffine(), 1.0, 128, 60);
+        REQUIRE(exact.getRootIdx() == 60);
+        for (int i = 0; i < 128; ++i) {
+            REQUIRE(exact.getNodes()[i].natural_coord == approx.getNodes()[i].natural_coord);
+            REQUIRE_THAT(exact.getNodes()[i].tuning_coord.x,
+                         WithinAbs(approx.getNodes()[i].tuning_coord.x, 1e-9));
+        }
+    }
+
+    SECTION("12-EDO pitches are exact multiples of a semitone") {
+        Scale exact = Scale::fromRationalAffine(A, 1.0, 128, 60);
+        for (auto& node : exact.getNodes()) {
+            double steps = node.tuning_coord.x * 12.0;
+            REQUIRE(steps == std::round(steps));
+        }
+    }
+}
+
+TEST_CASE("MOS exact mode", "[rational][mos]") {
+    SECTION("Degenerate rational generators") {
+        // 3/5 of the period and 1/2 are exactly rational, the cases the tolerance path struggles with
+        for (Rational g : {Rational(3, 5), Rational(1, 2), Rational(2, 5)}) {
+            MOS exact = MOS::fromRational(3, 2, 0, 1, g);
+            MOS approx = MOS::fromParams(3, 2, 0, 1.0, g.toDouble());
+            REQUIRE(exact.exact);
+            REQUIRE(exact.base_scale.getNodes().size() == approx.base_scale.getNodes().size());
+            for (size_t i = 0; i < exact.base_scale.getNodes().size(); ++i) {
+                REQUIRE_THAT(exact.base_scale.getNodes()[i].tuning_coord.x,
+                             WithinAbs(approx.base_scale.getNodes()[i].tuning_coord.x, 1e-9));
+            }
+        }
+    }
+
+    SECTION("Implied affine matches the floating point construction") {
+        MOS exact = MOS::fromRational(5, 2, 1, 1, {7, 12});
+        MOS approx = MOS::fromParams(5, 2, 1, 1.0, 7.0 / 12.0);
+        REQUIRE_THAT(exact.impliedAffine.a, WithinAbs(approx.impliedAffine.a, 1e-12));
+        REQUIRE_THAT(exact.impliedAffine.b, WithinAbs(approx.impliedAffine.b, 1e-12));
+        REQUIRE_THAT(exact.impliedAffine.c, WithinAbs(approx.impliedAffine.c, 1e-12));
+        REQUIRE_THAT(exact.impliedAffine.d, WithinAbs(approx.impliedAffine.d, 1e-12));
+        REQUIRE_THAT(exact.impliedAffine.ty, WithinAbs(approx.impliedAffine.ty, 1e-12));
+        REQUIRE(exact.L_vec == approx.L_vec);
+        REQUIRE(exact.s_vec == approx.s_vec);
+    }
+
+    SECTION("Generated scales are exact and retuning leaves exact mode") {
+        MOS mos = MOS::fromRational(5, 2, 1, 1, {7, 12});
+        Scale scale = mos.generateScaleFromMOS(1.0, 128, 60);
+        REQUIRE(scale.getNodes()[60].tuning_coord.x == 0.0);
+        REQUIRE(scale.getNodes()[67].tuning_coord.x == 1.0);
+        REQUIRE(scale.getNodes()[53].tuning_coord.x == -1.0);
+
+        mos.retuneOnePoint({1, 0}, 0.2);
+        REQUIRE_FALSE(mos.exact);
+    }
+
+    SECTION("retuneZeroPoint keeps retunes and restores exact mode only without one") {
+        MOS mos = MOS::fromRational(5, 2, 1, 1, {7, 12});
+        Scale before = mos.generateScaleFromMOS(1.0, 128, 60);
+
+        // a retune that leaves the affine where it was
+        mos.retuneOnePoint({0, 0}, 0.0);
+        REQUIRE_FALSE(mos.exact);
+        mos.retuneZeroPoint();
+        REQUIRE(mos.exact);
+        Scale restored = mos.generateScaleFromMOS(1.0, 128, 60);
+        for (size_t i = 0; i < before.getNodes().size(); ++i) {
+            REQUIRE(restored.getNodes()[i].tuning_coord.x == before.getNodes()[i].tuning_coord.x);
+        }
+
+        mos.retuneTwoPoints({0, 0}, {1, 0}, 0.21);
+        mos.retuneOnePoint({1, 1}, 0.6);
+        REQUIRE(mos.has_exact_params);
+        AffineTransform retuned = mos.impliedAffine;
+        double generator = mos.generator;
+        Scale tuned = mos.generateScaleFromMOS(1.0, 128, 60);
+        mos.retuneZeroPoint();
+        REQUIRE_FALSE(mos.exact);
+        REQUIRE(mos.generator == generator);
+        REQUIRE(mos.impliedAffine.a == retuned.a);
+        REQUIRE(mos.impliedAffine.tx == retuned.tx);
+        Scale after = mos.generateScaleFromMOS(1.0, 128, 60);
+        for (size_t i = 0; i < tuned.getNodes().size(); ++i) {
+            REQUIRE(after.getNodes()[i].tuning_coord.x == tuned.getNodes()[i].tuning_coord.x);
+        }
+
+        // floating point parameters drop the rational ones
+        mos.adjustParams(5, 2, 1, 1.0, 0.585);
+        REQUIRE_FALSE(mos.has_exact_params);
+        mos.retuneZeroPoint();
+        REQUIRE_FALSE(mos.exact);
+    }
+}
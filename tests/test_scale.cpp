@@ -180,4 +180,71 @@ TEST_CASE("Scale retuning with affine transform", "[scale]") {
             REQUIRE(node.natural_coord.y <= 100);
         }
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Scale::fromPeriodicityBlock generates Fokker blocks", "[scale]") {
+    auto A = affineFromThreeDots(
+        {0, 0}, {3, 1}, {5, 2},
+        {0, 3.0/24}, {.585, 5.0/24}, {1.0, 3.0/24}
+    );
+    Vector2i octave(5, 2);
+    Vector2i dim2(1, -2); // 12 fifths minus 7 octaves
+    long det = octave.x * dim2.y - octave.y * dim2.x;
+
+    SECTION("Hermite basis spans the sublattice") {
+        auto [h1, h2] = hermiteBasis(octave, dim2);
+        REQUIRE(h1.y == 0);
+        REQUIRE(h1.x * h2.y == std::abs(det));
+        REQUIRE(0 <= h2.x);
+        REQUIRE(h2.x < h1.x);
+    }
+
+    SECTION("Block has |det| nodes inside the parallelogram") {
+        auto scale = Scale::fromPeriodicityBlock(A, octave, dim2, 261.63);
+        auto& nodes = scale.getNodes();
+        REQUIRE(nodes.size() == 12);
+        for (auto& node : nodes) {
+            Vector2i v = node.natural_coord;
+            long s_num = (long)v.x * dim2.y - (long)v.y * dim2.x;
+            long t_num = (long)octave.x * v.y - (long)octave.y * v.x;
+            double s = (double)s_num / det, t = (double)t_num / det;
+            REQUIRE(s >= 0.0);
+            REQUIRE(s < 1.0);
+            REQUIRE(t >= 0.0);
+            REQUIRE(t < 1.0);
+        }
+    }
+
+    SECTION("Nodes are distinct modulo the unison vectors and sorted by pitch") {
+        auto scale = Scale::fromPeriodicityBlock(A, octave, dim2, 261.63, {-0.5, -0.5});
+        auto& nodes = scale.getNodes();
+        REQUIRE(nodes.size() == 12);
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (i > 0) REQUIRE(nodes[i - 1].tuning_coord.x <= nodes[i].tuning_coord.x);
+            for (size_t j = i + 1; j < nodes.size(); ++j) {
+                Vector2i d = nodes[i].natural_coord - nodes[j].natural_coord;
+                long s_num = (long)d.x * dim2.y - (long)d.y * dim2.x;
+                long t_num = (long)octave.x * d.y - (long)octave.y * d.x;
+                REQUIRE((s_num % det != 0 || t_num % det != 0));
+            }
+        }
+        auto& root = nodes[scale.getRootIdx()];
+        REQUIRE(root.natural_coord == Vector2i(0, 0));
+        REQUIRE_THAT(root.pitch, WithinAbs(261.63, 1e-9));
+    }
+
+    SECTION("Batch generation matches single blocks") {
+        std::vector<std::pair<Vector2i, Vector2i>> pairs = {
+            {octave, dim2}, {octave, {3, 1}}, {{7, 3}, {-2, 5}}, {{4, -1}, {1, 3}}
+        };
+        auto scales = Scale::fromPeriodicityBlocks(A, pairs, 261.63, {0.0, 0.0}, 3);
+        REQUIRE(scales.size() == pairs.size());
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            auto single = Scale::fromPeriodicityBlock(A, pairs[i].first, pairs[i].second, 261.63);
+            REQUIRE(scales[i].getNodes().size() == single.getNodes().size());
+            for (size_t k = 0; k < single.getNodes().size(); ++k) {
+                REQUIRE(scales[i].getNodes()[k].natural_coord == single.getNodes()[k].natural_coord);
+            }
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers_floating_point.hpp"
+#include "scalatrix/scale3.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace scalatrix;
+using Catch::Matchers::WithinAbs;
+
+// 5-limit JI: natural coords are monzos (2, 3, 5), x is the exact log2 frequency ratio
+static AffineTransform3 fiveLimitAffine() {
+    return AffineTransform3(
+        1.0, std::log2(3.0), std::log2(5.0),
+        0.10, 0.23, -0.17,
+        -0.13, 0.07, 0.19,
+        0.0, 0.05, 0.3
+    );
+}
+
+TEST_CASE("AffineTransform3 basics", "[scale3]") {
+    AffineTransform3 A = fiveLimitAffine();
+
+    SECTION("Inverse round-trips") {
+        Vector3d v(2.0, -1.0, 3.0);
+        Vector3d w = A.inverse() * (A * v);
+        REQUIRE_THAT(w.x, WithinAbs(v.x, 1e-12));
+        REQUIRE_THAT(w.y, WithinAbs(v.y, 1e-12));
+        REQUIRE_THAT(w.z, WithinAbs(v.z, 1e-12));
+    }
+
+    SECTION("affineFromFourDots reproduces the transform") {
+        Vector3d a[4] = {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+        AffineTransform3 B = affineFromFourDots(a[0], a[1], a[2], a[3], A * a[0], A * a[1], A * a[2], A * a[3]);
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                REQUIRE_THAT(B.m[i][j], WithinAbs(A.m[i][j], 1e-12));
+            }
+        }
+        REQUIRE_THAT(B.ty, WithinAbs(A.ty, 1e-12));
+    }
+
+    SECTION("Steps are sorted and inside the prism cross-section") {
+        auto steps = findStepsWithinPrism(A, 0.5);
+        REQUIRE(!steps.empty());
+        AffineTransform3 M = A;
+        M.tx = M.ty = M.tz = 0;
+        for (size_t i = 0; i < steps.size(); ++i) {
+            Vector3d w = M * steps[i];
+            REQUIRE(w.x > 0);
+            REQUIRE(std::abs(w.y) < 1);
+            REQUIRE(std::abs(w.z) < 1);
+            if (i > 0) REQUIRE((M * steps[i - 1]).x <= w.x);
+        }
+    }
+}
+
+TEST_CASE("Scale3::fromAffine matches brute-force prism selection", "[scale3]") {
+    AffineTransform3 A = fiveLimitAffine();
+    int N = 96, root = 40;
+    auto scale = Scale3::fromAffine(A, 261.63, N, root);
+    auto& nodes = scale.getNodes();
+
+    REQUIRE(nodes.size() == (size_t)N);
+    REQUIRE(nodes[root].natural_coord == Vector3i(0, 0, 0));
+    REQUIRE_THAT(nodes[root].pitch, WithinAbs(261.63, 1e-10));
+
+    double x_min = nodes.front().tuning_coord.x;
+    double x_max = nodes.back().tuning_coord.x;
+
+    std::vector<Node3> expected;
+    const int R = 40;
+    for (int a = -R; a <= R; ++a) {
+        for (int b = -R; b <= R; ++b) {
+            for (int c = -R; c <= R; ++c) {
+                Vector3d w = A * Vector3i(a, b, c);
+                if (0 <= w.y && w.y < 1 && 0 <= w.z && w.z < 1 && x_min <= w.x && w.x <= x_max) {
+                    expected.push_back(Node3({a, b, c}, w, 0.0));
+                }
+            }
+        }
+    }
+    std::sort(expected.begin(), expected.end());
+
+    REQUIRE(expected.size() == nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        REQUIRE(nodes[i].natural_coord == expected[i].natural_coord);
+    }
+}
+
+TEST_CASE("Scale3 retuning keeps natural coordinates", "[scale3]") {
+    AffineTransform3 A = fiveLimitAffine();
+    auto scale = Scale3::fromAffine(A, 440.0, 32, 10);
+    std::vector<Vector3i> coords;
+    for (auto& node : scale.getNodes()) coords.push_back(node.natural_coord);
+
+    AffineTransform3 B = A;
+    B.m[0][0] = 1.01;
+    scale.retuneWithAffine(B);
+    auto& nodes = scale.getNodes();
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        REQUIRE(nodes[i].natural_coord == coords[i]);
+        REQUIRE_THAT(nodes[i].tuning_coord.x, WithinAbs((B * coords[i]).x, 1e-12));
+    }
+}
@@ -0,0 +1,112 @@
+#include "catch2/catch_test_macros.hpp"
+#include "scalatrix/scale_arrays.hpp"
+#include "scalatrix/mos.hpp"
+#include "scalatrix/pitchset.hpp"
+
+using namespace scalatrix;
+
+static void requireRow(const ScaleArrays& arrays, size_t s, const Scale& scale) {
+    const std::vector<Node>& nodes = scale.getNodes();
+    REQUIRE(nodes.size() == arrays.n_nodes);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        size_t k = s * arrays.n_nodes + i;
+        REQUIRE(arrays.natural_coords[2 * k] == nodes[i].natural_coord.x);
+        REQUIRE(arrays.natural_coords[2 * k + 1] == nodes[i].natural_coord.y);
+        REQUIRE(arrays.tuning_coords[2 * k] == nodes[i].tuning_coord.x);
+        REQUIRE(arrays.tuning_coords[2 * k + 1] == nodes[i].tuning_coord.y);
+        REQUIRE(arrays.pitches[k] == nodes[i].pitch);
+        REQUIRE((arrays.tempered[k] != 0) == nodes[i].isTempered);
+    }
+}
+
+TEST_CASE("Batch scale generation", "[scale_arrays]") {
+    std::vector<MOSParams> params;
+    for (int i = 0; i < 40; ++i) {
+        params.push_back({5, 2, 1 + i % 5, 1.0, 0.55 + 0.002 * i});
+        params.push_back({3, 4, i % 4, 1.0, 0.4 + 0.003 * i});
+    }
+    const double base_freq = 261.6;
+    const int n_nodes = 64, root = 30;
+
+    SECTION("Rows match generateScaleFromMOS for any thread count") {
+        ScaleArrays single = generateMOSScales(params, base_freq, n_nodes, root, 1);
+        ScaleArrays parallel = generateMOSScales(params, base_freq, n_nodes, root, 8);
+        REQUIRE(single.n_scales == params.size());
+        REQUIRE(single.n_nodes == (size_t)n_nodes);
+        REQUIRE(single.pitches.size() == params.size() * n_nodes);
+        REQUIRE(parallel.natural_coords == single.natural_coords);
+        REQUIRE(parallel.tuning_coords == single.tuning_coords);
+        REQUIRE(parallel.pitches == single.pitches);
+        for (size_t s = 0; s < params.size(); s += 7) {
+            MOS mos = MOS::fromParams(params[s].a, params[s].b, params[s].m, params[s].e, params[s].r);
+            requireRow(single, s, mos.generateScaleFromMOS(base_freq, n_nodes, root));
+        }
+    }
+
+    SECTION("Tempering many scales to one pitch set") {
+        PitchSetIndex index(generateETPitchSet(12, 1.0, -5.0, 5.0));
+        ScaleArrays arrays = temperMOSScales(params, index, base_freq, n_nodes, root, 4);
+        for (size_t s = 0; s < params.size(); s += 5) {
+            MOS mos = MOS::fromParams(params[s].a, params[s].b, params[s].m, params[s].e, params[s].r);
+            Scale scale = mos.generateScaleFromMOS(base_freq, n_nodes, root);
+            scale.temperToPitchSet(index);
+            requireRow(arrays, s, scale);
+            REQUIRE(arrays.tempered_log2frs[s * n_nodes] == scale.getNodes()[0].temperedPitch.log2fr);
+        }
+    }
+
+    SECTION("Tempering one scale to many pitch sets") {
+        MOS mos = MOS::fromParams(5, 2, 1, 1.0, 0.585);
+        Scale scale = mos.generateScaleFromMOS(base_freq, n_nodes, root);
+        std::vector<PitchSetIndex> indices;
+        for (int edo = 5; edo <= 31; ++edo) indices.emplace_back(generateETPitchSet(edo, 1.0, -5.0, 5.0));
+        ScaleArrays arrays = temperScales(scale, indices, 4);
+        REQUIRE(arrays.n_scales == indices.size());
+        for (size_t s = 0; s < indices.size(); ++s) {
+            Scale tempered = scale;
+            tempered.temperToPitchSet(indices[s]);
+            requireRow(arrays, s, tempered);
+        }
+        // the source scale is untouched
+        REQUIRE_FALSE(scale.getNodes()[0].isTempered);
+    }
+
+    SECTION("Empty batches") {
+        ScaleArrays arrays = generateMOSScales({}, base_freq, n_nodes, root);
+        REQUIRE(arrays.n_scales == 0);
+        REQUIRE(arrays.pitches.empty());
+    }
+}
+
+TEST_CASE("Single-row fills reuse their storage", "[scale_arrays]") {
+    MOS mos = MOS::fromParams(5, 2, 1, 1.0, 0.585);
+    ScaleArrays arrays;
+
+    SECTION("Keyboard") {
+        fillMOSScaleArrays(mos, 261.6, 128, 60, arrays);
+        REQUIRE(arrays.n_scales == 1);
+        REQUIRE(arrays.n_nodes == 128);
+        requireRow(arrays, 0, mos.generateScaleFromMOS(261.6, 128, 60));
+
+        // refilling with no more nodes keeps the columns in place
+        const double* pitches = arrays.pitches.data();
+        mos.retuneOnePoint({1, 0}, 0.17);
+        Scale retuned = mos.generateScaleFromMOS(261.6, 100, 50);
+        fillScaleArrays(retuned, arrays);
+        REQUIRE(arrays.pitches.data() == pitches);
+        requireRow(arrays, 0, retuned);
+    }
+
+    SECTION("Lattice window") {
+        fillLatticeArrays(mos, {-3, -2}, {4, 5}, 440.0, arrays);
+        REQUIRE(arrays.n_nodes == 8 * 8);
+        size_t k = (size_t)(1 - -2) * 8 + (size_t)(2 - -3);
+        REQUIRE(arrays.natural_coords[2 * k] == 2);
+        REQUIRE(arrays.natural_coords[2 * k + 1] == 1);
+        Vector2d tuning = mos.impliedAffine * Vector2i(2, 1);
+        REQUIRE(arrays.tuning_coords[2 * k] == tuning.x);
+        REQUIRE(arrays.tuning_coords[2 * k + 1] == tuning.y);
+        REQUIRE(arrays.pitches[k] == mos.coordToFreq(2, 1, 440.0));
+        REQUIRE(arrays.tempered[k] == 0);
+    }
+}
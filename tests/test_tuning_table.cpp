@@ -0,0 +1,95 @@
+#include "catch2/catch_test_macros.hpp"
+#include "scalatrix/tuning_table.hpp"
+#include "scalatrix/mos.hpp"
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace scalatrix;
+
+TEST_CASE("Tuning table layout and publishing", "[tuning_table]") {
+    TuningTable table(16, 44100.0);
+    REQUIRE(table.size() == 16);
+    REQUIRE(table.byteSize() == 16 + 2 * 16 * 8);
+    REQUIRE((reinterpret_cast<uintptr_t>(table.data()) % 8) == 0);
+    REQUIRE(table.sequence() == 0);
+
+    uint32_t n_keys;
+    double sample_rate;
+    std::memcpy(&n_keys, table.data() + 4, 4);
+    std::memcpy(&sample_rate, table.data() + 8, 8);
+    REQUIRE(n_keys == 16);
+    REQUIRE(sample_rate == 44100.0);
+
+    SECTION("Scales fill keys in node order") {
+        MOS mos = MOS::fromParams(5, 2, 1, 1.0, 0.585);
+        Scale scale = mos.generateScaleFromMOS(261.6, 12, 4);
+        table.publish(scale);
+        REQUIRE(table.sequence() == 2);
+
+        std::vector<double> freqs(16), incs(16);
+        REQUIRE(table.tryRead(freqs.data(), incs.data()));
+        for (size_t i = 0; i < 12; ++i) {
+            REQUIRE(freqs[i] == scale.getNodes()[i].pitch);
+            REQUIRE(incs[i] == freqs[i] * (1.0 / 44100.0));
+        }
+        REQUIRE(freqs[12] == 0.0);
+        REQUIRE(incs[15] == 0.0);
+
+        // the block holds the same values at the documented offsets
+        double stored;
+        std::memcpy(&stored, table.data() + 16 + 3 * 8, 8);
+        REQUIRE(stored == freqs[3]);
+        std::memcpy(&stored, table.data() + 16 + (16 + 3) * 8, 8);
+        REQUIRE(stored == incs[3]);
+    }
+
+    SECTION("Sample rate changes recompute the increments") {
+        std::vector<double> freqs(16, 440.0);
+        table.publish(freqs.data(), freqs.size());
+        table.setSampleRate(48000.0);
+        REQUIRE(table.sampleRate() == 48000.0);
+        REQUIRE(table.sequence() == 4);
+        std::vector<double> incs(16);
+        table.read(nullptr, incs.data());
+        REQUIRE(incs[0] == 440.0 * (1.0 / 48000.0));
+    }
+}
+
+TEST_CASE("Tuning table readers never see a torn table", "[tuning_table]") {
+    const size_t n_keys = 128;
+    TuningTable table(n_keys, 48000.0);
+    std::atomic<bool> done(false);
+    std::atomic<size_t> torn(0), snapshots(0);
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&]() {
+            std::vector<double> freqs(n_keys), incs(n_keys);
+            while (!done.load()) {
+                if (!table.tryRead(freqs.data(), incs.data())) continue;
+                // every publish writes one value to all keys
+                for (size_t i = 1; i < n_keys; ++i) {
+                    if (freqs[i] != freqs[0] || incs[i] != incs[0]) {
+                        torn++;
+                        break;
+                    }
+                }
+                snapshots++;
+            }
+        });
+    }
+
+    std::vector<double> freqs(n_keys);
+    for (int round = 1; round <= 20000; ++round) {
+        std::fill(freqs.begin(), freqs.end(), 100.0 + round);
+        table.publish(freqs.data(), freqs.size());
+    }
+    done = true;
+    for (auto& t : readers) t.join();
+
+    REQUIRE(torn == 0);
+    REQUIRE(snapshots > 0);
+    REQUIRE(table.sequence() == 40000);
+}